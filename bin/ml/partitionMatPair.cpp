@@ -0,0 +1,52 @@
+#include <iostream>
+
+#include "oceancv/util/cli_args.h"
+#include "oceancv/util/file_system.h"
+
+#include "oceancv/ml/mat_pair_partition.h"
+
+/**
+ * Partitions a binary MatPair file (.ocvmp) by the label in one output column, without
+ * loading it into memory. Writes either one file with the rows grouped by label or one
+ * file per label. See command line arguments for details on how to parameterize.
+ */
+int main(int argc, char** argv) {
+
+	// Read command line arguments
+	ocv::cli_args args = ocv::cli_args(argc,argv,{
+			{"i","Input MatPair file (.ocvmp, float input vectors, int output vectors)"},
+			{"o","Output file, or the output prefix in combination with --split"},
+			{"c","Output column that holds the label","0"},
+			{"m","Memory limit of the row buffers in MB","256"},
+			{"split","Write one file per label to <o><label>.ocvmp","false"}
+		 });
+
+	ocv::forceFileExists(args.s("i"));
+
+	size_t max_bytes = (size_t) args.i("m") << 20;
+
+	if(args.b("split")) {
+
+		std::vector<int> labels;
+		if(!ocv::MatPairPartition<float>::partitionToFiles(args.s("i"), args.s("o"), labels, args.i("c"), max_bytes)) {
+			std::cout << "Could not partition " << args.s("i") << std::endl;
+			return 1;
+		}
+		for(int label : labels)
+			std::cout << label << " " << ocv::MatPairPartition<float>::labelPath(args.s("o"), label) << std::endl;
+
+	} else {
+
+		std::vector<std::pair<int,cv::Range>> segments;
+		if(!ocv::MatPairPartition<float>::partition(args.s("i"), args.s("o"), segments, args.i("c"), max_bytes)) {
+			std::cout << "Could not partition " << args.s("i") << std::endl;
+			return 1;
+		}
+		for(auto& s : segments)
+			std::cout << s.first << " " << s.second.start << " " << s.second.end << std::endl;
+
+	}
+
+	return 0;
+
+}
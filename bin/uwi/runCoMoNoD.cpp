@@ -6,6 +6,7 @@
 #include "oceancv/util/load_remote_image.h"
 
 #include "oceancv/uwi/comonod.h"
+#include "oceancv/ml/streaming_aggregation.h"
 
 using namespace std;
 
@@ -150,7 +151,8 @@ int main(int argc, char** argv) {
 	// Compute median image area if it has not been set on the command line
 	if(target_area < 0) {
 
-		vector<float> tmp_areas;
+		// Exact for up to 1000 images, a quantile sketch beyond
+		ocv::StreamingAggregation<float> tmp_areas(1000);
 		for(vector<string> input_file : input_image_files) {
 
 			file_name = input_file[0].substr(input_file[0].find_last_of('/')+1);
@@ -173,18 +175,17 @@ int main(int argc, char** argv) {
 			//if(checkConditionWithMessage(areas[file_name] > 10,""))
 			//	continue;
 
-			tmp_areas.push_back(areas[file_name]);//area_factor * altitudes[file_name] * altitudes[file_name]);
+			tmp_areas.add(areas[file_name]);//area_factor * altitudes[file_name] * altitudes[file_name]);
 
 		}
 
-		if(tmp_areas.size() == 0) {
+		if(tmp_areas.count() == 0) {
 			cout << "No files found while computing the median image area." << endl;
 			exit(0);
 		}
 
 		// Pick median value of all areas
-		sort(tmp_areas.begin(),tmp_areas.end());
-		target_area = tmp_areas[0.5*tmp_areas.size()];
+		target_area = tmp_areas.median();
 
 		cout << "Computed median image area as: " << target_area << " m^2" << endl;
 
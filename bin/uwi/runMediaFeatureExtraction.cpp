@@ -16,6 +16,7 @@
 #include "oceancv/ml/feature_descriptor.h"
 #include "oceancv/ml/color_descriptors.h"
 #include "oceancv/ml/mpeg7_descriptors.h"
+#include "oceancv/ml/image_context.h"
 #include "oceancv/ml/metric.h"
 
 using namespace std;
@@ -47,7 +48,7 @@ int main(int argc, char** argv) {
 
 
 	std::string file_path, file_name, file_type, dst_folder;
-	cv::Mat img, tile, gray;
+	cv::Mat img, tile;
 	cv::cuda::GpuMat c_img, c_tmp, c_gray, c_row;
 	cv::Scalar mean;
 	double entropy;
@@ -75,7 +76,6 @@ int main(int argc, char** argv) {
 
 	// TODO Prepare extractors
 	std::map<std::string,ocv::FeatureDescriptor<float>*> descriptors;
-	std::vector<std::string> desc_gray = {"HaralickTextureDescriptor","HomogeneousTextureDescriptor"};
 	cv::FileStorage det_file;
 
 	if(args.s("f") == "all") {
@@ -199,20 +199,15 @@ std::cout << "[MeFex] Writing descriptor setup to protocol file" << std::endl;
 			det_file << "entropy" << entropy;
 			det_file << "mean-color-RGB" << "[" << mean[2] << mean[1] << mean[0] << "]";
 
-			if(args.f("r") < 1) {
+			if(args.f("r") < 1)
 				c_img.download(img);
-				c_gray.download(gray);
-			} else {
-				cv::cvtColor(img,gray,cv::COLOR_BGR2GRAY);
-			}
 
-			// Apply complex extractors: color histogram, MPEG7, entropy in tiles
+			// Apply complex extractors: color histogram, MPEG7, entropy in tiles. The
+			// context computes the gray image, channels and MPEG7 frame once for all of them.
+			ocv::ImageContext ctx(img);
 			for(auto desc : descriptors) {
 				vec = cv::Mat_<float>(1,desc.second->size());
-				if(std::find(desc_gray.begin(),desc_gray.end(),desc.first) == desc_gray.end())
-					desc.second->extract(img,vec);
-				else
-					desc.second->extract(gray,vec);
+				desc.second->extractContext(ctx,vec);
 				det_file << desc.first << "[";
 				for(int j = 0; j < vec.cols; j++)
 					det_file << vec(0,j);
@@ -8,8 +8,10 @@
 #include "oceancv/cudaimg/fspice_normalization.h"
 
 #include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/mat_pair_file.h"
+#include "oceancv/ml/mat_pair_builder.h"
 
-#include "MPEG7FexLib/Feature.h"
+#include "oceancv/ml/mpeg7_descriptors.h"
 
 using namespace std;
 
@@ -134,15 +136,17 @@ int main(int argc, char** argv) {
 	//mali::MetaMat<float> features;
 	//mali::Vector<float> vec(vec_size),out(3);
 
-	vector<cv::Mat_<float>> inputs, outputs;
-
 	cv::Mat_<float> vec(1,vec_size);
 	cv::Mat_<float> out(1,3);
 
+	// Collects the feature rows of all tiles
+	ocv::MatPairBuilder<float,float> features(vec_size,3,1);
+
 
 
-	Frame* mp7_frame;
-	XM::ColorStructureDescriptor* csd;
+	ocv::ColorStructureDescriptor<float> csd(vec_size);
+	vector<cv::Mat> tiles;
+	cv::Mat_<float> vecs;
 	//XM::DominantColorDescriptor* dcd;
 	//XM::DOMCOL* domcol;
 
@@ -257,6 +261,8 @@ int main(int argc, char** argv) {
 
 
 
+			// Collect the tiles of this frame
+			tiles.clear();
 			for(int tx = 0; tx < tiles_x; tx++) {
 				for(int ty = 0; ty < tiles_y; ty++) {
 
@@ -269,31 +275,28 @@ int main(int argc, char** argv) {
 					// Scale to unit size by LP measurement
 					if(args.i("scale") > 0) {
 						cv::resize(cut,cut_scaled,cv::Size(), scale_fac, scale_fac, cv::INTER_CUBIC);
-						mp7_frame = new Frame(cut_scaled);
-
-						//cout << args.f("scale") << " " << area << " " << scale_fac << cut_scaled.size() << endl;
-						//exit(0);
-
+						tiles.push_back(cut_scaled.clone());
 					} else {
-						mp7_frame = new Frame(cut);
+						tiles.push_back(cut);
 					}
 
-					//vec = mali::Vector<float>(vec_size,0);
-					csd = Feature::getColorStructureD(mp7_frame, 32);
-					for(size_t i = 0; i < csd->GetSize(); i++) {
-						vec(i) = (int) csd->GetElement(i);
-					}
+				}
+			}
+
+			// Describe all tiles at once, one MPEG7 frame per thread
+			vecs = cv::Mat_<float>();
+			csd.extractBatch(tiles,vecs);
 
-					delete mp7_frame;
-					delete csd;
+			for(int tx = 0; tx < tiles_x; tx++) {
+				for(int ty = 0; ty < tiles_y; ty++) {
 
+					vec = vecs.row(tx * tiles_y + ty);
 
 					out(0) = seconds + skip_seconds;
 					out(1) = tx;
 					out(2) = ty;
 
-					inputs.push_back(vec);
-					outputs.push_back(out);
+					features.append(vec,out);
 
 				}
 			}
@@ -308,14 +311,26 @@ int main(int argc, char** argv) {
 
 	}
 
-	cout << endl << inputs.size() << " " << outputs.size() << endl;
+	cout << endl << features.rows() << endl;
 
 	// Write file to disk
-	if(inputs.size() > 0) {
+	if(features.rows() > 0) {
+		ocv::MatPair<float,float> mp = features.finalize();
+
+		// Row headers that share the data of mp, to keep the FileStorage format
+		vector<cv::Mat_<float>> inputs, outputs;
+		for(int r = 0; r < mp.rows(); r++) {
+			inputs.push_back(mp.i().row(r));
+			outputs.push_back(mp.o().row(r));
+		}
 		cv::FileStorage file_i(args["o"] + ".ocvmpi", cv::FileStorage::WRITE);
 		file_i << inputs;
 		cv::FileStorage file_o(args["o"] + ".ocvmpo", cv::FileStorage::WRITE);
 		file_o << outputs;
+
+		// Binary copy that can be memory mapped by ocv::MatPairFile
+		if(!ocv::MatPairFile<float,float>::write(args["o"] + ".ocvmp", mp))
+			cout << "Could not write " << args["o"] << ".ocvmp" << endl;
 	}
 
 }
@@ -0,0 +1,224 @@
+#include "oceancv/ml/approximate_cluster_indices.h"
+
+namespace ocv {
+
+	template <class T>
+	ApproximateClusterIndex<T>::ApproximateClusterIndex(const cv::Mat_<T>& features, const std::vector<int>& labels, unsigned int seed) : _features(features), _labels(labels) {
+
+		assert(_features.rows > 0 && (int) _labels.size() == _features.rows);
+
+		if(seed == 0) {
+			std::random_device rd;
+			seed = rd();
+		}
+		_rng.seed(seed);
+
+		// Group the row indices by class, classes sorted by label
+		std::map<int,int> indicator;
+		for(int l : _labels)
+			indicator[l] = 0;
+		int c = 0;
+		for(auto& ind : indicator)
+			ind.second = c++;
+		_class_rows.resize(indicator.size());
+		for(int i = 0; i < _features.rows; i++)
+			_class_rows[indicator[_labels[i]]].push_back(i);
+
+		assert(_class_rows.size() > 1);
+
+	}
+
+	template <class T>
+	IndexEstimate<T> ApproximateClusterIndex<T>::estimate(ocv::CI_TYPES ci_type, T tolerance, double confidence, size_t initial_samples, size_t repetitions, size_t max_samples) {
+		return _refine(ci_type, nullptr, tolerance, confidence, initial_samples, repetitions, max_samples);
+	}
+
+	template <class T>
+	IndexEstimate<T> ApproximateClusterIndex<T>::silhouette(const ocv::Metric<T>* metric, T tolerance, double confidence, size_t initial_samples, size_t repetitions, size_t max_samples) {
+		return _refine(-1, metric, tolerance, confidence, initial_samples, repetitions, max_samples);
+	}
+
+	template <class T>
+	IndexEstimate<T> ApproximateClusterIndex<T>::_refine(int index_type, const ocv::Metric<T>* metric, T tolerance, double confidence, size_t initial_samples, size_t repetitions, size_t max_samples) {
+
+		assert(confidence > 0 && confidence < 1);
+		assert(repetitions > 1 && max_samples > 0);
+
+		// Two-sided normal quantile of the confidence level, found by bisection
+		double lo = 0, hi = 10, z;
+		while(hi - lo > 1e-6) {
+			z = 0.5 * (lo + hi);
+			if(std::erf(z / std::sqrt(2.0)) < confidence)
+				lo = z;
+			else
+				hi = z;
+		}
+		z = 0.5 * (lo + hi);
+
+		IndexEstimate<T> ret;
+		ret.samples = 0;
+		size_t n = std::max(initial_samples, 2 * _class_rows.size());
+		std::vector<double> values(repetitions);
+
+		while(true) {
+
+			n = std::min(n, std::max(max_samples, 2 * _class_rows.size()));
+			if(n >= (size_t) _features.rows)
+				break;
+
+			for(size_t r = 0; r < repetitions; r++) {
+				_drawSample(n);
+				values[r] = _evaluateSample(index_type, metric);
+				ret.samples += _sample_labels.size();
+			}
+
+			double mean = 0, var = 0;
+			for(double v : values)
+				mean += v;
+			mean /= repetitions;
+			for(double v : values)
+				var += (v - mean) * (v - mean);
+			var /= repetitions - 1;
+
+			double half_width = z * std::sqrt(var / repetitions);
+			ret.value = static_cast<T>(mean);
+			ret.lower = static_cast<T>(mean - half_width);
+			ret.upper = static_cast<T>(mean + half_width);
+
+			// Converged, or the budget does not allow a larger sample
+			if(half_width <= tolerance * std::max(1.0, std::abs(mean)) || n >= max_samples)
+				return ret;
+
+			n *= 2;
+
+		}
+
+		// The sample would contain all rows, thus compute the exact value
+		_sample_mat = _features;
+		_sample_labels = _labels;
+		ret.value = ret.lower = ret.upper = _evaluateSample(index_type, metric);
+		ret.samples += _labels.size();
+		return ret;
+
+	}
+
+	template <class T>
+	void ApproximateClusterIndex<T>::_drawSample(size_t n) {
+
+		// Number of rows per class, at least two to have a spread within each class
+		std::vector<size_t> class_n(_class_rows.size());
+		size_t total = 0;
+		for(size_t c = 0; c < _class_rows.size(); c++) {
+			size_t rows = _class_rows[c].size();
+			class_n[c] = std::min(rows, std::max((size_t) 2, (size_t) std::round((double) n * rows / _features.rows)));
+			total += class_n[c];
+		}
+
+		_sample_mat.create(total, _features.cols);
+		_sample_labels.resize(total);
+
+		// Partial Fisher-Yates shuffle of each class, the first class_n[c] rows are the sample
+		size_t idx = 0;
+		for(size_t c = 0; c < _class_rows.size(); c++) {
+			std::vector<int>& rows = _class_rows[c];
+			for(size_t i = 0; i < class_n[c]; i++) {
+				std::uniform_int_distribution<size_t> uni(i, rows.size() - 1);
+				std::swap(rows[i], rows[uni(_rng)]);
+				_features.row(rows[i]).copyTo(_sample_mat.row(idx));
+				_sample_labels[idx] = c;
+				idx++;
+			}
+		}
+
+	}
+
+	template <class T>
+	T ApproximateClusterIndex<T>::_evaluateSample(int index_type, const ocv::Metric<T>* metric) {
+
+		if(index_type < 0)
+			return silhouette(_sample_mat, _sample_labels, metric);
+
+		ocv::ClusterIndexEngine<T> engine(_sample_mat);
+		engine.evaluate(_sample_labels);
+		T ret = engine.index((ocv::CI_TYPES) index_type);
+
+		// Calinski-Harabasz contains the number of rows, scale it to the full data
+		if(index_type == ocv::CI_TYPES::CALINSKI_HARABASZ) {
+			double k = engine.classCount();
+			ret *= static_cast<T>((_features.rows - k) / (_sample_mat.rows - k));
+		}
+		return ret;
+
+	}
+
+	template <class T>
+	T ApproximateClusterIndex<T>::silhouette(const cv::Mat_<T>& features, const std::vector<int>& labels, const ocv::Metric<T>* metric) {
+
+		assert((int) labels.size() == features.rows);
+
+		// Map labels to class indices
+		std::map<int,int> indicator;
+		for(int l : labels)
+			indicator[l] = 0;
+		int k = 0;
+		for(auto& ind : indicator)
+			ind.second = k++;
+		std::vector<int> cls(labels.size());
+		std::vector<size_t> counts(k, 0);
+		for(size_t i = 0; i < labels.size(); i++) {
+			cls[i] = indicator[labels[i]];
+			counts[cls[i]]++;
+		}
+		if(k < 2)
+			return 0;
+
+		const int n = features.rows;
+		const int stripes = std::max(1, std::min(cv::getNumThreads(), n));
+		std::vector<double> part(stripes, 0.0);
+
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			// Summed distances from one row to each class, reused for all rows of the stripe
+			std::vector<double> dist(k);
+			for(int s = range.start; s < range.end; s++) {
+				for(int i = (int) ((size_t) s * n / stripes); i < (int) ((size_t) (s + 1) * n / stripes); i++) {
+					std::fill(dist.begin(), dist.end(), 0.0);
+					const T* x = features.template ptr<T>(i);
+					for(int j = 0; j < n; j++) {
+						if(j == i)
+							continue;
+						if(metric != nullptr) {
+							dist[cls[j]] += metric->distance(features.row(i), features.row(j));
+						} else {
+							const T* y = features.template ptr<T>(j);
+							double d = 0;
+							for(int c = 0; c < features.cols; c++)
+								d += ((double) x[c] - y[c]) * ((double) x[c] - y[c]);
+							dist[cls[j]] += std::sqrt(d);
+						}
+					}
+					// Rows that are alone in their class have a silhouette of 0
+					if(counts[cls[i]] < 2)
+						continue;
+					double a = dist[cls[i]] / (counts[cls[i]] - 1);
+					double b = std::numeric_limits<double>::max();
+					for(int c = 0; c < k; c++) {
+						if(c != cls[i])
+							b = std::min(b, dist[c] / counts[c]);
+					}
+					if(std::max(a, b) > 0)
+						part[s] += (b - a) / std::max(a, b);
+				}
+			}
+		});
+
+		double ret = 0;
+		for(double p : part)
+			ret += p;
+		return static_cast<T>(ret / n);
+
+	}
+
+	template class ApproximateClusterIndex<float>;
+	template class ApproximateClusterIndex<double>;
+
+}
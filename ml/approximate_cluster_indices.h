@@ -0,0 +1,97 @@
+#pragma once
+
+#include <map>
+#include <limits>
+#include <random>
+
+#include "oceancv/ml/cluster_index_engine.h"
+
+namespace ocv {
+
+	/**
+	 * Result of an approximate cluster index computation: the estimate, the bounds of its
+	 * confidence interval and the total number of rows that were evaluated over all samples.
+	 */
+	template <class T>
+	struct IndexEstimate {
+		T value;
+		T lower;
+		T upper;
+		size_t samples;
+	};
+
+	/**
+	 * Estimates the CI_TYPES cluster indices and the silhouette index of a labeling from
+	 * stratified random samples (each class is sampled in proportion to its size).
+	 * Several independent samples are evaluated and the spread of their results gives
+	 * the confidence interval. The sample size is doubled until the half width of that
+	 * interval falls below the requested tolerance or the sample reaches max_samples rows,
+	 * then the current interval is returned. Only if the sample would cover all rows
+	 * within that budget, the exact value is computed instead.
+	 * The tolerance is relative to the magnitude of the estimate, but at least one, so
+	 * estimates close to zero (e.g. a silhouette around 0) converge at an absolute half
+	 * width of tolerance.
+	 */
+	template <class T>
+	class ApproximateClusterIndex {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param features the feature vectors, one per row. Data is not copied.
+		 * @param labels the class label of each row
+		 * @param seed seed for the random sampling. If zero, a random seed is used.
+		 */
+		ApproximateClusterIndex(const cv::Mat_<T>& features, const std::vector<int>& labels, unsigned int seed = 0);
+
+		/**
+		 * Estimates one of the cluster indices of ci.
+		 * @param ci_type the index to estimate
+		 * @param tolerance the maximum half width of the confidence interval, relative to max(1, |estimate|)
+		 * @param confidence the confidence level of the interval
+		 * @param initial_samples number of rows in the first sample
+		 * @param repetitions number of independent samples per refinement step
+		 * @param max_samples maximum number of rows in a sample
+		 */
+		IndexEstimate<T> estimate(ocv::CI_TYPES ci_type, T tolerance = 0.05, double confidence = 0.95, size_t initial_samples = 1000, size_t repetitions = 8, size_t max_samples = 16000);
+
+		/**
+		 * Estimates the mean silhouette of all rows. The exact silhouette needs all pairwise
+		 * distances, on a sample it costs O(samples^2) instead.
+		 * @param metric the distance to use. If not given, the euclidean distance is used.
+		 * Other parameters as for estimate()
+		 */
+		IndexEstimate<T> silhouette(const ocv::Metric<T>* metric = nullptr, T tolerance = 0.05, double confidence = 0.95, size_t initial_samples = 1000, size_t repetitions = 8, size_t max_samples = 16000);
+
+		/**
+		 * Computes the mean silhouette of the given rows with their labels exactly.
+		 */
+		static T silhouette(const cv::Mat_<T>& features, const std::vector<int>& labels, const ocv::Metric<T>* metric = nullptr);
+
+	private:
+
+		// Draws a stratified sample of about n rows into _sample_mat and _sample_labels
+		void _drawSample(size_t n);
+
+		// Evaluates the index on the current sample
+		T _evaluateSample(int index_type, const ocv::Metric<T>* metric);
+
+		// Common refinement loop of estimate() and silhouette(), index_type -1 is the silhouette
+		IndexEstimate<T> _refine(int index_type, const ocv::Metric<T>* metric, T tolerance, double confidence, size_t initial_samples, size_t repetitions, size_t max_samples);
+
+		// Feature data and labels
+		cv::Mat_<T> _features;
+		std::vector<int> _labels;
+
+		// Row indices of each class, partially shuffled on every sample
+		std::vector<std::vector<int>> _class_rows;
+
+		// Current sample
+		cv::Mat_<T> _sample_mat;
+		std::vector<int> _sample_labels;
+
+		std::mt19937 _rng;
+
+	};
+
+}
@@ -0,0 +1,126 @@
+#include "oceancv/ml/bit_genome.h"
+
+#include <cassert>
+
+namespace ocv {
+
+	BitGenome::BitGenome(size_t size) : _words((size + 63) / 64, 0), _size(size) {}
+
+	BitGenome::BitGenome(const std::vector<int>& genes) : BitGenome(genes.size()) {
+		for(size_t i = 0; i < genes.size(); i++)
+			if(genes[i] != 0)
+				_words[i / 64] |= uint64_t(1) << (i % 64);
+	}
+
+	std::vector<int> BitGenome::toVector() const {
+		std::vector<int> genes;
+		toVector(genes);
+		return genes;
+	}
+
+	void BitGenome::toVector(std::vector<int>& genes) const {
+		genes.resize(_size);
+		for(size_t i = 0; i < _size; i++)
+			genes[i] = (_words[i / 64] >> (i % 64)) & 1;
+	}
+
+	bool BitGenome::get(size_t i) const {
+		assert(i < _size);
+		return (_words[i / 64] >> (i % 64)) & 1;
+	}
+
+	void BitGenome::set(size_t i, bool value) {
+		assert(i < _size);
+		if(value)
+			_words[i / 64] |= uint64_t(1) << (i % 64);
+		else
+			_words[i / 64] &= ~(uint64_t(1) << (i % 64));
+	}
+
+	void BitGenome::flip(size_t i) {
+		assert(i < _size);
+		_words[i / 64] ^= uint64_t(1) << (i % 64);
+	}
+
+	void BitGenome::randomize(std::mt19937_64& rng) {
+		for(uint64_t& w : _words)
+			w = rng();
+		_clearTail();
+	}
+
+	void BitGenome::crossover(const BitGenome& partner, std::mt19937_64& rng) {
+		assert(partner._size == _size);
+		for(size_t w = 0; w < _words.size(); w++) {
+			uint64_t mask = rng();
+			_words[w] = (_words[w] & ~mask) | (partner._words[w] & mask);
+		}
+	}
+
+	void BitGenome::crossover(const BitGenome& partner, const std::vector<uint64_t>& mask) {
+		assert(partner._size == _size && mask.size() == _words.size());
+		for(size_t w = 0; w < _words.size(); w++)
+			_words[w] = (_words[w] & ~mask[w]) | (partner._words[w] & mask[w]);
+	}
+
+	void BitGenome::mutate(double probability, std::mt19937_64& rng) {
+		if(probability <= 0)
+			return;
+		if(probability >= 1) {
+			for(uint64_t& w : _words)
+				w = ~w;
+			_clearTail();
+			return;
+		}
+		// Number of unchanged genes before the next flip
+		std::geometric_distribution<size_t> skip(probability);
+		for(size_t i = skip(rng); i < _size; i += skip(rng) + 1)
+			flip(i);
+	}
+
+	size_t BitGenome::count() const {
+		size_t ret = 0;
+		for(uint64_t w : _words)
+			ret += __builtin_popcountll(w);
+		return ret;
+	}
+
+	size_t BitGenome::hamming(const BitGenome& other) const {
+		assert(other._size == _size);
+		size_t ret = 0;
+		for(size_t w = 0; w < _words.size(); w++)
+			ret += __builtin_popcountll(_words[w] ^ other._words[w]);
+		return ret;
+	}
+
+	bool BitGenome::operator==(const BitGenome& other) const {
+		return _size == other._size && _words == other._words;
+	}
+
+	bool BitGenome::operator!=(const BitGenome& other) const {
+		return !(*this == other);
+	}
+
+	size_t BitGenome::hash() const {
+		// Multiplicative mixing of the words, seeded with the size
+		uint64_t hash = 14695981039346656037ull ^ _size;
+		for(uint64_t w : _words) {
+			hash ^= w + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	size_t BitGenome::size() const {
+		return _size;
+	}
+
+	const std::vector<uint64_t>& BitGenome::words() const {
+		return _words;
+	}
+
+	void BitGenome::_clearTail() {
+		if(_size % 64 != 0)
+			_words.back() &= (uint64_t(1) << (_size % 64)) - 1;
+	}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+namespace ocv {
+
+/**
+ * A binary individual of the GeneticAlgorithm, packed into 64 bit words. Crossover
+ * combines whole words with random masks and mutation jumps from one flipped gene to
+ * the next, so the cost of both depends on the number of words and flips instead of
+ * the number of genes.
+ * The bits of the last word beyond size() are always zero, so words can be compared,
+ * hashed and counted directly.
+ */
+class BitGenome {
+
+public:
+
+	/**
+	 * Constructor, all genes are zero
+	 */
+	BitGenome(size_t size = 0);
+
+	/**
+	 * Packs a vector of genes, non-zero entries are set
+	 */
+	explicit BitGenome(const std::vector<int>& genes);
+
+	/**
+	 * Unpacks to one int (0 or 1) per gene
+	 */
+	std::vector<int> toVector() const;
+	void toVector(std::vector<int>& genes) const;
+
+	// Single gene access
+	bool get(size_t i) const;
+	void set(size_t i, bool value);
+	void flip(size_t i);
+
+	/**
+	 * Sets every gene with probability 1/2
+	 */
+	void randomize(std::mt19937_64& rng);
+
+	/**
+	 * Uniform crossover: takes each gene from the partner with probability 1/2
+	 */
+	void crossover(const BitGenome& partner, std::mt19937_64& rng);
+
+	/**
+	 * Takes the genes from the partner where the mask (one bit per gene) is set
+	 */
+	void crossover(const BitGenome& partner, const std::vector<uint64_t>& mask);
+
+	/**
+	 * Flips each gene with the given probability. The distance to the next flipped gene
+	 * is drawn from a geometric distribution, so only the flips cost random numbers.
+	 */
+	void mutate(double probability, std::mt19937_64& rng);
+
+	/**
+	 * Number of set genes
+	 */
+	size_t count() const;
+
+	/**
+	 * Number of genes that differ from the other genome
+	 */
+	size_t hamming(const BitGenome& other) const;
+
+	bool operator==(const BitGenome& other) const;
+	bool operator!=(const BitGenome& other) const;
+
+	// Hash of the words, e.g. for unordered containers
+	size_t hash() const;
+
+	// Getter
+	size_t size() const;
+	const std::vector<uint64_t>& words() const;
+
+private:
+
+	// Clears the unused bits of the last word
+	void _clearTail();
+
+	std::vector<uint64_t> _words;
+	size_t _size;
+
+};
+
+}
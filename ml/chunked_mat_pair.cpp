@@ -0,0 +1,531 @@
+#include "oceancv/ml/chunked_mat_pair.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef OCV_WITH_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef OCV_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ocv {
+
+	namespace {
+
+		const char CHUNKED_MATPAIR_MAGIC[8] = {'O','C','V','M','P','Z','I','P'};
+		const uint32_t CHUNKED_MATPAIR_VERSION = 1;
+		const uint32_t CHUNKED_MATPAIR_SHUFFLE = 1;
+		const uint64_t CHUNK_I_RAW = 1;
+		const uint64_t CHUNK_O_RAW = 2;
+		const int ZSTD_LEVEL = 3;
+
+		// Groups byte b of all n values: dst[b * n + k] = src[k * size + b]
+		void shuffleBytes(const char* src, char* dst, size_t n, size_t size) {
+			for(size_t b = 0; b < size; b++) {
+				char* d = dst + b * n;
+				const char* s = src + b;
+				for(size_t k = 0; k < n; k++)
+					d[k] = s[k * size];
+			}
+		}
+
+		void unshuffleBytes(const char* src, char* dst, size_t n, size_t size) {
+			for(size_t b = 0; b < size; b++) {
+				const char* s = src + b * n;
+				char* d = dst + b;
+				for(size_t k = 0; k < n; k++)
+					d[k * size] = s[k];
+			}
+		}
+
+		// PackBits run length coding: a control byte c < 128 is followed by c + 1 literal
+		// bytes, c >= 128 by one byte that is repeated c - 126 times
+		void rleEncode(const char* src, size_t bytes, std::vector<char>& dst) {
+			dst.clear();
+			dst.reserve(bytes + bytes / 128 + 1);
+			size_t i = 0;
+			while(i < bytes) {
+				size_t run = 1;
+				while(i + run < bytes && run < 129 && src[i + run] == src[i])
+					run++;
+				if(run >= 2) {
+					dst.push_back(static_cast<char>(run + 126));
+					dst.push_back(src[i]);
+					i += run;
+				} else {
+					// Collect literals until the next run of at least two bytes
+					size_t begin = i, len = 0;
+					do {
+						i++;
+						len++;
+					} while(i < bytes && len < 128 && !(i + 1 < bytes && src[i + 1] == src[i]));
+					dst.push_back(static_cast<char>(len - 1));
+					dst.insert(dst.end(), src + begin, src + begin + len);
+				}
+			}
+		}
+
+		bool rleDecode(const char* src, size_t bytes, char* dst, size_t dst_bytes) {
+			size_t i = 0, o = 0;
+			while(i < bytes) {
+				unsigned char c = src[i++];
+				if(c < 128) {
+					size_t len = c + 1;
+					if(i + len > bytes || o + len > dst_bytes)
+						return false;
+					std::memcpy(dst + o, src + i, len);
+					i += len;
+					o += len;
+				} else {
+					size_t len = c - 126;
+					if(i >= bytes || o + len > dst_bytes)
+						return false;
+					std::memset(dst + o, src[i++], len);
+					o += len;
+				}
+			}
+			return o == dst_bytes;
+		}
+
+		// Compresses a block of values, returns false if it is better stored uncompressed
+		bool encodeBlock(const char* src, size_t bytes, size_t size, int codec, bool shuffle, std::vector<char>& dst) {
+
+			if(codec == CODEC_NONE || bytes == 0)
+				return false;
+
+			std::vector<char> shuffled;
+			if(shuffle && size > 1) {
+				shuffled.resize(bytes);
+				shuffleBytes(src, shuffled.data(), bytes / size, size);
+				src = shuffled.data();
+			}
+
+			switch(codec) {
+				case CODEC_RLE:
+					rleEncode(src, bytes, dst);
+				break;
+#ifdef OCV_WITH_LZ4
+				case CODEC_LZ4: {
+					dst.resize(LZ4_compressBound(bytes));
+					int n = LZ4_compress_default(src, dst.data(), bytes, dst.size());
+					if(n <= 0)
+						return false;
+					dst.resize(n);
+				}
+				break;
+#endif
+#ifdef OCV_WITH_ZSTD
+				case CODEC_ZSTD: {
+					dst.resize(ZSTD_compressBound(bytes));
+					size_t n = ZSTD_compress(dst.data(), dst.size(), src, bytes, ZSTD_LEVEL);
+					if(ZSTD_isError(n))
+						return false;
+					dst.resize(n);
+				}
+				break;
+#endif
+				default:
+					return false;
+			}
+
+			return dst.size() < bytes;
+
+		}
+
+		bool decodeBlock(const char* src, size_t src_bytes, char* dst, size_t bytes, size_t size, int codec, bool shuffle) {
+
+			std::vector<char> shuffled;
+			char* out = dst;
+			if(shuffle && size > 1) {
+				shuffled.resize(bytes);
+				out = shuffled.data();
+			}
+
+			bool ok = false;
+			switch(codec) {
+				case CODEC_RLE:
+					ok = rleDecode(src, src_bytes, out, bytes);
+				break;
+#ifdef OCV_WITH_LZ4
+				case CODEC_LZ4:
+					ok = LZ4_decompress_safe(src, out, src_bytes, bytes) == (int) bytes;
+				break;
+#endif
+#ifdef OCV_WITH_ZSTD
+				case CODEC_ZSTD:
+					ok = ZSTD_decompress(out, bytes, src, src_bytes) == bytes;
+				break;
+#endif
+				default:
+				break;
+			}
+
+			if(ok && out != dst)
+				unshuffleBytes(out, dst, bytes / size, size);
+			return ok;
+
+		}
+
+	}
+
+	bool codecAvailable(CODEC_TYPES codec) {
+		switch(codec) {
+			case CODEC_NONE:
+			case CODEC_RLE:
+				return true;
+#ifdef OCV_WITH_LZ4
+			case CODEC_LZ4:
+				return true;
+#endif
+#ifdef OCV_WITH_ZSTD
+			case CODEC_ZSTD:
+				return true;
+#endif
+			default:
+				return false;
+		}
+	}
+
+	template <class T1, class T2>
+	ChunkedMatPairWriter<T1,T2>::ChunkedMatPairWriter(const std::string& path, int i_cols, int o_cols, CODEC_TYPES codec, int chunk_rows, bool shuffle) : _offset(0), _ok(true), _buffered(0) {
+
+		assert(codecAvailable(codec) && chunk_rows > 0);
+
+		std::memset(&_header, 0, sizeof(_header));
+		std::memcpy(_header.magic, CHUNKED_MATPAIR_MAGIC, sizeof(_header.magic));
+		_header.version = CHUNKED_MATPAIR_VERSION;
+		_header.i_depth = cv::DataType<T1>::depth;
+		_header.o_depth = cv::DataType<T2>::depth;
+		_header.codec = codec;
+		_header.flags = shuffle ? CHUNKED_MATPAIR_SHUFFLE : 0;
+		_header.chunk_rows = chunk_rows;
+		_header.i_cols = i_cols;
+		_header.o_cols = o_cols;
+
+		const int buffer_rows = chunk_rows * std::max(1, cv::getNumThreads());
+		_buf_i.create(buffer_rows, i_cols);
+		_buf_o.create(buffer_rows, o_cols);
+
+		_file = std::fopen(path.c_str(), "wb");
+		if(_file == nullptr) {
+			_ok = false;
+			return;
+		}
+
+		// The header is written again with the final counts on close()
+		_ok = std::fwrite(&_header, sizeof(_header), 1, _file) == 1;
+		_offset = sizeof(_header);
+
+	}
+
+	template <class T1, class T2>
+	ChunkedMatPairWriter<T1,T2>::~ChunkedMatPairWriter() {
+		close();
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairWriter<T1,T2>::append(const ocv::MatPair<T1,T2>& mp) {
+		return append(mp.i(), mp.o());
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairWriter<T1,T2>::append(const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o) {
+
+		assert(isOpen());
+		assert(mat_i.rows == mat_o.rows && mat_i.cols == (int) _header.i_cols && mat_o.cols == (int) _header.o_cols);
+
+		for(int r = 0; r < mat_i.rows; r++) {
+			std::copy(mat_i.template ptr<T1>(r), mat_i.template ptr<T1>(r) + mat_i.cols, _buf_i.template ptr<T1>(_buffered));
+			std::copy(mat_o.template ptr<T2>(r), mat_o.template ptr<T2>(r) + mat_o.cols, _buf_o.template ptr<T2>(_buffered));
+			if(++_buffered == _buf_i.rows)
+				_flush();
+		}
+		return _ok;
+
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairWriter<T1,T2>::_flush() {
+
+		if(_buffered == 0)
+			return _ok;
+
+		const int chunk_rows = _header.chunk_rows;
+		const int chunks = (_buffered + chunk_rows - 1) / chunk_rows;
+		const bool shuffle = _header.flags & CHUNKED_MATPAIR_SHUFFLE;
+		std::vector<std::vector<char>> enc_i(chunks), enc_o(chunks);
+		std::vector<uint64_t> flags(chunks, 0);
+
+		cv::parallel_for_(cv::Range(0, chunks), [&](const cv::Range& range) {
+			for(int c = range.start; c < range.end; c++) {
+				int begin = c * chunk_rows, rows = std::min(chunk_rows, _buffered - begin);
+				const char* src_i = reinterpret_cast<const char*>(_buf_i.template ptr<T1>(begin));
+				const char* src_o = reinterpret_cast<const char*>(_buf_o.template ptr<T2>(begin));
+				size_t bytes_i = rows * _header.i_cols * sizeof(T1);
+				size_t bytes_o = rows * _header.o_cols * sizeof(T2);
+				if(!encodeBlock(src_i, bytes_i, sizeof(T1), _header.codec, shuffle, enc_i[c])) {
+					enc_i[c].assign(src_i, src_i + bytes_i);
+					flags[c] |= CHUNK_I_RAW;
+				}
+				if(!encodeBlock(src_o, bytes_o, sizeof(T2), _header.codec, shuffle, enc_o[c])) {
+					enc_o[c].assign(src_o, src_o + bytes_o);
+					flags[c] |= CHUNK_O_RAW;
+				}
+			}
+		});
+
+		// Write in chunk order
+		for(int c = 0; c < chunks && _ok; c++) {
+			ocv::ChunkedMatPairEntry entry = {_offset, enc_i[c].size(), enc_o[c].size(), flags[c]};
+			_ok &= std::fwrite(enc_i[c].data(), 1, enc_i[c].size(), _file) == enc_i[c].size();
+			_ok &= std::fwrite(enc_o[c].data(), 1, enc_o[c].size(), _file) == enc_o[c].size();
+			_offset += entry.i_bytes + entry.o_bytes;
+			_table.push_back(entry);
+		}
+
+		_header.rows += _buffered;
+		_buffered = 0;
+		return _ok;
+
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairWriter<T1,T2>::close() {
+
+		if(_file == nullptr)
+			return _ok;
+
+		_flush();
+
+		_header.chunk_count = _table.size();
+		_header.table_offset = _offset;
+		if(!_table.empty())
+			_ok &= std::fwrite(_table.data(), sizeof(ocv::ChunkedMatPairEntry), _table.size(), _file) == _table.size();
+		_ok &= fseeko(_file, 0, SEEK_SET) == 0;
+		_ok &= std::fwrite(&_header, sizeof(_header), 1, _file) == 1;
+		_ok &= std::fclose(_file) == 0;
+		_file = nullptr;
+		return _ok;
+
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairWriter<T1,T2>::write(const std::string& path, const ocv::MatPair<T1,T2>& mp, CODEC_TYPES codec, int chunk_rows, bool shuffle) {
+		ocv::ChunkedMatPairWriter<T1,T2> writer(path, mp.iCols(), mp.oCols(), codec, chunk_rows, shuffle);
+		if(!writer.isOpen())
+			return false;
+		writer.append(mp);
+		return writer.close();
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairWriter<T1,T2>::isOpen() const {
+		return _file != nullptr;
+	}
+
+	template <class T1, class T2>
+	size_t ChunkedMatPairWriter<T1,T2>::rows() const {
+		return _header.rows + _buffered;
+	}
+
+	template <class T1, class T2>
+	ChunkedMatPairReader<T1,T2>::ChunkedMatPairReader(const std::string& path) : _fd(-1) {
+
+		_fd = open(path.c_str(), O_RDONLY);
+		if(_fd < 0)
+			return;
+
+		bool ok = pread(_fd, &_header, sizeof(_header), 0) == sizeof(_header);
+		ok = ok && std::memcmp(_header.magic, CHUNKED_MATPAIR_MAGIC, sizeof(_header.magic)) == 0 && _header.version == CHUNKED_MATPAIR_VERSION;
+		ok = ok && _header.i_depth == cv::DataType<T1>::depth && _header.o_depth == cv::DataType<T2>::depth;
+		ok = ok && codecAvailable((CODEC_TYPES) _header.codec);
+
+		// read() divides by chunk_rows and indexes the table by row / chunk_rows
+		ok = ok && _header.chunk_rows > 0;
+		ok = ok && _header.chunk_count == _header.rows / _header.chunk_rows + (_header.rows % _header.chunk_rows != 0);
+
+		// The table has to lie within the file, before it is allocated
+		struct stat st;
+		ok = ok && fstat(_fd, &st) == 0 && _header.table_offset <= (uint64_t) st.st_size;
+		ok = ok && _header.chunk_count <= ((uint64_t) st.st_size - _header.table_offset) / sizeof(ocv::ChunkedMatPairEntry);
+		if(ok) {
+			_table.resize(_header.chunk_count);
+			size_t bytes = _table.size() * sizeof(ocv::ChunkedMatPairEntry);
+			ok = bytes == 0 || pread(_fd, _table.data(), bytes, _header.table_offset) == (ssize_t) bytes;
+		}
+
+		if(!ok) {
+			_table.clear();
+			::close(_fd);
+			_fd = -1;
+		}
+
+	}
+
+	template <class T1, class T2>
+	ChunkedMatPairReader<T1,T2>::~ChunkedMatPairReader() {
+		if(_fd >= 0)
+			::close(_fd);
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairReader<T1,T2>::_decode(size_t chunk, cv::Mat_<T1>& mat_i, cv::Mat_<T2>& mat_o) const {
+
+		const ocv::ChunkedMatPairEntry& entry = _table[chunk];
+		const bool shuffle = _header.flags & CHUNKED_MATPAIR_SHUFFLE;
+		const size_t bytes_i = mat_i.rows * _header.i_cols * sizeof(T1);
+		const size_t bytes_o = mat_o.rows * _header.o_cols * sizeof(T2);
+
+		std::vector<char> buf(entry.i_bytes + entry.o_bytes);
+		if(!buf.empty() && pread(_fd, buf.data(), buf.size(), entry.offset) != (ssize_t) buf.size())
+			return false;
+
+		const char* src_i = buf.data();
+		const char* src_o = buf.data() + entry.i_bytes;
+		char* dst_i = reinterpret_cast<char*>(mat_i.data);
+		char* dst_o = reinterpret_cast<char*>(mat_o.data);
+
+		if(entry.flags & CHUNK_I_RAW) {
+			if(entry.i_bytes != bytes_i)
+				return false;
+			std::memcpy(dst_i, src_i, bytes_i);
+		} else if(!decodeBlock(src_i, entry.i_bytes, dst_i, bytes_i, sizeof(T1), _header.codec, shuffle)) {
+			return false;
+		}
+
+		if(entry.flags & CHUNK_O_RAW) {
+			if(entry.o_bytes != bytes_o)
+				return false;
+			std::memcpy(dst_o, src_o, bytes_o);
+		} else if(!decodeBlock(src_o, entry.o_bytes, dst_o, bytes_o, sizeof(T2), _header.codec, shuffle)) {
+			return false;
+		}
+
+		return true;
+
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairReader<T1,T2>::read(size_t begin, size_t end, ocv::MatPair<T1,T2>& dst) const {
+
+		assert(isOpen() && begin <= end && end <= _header.rows);
+
+		ocv::MatPair<T1,T2> ret(end - begin, _header.i_cols, _header.o_cols);
+		if(begin == end) {
+			dst = ret;
+			return true;
+		}
+
+		const size_t chunk_rows = _header.chunk_rows;
+		const size_t first = begin / chunk_rows, last = (end - 1) / chunk_rows;
+		std::vector<int> ok(last - first + 1, 1);
+
+		cv::parallel_for_(cv::Range(0, last - first + 1), [&](const cv::Range& range) {
+			for(int k = range.start; k < range.end; k++) {
+				size_t c = first + k;
+				size_t c_begin = c * chunk_rows, c_end = std::min((size_t) _header.rows, c_begin + chunk_rows);
+				size_t from = std::max(begin, c_begin), to = std::min(end, c_end);
+
+				// Chunks that are fully covered are decoded directly into the result
+				cv::Mat_<T1> mat_i;
+				cv::Mat_<T2> mat_o;
+				bool direct = from == c_begin && to == c_end;
+				if(direct) {
+					mat_i = ret.i().rowRange(from - begin, to - begin);
+					mat_o = ret.o().rowRange(from - begin, to - begin);
+				} else {
+					mat_i.create(c_end - c_begin, _header.i_cols);
+					mat_o.create(c_end - c_begin, _header.o_cols);
+				}
+				ok[k] = _decode(c, mat_i, mat_o);
+				if(!direct) {
+					mat_i.rowRange(from - c_begin, to - c_begin).copyTo(ret.i().rowRange(from - begin, to - begin));
+					mat_o.rowRange(from - c_begin, to - c_begin).copyTo(ret.o().rowRange(from - begin, to - begin));
+				}
+			}
+		});
+
+		if(std::find(ok.begin(), ok.end(), 0) != ok.end())
+			return false;
+		dst = ret;
+		return true;
+
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairReader<T1,T2>::read(ocv::MatPair<T1,T2>& dst) const {
+		return read(0, rows(), dst);
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairReader<T1,T2>::readChunk(size_t chunk, ocv::MatPair<T1,T2>& dst) const {
+		assert(chunk < _table.size());
+		size_t begin = chunk * _header.chunk_rows;
+		return read(begin, std::min((size_t) _header.rows, begin + _header.chunk_rows), dst);
+	}
+
+	template <class T1, class T2>
+	bool ChunkedMatPairReader<T1,T2>::isOpen() const {
+		return _fd >= 0;
+	}
+
+	template <class T1, class T2>
+	size_t ChunkedMatPairReader<T1,T2>::rows() const {
+		return isOpen() ? _header.rows : 0;
+	}
+
+	template <class T1, class T2>
+	int ChunkedMatPairReader<T1,T2>::iCols() const {
+		return _header.i_cols;
+	}
+
+	template <class T1, class T2>
+	int ChunkedMatPairReader<T1,T2>::oCols() const {
+		return _header.o_cols;
+	}
+
+	template <class T1, class T2>
+	int ChunkedMatPairReader<T1,T2>::chunkRows() const {
+		return _header.chunk_rows;
+	}
+
+	template <class T1, class T2>
+	size_t ChunkedMatPairReader<T1,T2>::chunkCount() const {
+		return _table.size();
+	}
+
+	template <class T1, class T2>
+	CODEC_TYPES ChunkedMatPairReader<T1,T2>::codec() const {
+		return (CODEC_TYPES) _header.codec;
+	}
+
+	template <class T1, class T2>
+	uint64_t ChunkedMatPairReader<T1,T2>::compressedBytes() const {
+		uint64_t ret = 0;
+		for(const ocv::ChunkedMatPairEntry& e : _table)
+			ret += e.i_bytes + e.o_bytes;
+		return ret;
+	}
+
+	template class ChunkedMatPairWriter<double,double>;
+	template class ChunkedMatPairWriter<double,float>;
+	template class ChunkedMatPairWriter<double,int>;
+
+	template class ChunkedMatPairWriter<float,double>;
+	template class ChunkedMatPairWriter<float,float>;
+	template class ChunkedMatPairWriter<float,int>;
+
+	template class ChunkedMatPairReader<double,double>;
+	template class ChunkedMatPairReader<double,float>;
+	template class ChunkedMatPairReader<double,int>;
+
+	template class ChunkedMatPairReader<float,double>;
+	template class ChunkedMatPairReader<float,float>;
+	template class ChunkedMatPairReader<float,int>;
+
+}
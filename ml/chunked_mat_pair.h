@@ -0,0 +1,188 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include "oceancv/ml/mat_pair.h"
+
+namespace ocv {
+
+	/**
+	 * Compression codecs of the chunked MatPair storage. CODEC_NONE and CODEC_RLE are always
+	 * available, CODEC_LZ4 and CODEC_ZSTD only if oceancv was built with the libraries.
+	 */
+	enum CODEC_TYPES {
+		CODEC_NONE,
+		CODEC_RLE,
+		CODEC_LZ4,
+		CODEC_ZSTD
+	};
+
+	/**
+	 * Whether the codec was compiled in.
+	 */
+	bool codecAvailable(CODEC_TYPES codec);
+
+	/**
+	 * Header of the chunked MatPair file format (.ocvmpz). The rows are stored in chunks
+	 * of chunk_rows rows (the last one may be shorter). Each chunk holds the compressed
+	 * input block followed by the compressed output block. A table with the file offset
+	 * and the compressed sizes of each chunk follows the last chunk at table_offset.
+	 */
+	struct ChunkedMatPairHeader {
+		char magic[8];
+		uint32_t version;
+		int32_t i_depth;
+		int32_t o_depth;
+		int32_t codec;
+		uint32_t flags;
+		uint32_t chunk_rows;
+		uint64_t rows;
+		uint64_t i_cols;
+		uint64_t o_cols;
+		uint64_t chunk_count;
+		uint64_t table_offset;
+		uint64_t reserved[7];
+	};
+
+	static_assert(sizeof(ChunkedMatPairHeader) == 128, "ChunkedMatPairHeader needs a fixed size");
+
+	/**
+	 * One entry of the chunk table.
+	 */
+	struct ChunkedMatPairEntry {
+		uint64_t offset;
+		uint64_t i_bytes;
+		uint64_t o_bytes;
+		// Bit 0 / 1: the input / output block is stored uncompressed
+		uint64_t flags;
+	};
+
+	/**
+	 * Writes a MatPair to a chunk-compressed file while the rows are produced. Rows are
+	 * buffered until one chunk per thread is complete; these chunks are then compressed
+	 * in parallel and written in order. Before compression, the bytes of all values are
+	 * optionally regrouped by significance (byte shuffle), which turns the similar
+	 * exponent and high bytes of feature values into long runs.
+	 * Not thread-safe.
+	 */
+	template <class T1, class T2 = T1>
+	class ChunkedMatPairWriter {
+	public:
+
+		/**
+		 * Creates the file.
+		 * @param path the path of the file
+		 * @param i_cols the dimension of the input vectors
+		 * @param o_cols the dimension of the output vectors
+		 * @param codec the compression codec, needs to be available
+		 * @param chunk_rows the number of rows per chunk, the unit of random access
+		 * @param shuffle whether to byte shuffle the values before compression
+		 */
+		ChunkedMatPairWriter(const std::string& path, int i_cols, int o_cols, CODEC_TYPES codec = CODEC_RLE, int chunk_rows = 4096, bool shuffle = true);
+		~ChunkedMatPairWriter();
+
+		ChunkedMatPairWriter(const ChunkedMatPairWriter&) = delete;
+		ChunkedMatPairWriter& operator=(const ChunkedMatPairWriter&) = delete;
+
+		/**
+		 * Appends the rows of the two Mats, they need the same number of rows.
+		 * @return false if writing failed
+		 */
+		bool append(const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o);
+		bool append(const ocv::MatPair<T1,T2>& mp);
+
+		/**
+		 * Writes the remaining rows and the chunk table and closes the file.
+		 * @return false if any write failed
+		 */
+		bool close();
+
+		/**
+		 * Writes a whole MatPair.
+		 */
+		static bool write(const std::string& path, const ocv::MatPair<T1,T2>& mp, CODEC_TYPES codec = CODEC_RLE, int chunk_rows = 4096, bool shuffle = true);
+
+		// Getter
+		bool isOpen() const;
+		size_t rows() const;
+
+	private:
+
+		// Compresses and writes the buffered rows in parallel
+		bool _flush();
+
+		FILE* _file;
+		ChunkedMatPairHeader _header;
+		std::vector<ocv::ChunkedMatPairEntry> _table;
+		uint64_t _offset;
+		bool _ok;
+
+		// Rows that are not yet written, space for one chunk per thread
+		cv::Mat_<T1> _buf_i;
+		cv::Mat_<T2> _buf_o;
+		int _buffered;
+
+	};
+
+	/**
+	 * Reads a chunk-compressed MatPair file. Any range of rows can be read, only the
+	 * chunks that cover it are read and decompressed, in parallel.
+	 * Reading is thread-safe.
+	 */
+	template <class T1, class T2 = T1>
+	class ChunkedMatPairReader {
+	public:
+
+		/**
+		 * Opens the file and reads the chunk table. Check isOpen() for success, the value
+		 * types of the file need to match T1 and T2.
+		 */
+		ChunkedMatPairReader(const std::string& path);
+		~ChunkedMatPairReader();
+
+		ChunkedMatPairReader(const ChunkedMatPairReader&) = delete;
+		ChunkedMatPairReader& operator=(const ChunkedMatPairReader&) = delete;
+
+		/**
+		 * Reads the rows [begin,end).
+		 * @return false if reading or decompression failed
+		 */
+		bool read(size_t begin, size_t end, ocv::MatPair<T1,T2>& dst) const;
+
+		/**
+		 * Reads all rows.
+		 */
+		bool read(ocv::MatPair<T1,T2>& dst) const;
+
+		/**
+		 * Reads the rows of one chunk.
+		 */
+		bool readChunk(size_t chunk, ocv::MatPair<T1,T2>& dst) const;
+
+		// Getter
+		bool isOpen() const;
+		size_t rows() const;
+		int iCols() const;
+		int oCols() const;
+		int chunkRows() const;
+		size_t chunkCount() const;
+		CODEC_TYPES codec() const;
+
+		// Size of the compressed data in bytes
+		uint64_t compressedBytes() const;
+
+	private:
+
+		// Decompresses one chunk into the two Mats, which need the rows of the chunk
+		bool _decode(size_t chunk, cv::Mat_<T1>& mat_i, cv::Mat_<T2>& mat_o) const;
+
+		int _fd;
+		ChunkedMatPairHeader _header;
+		std::vector<ocv::ChunkedMatPairEntry> _table;
+
+	};
+
+}
@@ -0,0 +1,263 @@
+#include "oceancv/ml/cluster_index_engine.h"
+
+namespace ocv {
+
+	template <class T>
+	ClusterIndexEngine<T>::ClusterIndexEngine(const cv::Mat_<T>& features, int stripes) : _features(features), _stripes(stripes), _min_label(0), _k(0) {
+
+		assert(_features.rows > 0 && _features.cols > 0);
+
+		if(_stripes <= 0)
+			_stripes = std::max(1, cv::getNumThreads());
+		_stripes = std::min(_stripes, _features.rows);
+
+		// Cache the inverse row norms, they do not change between labelings
+		_inv_norm = std::make_shared<std::vector<T>>(_features.rows);
+		std::vector<T>& inv_norm = *_inv_norm;
+		cv::parallel_for_(cv::Range(0, _features.rows), [&](const cv::Range& range) {
+			for(int i = range.start; i < range.end; i++) {
+				const T* x = _features.template ptr<T>(i);
+				double len = 0;
+				for(int c = 0; c < _features.cols; c++)
+					len += (double) x[c] * x[c];
+				inv_norm[i] = len > 0 ? static_cast<T>(1.0 / std::sqrt(len)) : T(0);
+			}
+		});
+
+		_labels = std::vector<int>(_features.rows);
+		_class = std::vector<int>(_features.rows);
+		_result = std::vector<T>(5, T(0));
+
+	}
+
+	template <class T>
+	void ClusterIndexEngine<T>::evaluate(const ocv::MatPair<T,int>& mp, size_t o_col_idx) {
+		assert(mp.rows() == _features.rows && mp.iCols() == _features.cols);
+		assert((int) o_col_idx < mp.oCols());
+		for(int i = 0; i < mp.rows(); i++)
+			_labels[i] = mp.o(i, o_col_idx);
+		_mapLabels();
+		evaluate(_labels);
+	}
+
+	template <class T>
+	void ClusterIndexEngine<T>::evaluate(const std::vector<int>& labels) {
+
+		assert((int) labels.size() == _features.rows);
+
+		if(&labels != &_labels) {
+			std::copy(labels.begin(), labels.end(), _labels.begin());
+			_mapLabels();
+		}
+
+		const int n = _features.rows, d = _features.cols, kd = _k * d;
+
+		// Size the buffers, this only allocates if the class count grew
+		_part_sum.resize(_stripes * kd);
+		_part_nsum.resize(_stripes * kd);
+		_sum.resize(kd);
+		_nsum.resize(kd);
+		_nmean.resize(kd);
+		_nall.resize(d);
+
+		// The single pass over the data
+		cv::parallel_for_(cv::Range(0, _stripes), [&](const cv::Range& range) {
+			for(int s = range.start; s < range.end; s++)
+				_accumulate(s, (int) ((size_t) s * n / _stripes), (int) ((size_t) (s + 1) * n / _stripes));
+		});
+
+		// Merge partial sums in stripe order
+		std::fill(_sum.begin(), _sum.end(), 0.0);
+		std::fill(_nsum.begin(), _nsum.end(), 0.0);
+		for(int s = 0; s < _stripes; s++) {
+			for(int j = 0; j < kd; j++) {
+				_sum[j] += _part_sum[s * kd + j];
+				_nsum[j] += _part_nsum[s * kd + j];
+			}
+		}
+
+		// Normalized class means and normalized total mean. The class means are only
+		// needed up to their length, so the sums can be normalized directly.
+		std::fill(_nall.begin(), _nall.end(), 0.0);
+		for(int j = 0; j < _k; j++) {
+			double len = 0;
+			for(int c = 0; c < d; c++) {
+				len += _sum[j * d + c] * _sum[j * d + c];
+				_nall[c] += _sum[j * d + c];
+			}
+			len = std::sqrt(len);
+			for(int c = 0; c < d; c++)
+				_nmean[j * d + c] = _sum[j * d + c] / len;
+		}
+		double len = 0;
+		for(int c = 0; c < d; c++)
+			len += _nall[c] * _nall[c];
+		len = std::sqrt(len);
+		for(int c = 0; c < d; c++)
+			_nall[c] /= len;
+
+		// Summed normalized distance of each class to its mean: sum_i (1 - x_i/|x_i| * m_j/|m_j|)
+		// and of all rows to the total mean
+		double all_dist = n, intra_sum = 0, within = 0, dot;
+		std::vector<double> intradist(_k);
+		for(int j = 0; j < _k; j++) {
+			dot = 0;
+			for(int c = 0; c < d; c++) {
+				dot += _nsum[j * d + c] * _nmean[j * d + c];
+				all_dist -= _nsum[j * d + c] * _nall[c];
+			}
+			within += _counts[j] - dot;
+			intradist[j] = (_counts[j] - dot) / _counts[j];
+			intra_sum += intradist[j];
+		}
+
+		// Distances between the class means
+		double maxd = 0, inter = 0, db = 0, maxfrac, tmp;
+		for(int j = 0; j < _k; j++) {
+			maxfrac = 0;
+			for(int k = 0; k < _k; k++) {
+				tmp = _dist(&_nmean[j * d], &_nmean[k * d]);
+				maxd = std::max(maxd, tmp);
+				inter += tmp;
+				if(j != k)
+					maxfrac = std::max(maxfrac, (intradist[j] + intradist[k]) / tmp);
+			}
+			db += maxfrac;
+		}
+
+		// Second pass for the squared distances of Calinski-Harabasz
+		std::vector<double> part_sq(_stripes, 0.0);
+		cv::parallel_for_(cv::Range(0, _stripes), [&](const cv::Range& range) {
+			for(int s = range.start; s < range.end; s++)
+				part_sq[s] = _squaredMeanDist((int) ((size_t) s * n / _stripes), (int) ((size_t) (s + 1) * n / _stripes));
+		});
+		double a = 0, b = 0;
+		for(int s = 0; s < _stripes; s++)
+			b += part_sq[s];
+		for(int j = 0; j < _k; j++) {
+			tmp = _dist(&_nmean[j * d], &_nall[0]);
+			a += _counts[j] * tmp * tmp;
+		}
+
+		_result[ocv::CI_TYPES::CALINSKI_HARABASZ] = static_cast<T>(a / b * (n - _k) / (_k - 1));
+		_result[ocv::CI_TYPES::INDEX_I] = static_cast<T>(1.0 / _k * all_dist / within * maxd);
+		_result[ocv::CI_TYPES::DAVIES_BOULDIN] = static_cast<T>(1.0 / _k * db);
+		_result[ocv::CI_TYPES::INTER_CLASS_VARIANCE] = static_cast<T>(inter);
+		_result[ocv::CI_TYPES::INTRA_CLASS_VARIANCE] = static_cast<T>(intra_sum);
+
+	}
+
+	template <class T>
+	T ClusterIndexEngine<T>::index(ocv::CI_TYPES ci_type) const {
+		return _result[ci_type];
+	}
+
+	template <class T>
+	cv::Mat_<T> ClusterIndexEngine<T>::means() const {
+		cv::Mat_<T> ret(_k, _features.cols);
+		for(int j = 0; j < _k; j++) {
+			for(int c = 0; c < _features.cols; c++)
+				ret(j,c) = static_cast<T>(_sum[j * _features.cols + c] / _counts[j]);
+		}
+		return ret;
+	}
+
+	template <class T>
+	int ClusterIndexEngine<T>::classCount() const {
+		return _k;
+	}
+
+	template <class T>
+	int ClusterIndexEngine<T>::rows() const {
+		return _features.rows;
+	}
+
+	template <class T>
+	int ClusterIndexEngine<T>::cols() const {
+		return _features.cols;
+	}
+
+	template <class T>
+	void ClusterIndexEngine<T>::_accumulate(int stripe, int begin, int end) {
+
+		const int d = _features.cols;
+		double* sum = &_part_sum[stripe * _k * d];
+		double* nsum = &_part_nsum[stripe * _k * d];
+		std::fill(sum, sum + _k * d, 0.0);
+		std::fill(nsum, nsum + _k * d, 0.0);
+
+		for(int i = begin; i < end; i++) {
+			const T* x = _features.template ptr<T>(i);
+			const double inv = (*_inv_norm)[i];
+			double* s = sum + _class[i] * d;
+			double* ns = nsum + _class[i] * d;
+			for(int c = 0; c < d; c++) {
+				s[c] += x[c];
+				ns[c] += x[c] * inv;
+			}
+		}
+
+	}
+
+	template <class T>
+	double ClusterIndexEngine<T>::_squaredMeanDist(int begin, int end) const {
+		const int d = _features.cols;
+		double ret = 0, dot;
+		for(int i = begin; i < end; i++) {
+			const T* x = _features.template ptr<T>(i);
+			const double* m = &_nmean[_class[i] * d];
+			dot = 0;
+			for(int c = 0; c < d; c++)
+				dot += x[c] * m[c];
+			dot = 1 - dot * (*_inv_norm)[i];
+			ret += dot * dot;
+		}
+		return ret;
+	}
+
+	template <class T>
+	double ClusterIndexEngine<T>::_dist(const double* a, const double* b) const {
+		double dot = 0;
+		for(int c = 0; c < _features.cols; c++)
+			dot += a[c] * b[c];
+		return 1 - dot;
+	}
+
+	template <class T>
+	void ClusterIndexEngine<T>::_mapLabels() {
+
+		const int n = _features.rows;
+
+		int max_label = _labels[0];
+		_min_label = _labels[0];
+		for(int i = 1; i < n; i++) {
+			_min_label = std::min(_min_label, _labels[i]);
+			max_label = std::max(max_label, _labels[i]);
+		}
+
+		// Labels come from clusterings, thus their range is in the order of the class count
+		_lookup.assign((size_t) (max_label - _min_label) + 1, -1);
+		for(int i = 0; i < n; i++)
+			_lookup[_labels[i] - _min_label] = 0;
+
+		// Assign class indices in label order
+		_k = 0;
+		for(size_t l = 0; l < _lookup.size(); l++) {
+			if(_lookup[l] == 0)
+				_lookup[l] = ++_k;
+		}
+
+		_counts.assign(_k, 0);
+		for(int i = 0; i < n; i++) {
+			_class[i] = _lookup[_labels[i] - _min_label] - 1;
+			_counts[_class[i]]++;
+		}
+
+		assert(_k > 1);
+
+	}
+
+	template class ClusterIndexEngine<float>;
+	template class ClusterIndexEngine<double>;
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "oceancv/ml/cluster_indices.h"
+
+namespace ocv {
+
+	/**
+	 * Computes all CI_TYPES cluster indices of a labeling in one parallel pass over the data.
+	 * Gives the same values as ci<T>::compute but is meant for evaluating many labelings of the
+	 * same features (e.g. for model selection): the inverse euclidean row norms are cached once
+	 * in the constructor and all buffers are kept between calls to evaluate().
+	 * The normalized scalar distance to a class mean decomposes into per-class sums of the
+	 * raw and the normalized feature vectors. Those sums are accumulated by each thread into its
+	 * own buffer and merged in a fixed order afterwards, so results do not depend on scheduling.
+	 * Only the Calinski-Harabasz index needs squared distances, for which a second pass is done.
+	 * Copies of an engine share the cached row norms but have their own buffers, so each
+	 * thread can evaluate labelings of the same features with its own copy.
+	 */
+	template <class T>
+	class ClusterIndexEngine {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param features the feature vectors, one per row. Data is not copied, so it must not change while the engine is used.
+		 * @param stripes number of row blocks that are processed in parallel. If zero, the number of threads is used.
+		 */
+		ClusterIndexEngine(const cv::Mat_<T>& features, int stripes = 0);
+
+		/**
+		 * Computes all cluster indices for the given labeling, one label per feature row.
+		 * Labels may be arbitrary integers, classes are sorted by label just like in
+		 * mpalg::splitMatPairToMat. Retrieve the results with index().
+		 */
+		void evaluate(const std::vector<int>& labels);
+
+		/**
+		 * Same as above but takes the labels from the o_col_idx-th output column of the MatPair.
+		 * The input part of the MatPair needs to be the features given in the constructor.
+		 */
+		void evaluate(const ocv::MatPair<T,int>& mp, size_t o_col_idx);
+
+		/**
+		 * Returns one of the indices computed by the last call to evaluate()
+		 */
+		T index(ocv::CI_TYPES ci_type) const;
+
+		/**
+		 * Returns the class means of the last call to evaluate(), one per row, sorted by label
+		 */
+		cv::Mat_<T> means() const;
+
+		// Getter
+		int classCount() const;
+		int rows() const;
+		int cols() const;
+
+	private:
+
+		// Accumulates the per-class sums of the rows [begin,end) into the buffers of one stripe
+		void _accumulate(int stripe, int begin, int end);
+
+		// Sum of squared normalized distances to the class means for the rows [begin,end)
+		double _squaredMeanDist(int begin, int end) const;
+
+		// Normalized scalar distance between two normalized vectors
+		double _dist(const double* a, const double* b) const;
+
+		// Maps the labels to class indices and counts the class sizes
+		void _mapLabels();
+
+
+		// Feature data
+		cv::Mat_<T> _features;
+
+		// Inverse euclidean length of each row, 0 for rows of length 0. Read-only after construction.
+		std::shared_ptr<std::vector<T>> _inv_norm;
+
+		// Number of row blocks
+		int _stripes;
+
+		// Labels of the current evaluation and the corresponding class index per row
+		std::vector<int> _labels;
+		std::vector<int> _class;
+
+		// Lookup from label - _min_label to class index
+		std::vector<int> _lookup;
+		int _min_label;
+
+		// Number of classes and rows per class
+		int _k;
+		std::vector<size_t> _counts;
+
+		// Per-stripe partial sums, _stripes x _k x cols. Accumulated in double to
+		// keep precision for large numbers of rows
+		std::vector<double> _part_sum;
+		std::vector<double> _part_nsum;
+
+		// Merged sums of raw and of normalized rows, _k x cols
+		std::vector<double> _sum;
+		std::vector<double> _nsum;
+
+		// Normalized class means, _k x cols and the normalized mean of all rows
+		std::vector<double> _nmean;
+		std::vector<double> _nall;
+
+		// Results, indexed by CI_TYPES
+		std::vector<T> _result;
+
+	};
+
+}
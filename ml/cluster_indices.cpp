@@ -34,27 +34,20 @@ namespace ocv {
 	template <class T1, class T2>
 	cv::Mat_<T1> ci<T1,T2>::betweenClassScatter(const std::vector<cv::Mat_<T1>>& class_mats, const std::vector<cv::Mat_<T1>>& class_means) {
 	
+		assert(class_means.size() > 0);
+		
 		// Compute all_mean
 		cv::Mat_<T1> all_mean;
 		computeAllMean(class_mats,class_means,all_mean);
 		
-	    // Set between class scatter Mat
-	    bool first = true;
-	    size_t dim = 0;
-	    cv::Mat_<T1> between_scatter;
-	    for(size_t i = 0; i < class_means.size(); i++) {
-	    	if(first) {
-	    		dim = class_mats[i].cols;
-	    		between_scatter = cv::Mat_<T1>(dim, dim, static_cast<T1>(0));
-		    	first = false;
-	    	}
-	        for(size_t j = 0; j < dim; j++) {
-	            for(size_t k = 0; k < dim; k++) {
-	                between_scatter(j,k) += (class_means[i](j) - all_mean(j)) * class_means[i](k) - all_mean(k);
-	            }
-	        }
-	    }
+		// Stack the class means to compute the scatter as one product
+		cv::Mat_<T1> means(class_means.size(), all_mean.cols);
+		for(size_t i = 0; i < class_means.size(); i++) {
+			class_means[i].reshape(1,1).copyTo(means.row(i));
+		}
 		
+		cv::Mat_<T1> between_scatter;
+		ocv::malg<T1>::scatterMat(means, all_mean, between_scatter);
 	    return between_scatter;
 	
 	}
@@ -62,27 +55,12 @@ namespace ocv {
 	template <class T1, class T2>
 	cv::Mat_<T1> ci<T1,T2>::withinClassScatter(const std::vector<cv::Mat_<T1>>& class_mats, const std::vector<cv::Mat_<T1>>& class_means) {
 	
-		bool first = true;
-	    size_t dim = 0;
-	    cv::Mat_<T1> within_scatter;
+		assert(class_mats.size() > 0 && class_mats.size() == class_means.size());
 		
+	    cv::Mat_<T1> within_scatter(class_mats[0].cols, class_mats[0].cols, static_cast<T1>(0)), tmp;
 	    for(size_t i = 0; i < class_mats.size(); i++) {
-			
-	    	if(first) {
-	    		dim = class_mats[i].cols;
-	    		within_scatter = cv::Mat_<T1>(dim, dim, static_cast<T1>(0));
-		    	first = false;
-	    	}
-			
-	        for(int j = 0; j < class_mats[i].rows; j++) {
-				
-                for(size_t k = 0; k < dim; k++) {
-                    for(size_t l = 0; l < dim; l++) {
-                        within_scatter(k,l) += (class_mats[i](j,k) - class_means[i](k))*(class_mats[i](j,l) - class_means[i](l));
-                    }
-                }
-
-	        }
+	    	ocv::malg<T1>::scatterMat(class_mats[i], class_means[i], tmp);
+	    	within_scatter += tmp;
 	    }
 	    return within_scatter;
 		
@@ -198,19 +176,17 @@ namespace ocv {
 		
 		// Compute mean for each MatPair
 		std::vector<cv::Mat_<T1>> class_means;
-		std::cout << "pre means" << std::endl;
 		ocv::malg<T1>::means(mv,class_means);
-		std::cout << "have means" << std::endl;
 		
 	    switch(ci_type) {
 			case ocv::CI_TYPES::CALINSKI_HARABASZ:
 				return chalinskiHarabasz(mv,class_means);
 			break;
 			case ocv::CI_TYPES::INDEX_I:
-				return daviesBouldin(mv,class_means);
+				return indexI(mv,class_means);
 			break;
 			case ocv::CI_TYPES::DAVIES_BOULDIN:
-				return indexI(mv,class_means);
+				return daviesBouldin(mv,class_means);
 			break;
 			case ocv::CI_TYPES::INTER_CLASS_VARIANCE:
 				return interClassVariance(class_means);
@@ -230,9 +206,7 @@ namespace ocv {
 	
 		// Split to single-class Mats
 		std::vector<cv::Mat_<T1>> single_mats;
-		std::cout << "pre split" << std::endl;
 		ocv::mpalg<T1,T2>::splitMatPairToMat(mp, single_mats, label_index);
-		std::cout << "psot split" << std::endl;
 		return compute(single_mats,ci_type);
 		
 	}
@@ -249,7 +223,7 @@ namespace ocv {
 				return betweenClassScatter(mv,class_means);
 			break;
 			case ocv::SC_TYPES::WITHIN_CLASS_SCATTER:
-				return betweenClassScatter(mv,class_means);
+				return withinClassScatter(mv,class_means);
 			break;
 			default:
 				return cv::Mat_<T1>(mv.size(),mv.size(),static_cast<T1>(0));
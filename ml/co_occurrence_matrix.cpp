@@ -0,0 +1,212 @@
+#include "oceancv/ml/co_occurrence_matrix.h"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+namespace ocv {
+
+CoOccurrenceMatrix::CoOccurrenceMatrix(int levels, const std::vector<cv::Point>& offsets) : _levels(levels), _offsets(offsets), _lut(256), _counts(levels * levels, 0), _total(0) {
+	assert(levels > 0 && levels <= 256 && !offsets.empty());
+	int width = 256 / levels;
+	for(int v = 0; v < 256; v++)
+		_lut[v] = std::min(levels - 1, v / width);
+}
+
+std::vector<cv::Point> CoOccurrenceMatrix::offsets(int distance) {
+	return {cv::Point(0, distance), cv::Point(distance, 0), cv::Point(distance, distance)};
+}
+
+void CoOccurrenceMatrix::clear() {
+	std::fill(_counts.begin(), _counts.end(), 0);
+	_total = 0;
+}
+
+void CoOccurrenceMatrix::count(const cv::Mat& img, const cv::Mat& mask) {
+	count(img, cv::Rect(0, 0, img.cols, img.rows), mask);
+}
+
+void CoOccurrenceMatrix::count(const cv::Mat& img, const cv::Rect& roi, const cv::Mat& mask, int weight) {
+	assert(img.type() == CV_8UC1 && (mask.empty() || (mask.type() == CV_8UC1 && mask.rows == img.rows && mask.cols == img.cols)));
+	assert(roi.x >= 0 && roi.y >= 0 && roi.x + roi.width <= img.cols && roi.y + roi.height <= img.rows);
+
+	const uchar* lut = _lut.data();
+	int64_t* counts = _counts.data();
+	const bool use_mask = !mask.empty();
+
+	int64_t pairs = 0;
+	int x0, x1;
+	const uchar *a, *b, *m = 0;
+	int64_t* row;
+	for(int y = roi.y; y < roi.y + roi.height; y++) {
+		a = img.ptr<uchar>(y);
+		if(use_mask)
+			m = mask.ptr<uchar>(y);
+		// All offsets while the row of first pixels is in cache
+		for(const cv::Point& o : _offsets) {
+			if(y + o.y < 0 || y + o.y >= img.rows)
+				continue;
+			b = img.ptr<uchar>(y + o.y) + o.x;
+			x0 = std::max(roi.x, -o.x);
+			x1 = std::min(roi.x + roi.width, img.cols - o.x);
+			for(int x = x0; x < x1; x++) {
+				if(use_mask && m[x] != 255)
+					continue;
+				row = counts + lut[a[x]] * _levels;
+				row[lut[b[x]]] += weight;
+				pairs++;
+			}
+		}
+	}
+	_total += weight * pairs;
+}
+
+void CoOccurrenceMatrix::features(double* dst) const {
+
+	std::fill(dst, dst + NUM_HARALICK_TYPES, 0.);
+	if(_total <= 0)
+		return;
+
+	const int L = _levels;
+	const double norm = 1. / _total;
+
+	// Marginals, sum and difference distributions in one pass over the matrix
+	double px[256] = {0}, py[256] = {0}, p_plus[512] = {0}, p_minus[256] = {0};
+	double asm_ = 0, idm = 0, entropy = 0, sum_p = 0;
+	double p;
+	for(int i = 0; i < L; i++) {
+		const int64_t* row = &_counts[i * L];
+		for(int j = 0; j < L; j++) {
+			if(row[j] == 0)
+				continue;
+			p = row[j] * norm;
+			px[i] += p;
+			py[j] += p;
+			p_plus[i + j] += p;
+			p_minus[std::abs(i - j)] += p;
+			asm_ += p * p;
+			idm += p / (1 + (i - j) * (i - j));
+			entropy -= p * std::log(p);
+			sum_p += p;
+		}
+	}
+
+	double mean_x = 0, mean_y = 0, var_x = 0, var_y = 0;
+	for(int i = 0; i < L; i++) {
+		mean_x += i * px[i];
+		mean_y += i * py[i];
+	}
+	for(int i = 0; i < L; i++) {
+		var_x += (i - mean_x) * (i - mean_x) * px[i];
+		var_y += (i - mean_y) * (i - mean_y) * py[i];
+	}
+
+	// Mean of the matrix entries
+	const double mean = sum_p / (L * L);
+	double cov = 0, ssv = 0;
+	for(int i = 0; i < L; i++) {
+		const int64_t* row = &_counts[i * L];
+		double row_sum = 0, row_cov = 0;
+		for(int j = 0; j < L; j++) {
+			p = row[j] * norm;
+			row_sum += p;
+			row_cov += (j - mean_y) * p;
+		}
+		cov += (i - mean_x) * row_cov;
+		ssv += (i - mean) * (i - mean) * row_sum;
+	}
+
+	double contrast = 0, meanm = 0, diff_entropy = 0;
+	for(int n = 0; n < L; n++) {
+		contrast += n * n * p_minus[n];
+		meanm += p_minus[n];
+		if(p_minus[n] > 0)
+			diff_entropy -= p_minus[n] * std::log(p_minus[n]);
+	}
+	meanm /= L;
+	double diff_variance = 0;
+	for(int n = 0; n < L; n++)
+		diff_variance += (p_minus[n] - meanm) * (p_minus[n] - meanm);
+
+	double sum_average = 0, sum_entropy = 0;
+	for(int n = 0; n < 2 * L - 1; n++) {
+		sum_average += n * p_plus[n];
+		if(p_plus[n] > 0)
+			sum_entropy -= p_plus[n] * std::log(p_plus[n]);
+	}
+	double sum_variance = 0;
+	for(int n = 0; n < 2 * L - 1; n++)
+		sum_variance += (n - sum_entropy) * (n - sum_entropy) * p_plus[n];
+
+	dst[ANGULAR_SECOND_MOMENT] = asm_;
+	dst[CONTRAST] = contrast;
+	dst[CORRELATION] = var_x > 0 && var_y > 0 ? cov / std::sqrt(var_x) / std::sqrt(var_y) : 0;
+	dst[SUM_OF_SQUARES_VARIANCE] = ssv;
+	dst[INVERSE_DIFFERENCE_MOMENT] = idm;
+	dst[SUM_AVERAGE] = sum_average;
+	dst[SUM_ENTROPY] = sum_entropy;
+	dst[SUM_VARIANCE] = sum_variance;
+	dst[ENTROPY] = entropy;
+	dst[DIFFERENCE_VARIANCE] = -diff_variance;
+	dst[DIFFERENCE_ENTROPY] = diff_entropy;
+
+}
+
+void CoOccurrenceMatrix::textureMaps(const cv::Mat& img, int radius, const std::vector<HARALICK_TYPES>& types, std::vector<cv::Mat_<float>>& maps, const cv::Mat& mask) const {
+	assert(img.type() == CV_8UC1 && radius >= 0);
+
+	maps.resize(types.size());
+	for(size_t t = 0; t < types.size(); t++)
+		maps[t] = cv::Mat_<float>(img.rows, img.cols);
+
+	int stripes = std::max(1, std::min(cv::getNumThreads(), img.rows));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+
+		CoOccurrenceMatrix glcm(_levels, _offsets);
+		double values[NUM_HARALICK_TYPES];
+
+		for(int s = range.start; s < range.end; s++) {
+			for(int y = s * img.rows / stripes; y < (s + 1) * img.rows / stripes; y++) {
+
+				int y0 = std::max(0, y - radius);
+				int height = std::min(img.rows, y + radius + 1) - y0;
+
+				glcm.clear();
+				glcm.count(img, cv::Rect(0, y0, std::min(img.cols, radius + 1), height), mask);
+
+				for(int x = 0; x < img.cols; x++) {
+
+					glcm.features(values);
+					for(size_t t = 0; t < types.size(); t++)
+						maps[t](y, x) = values[types[t]];
+
+					// Slide the window by one column
+					if(x - radius >= 0)
+						glcm.count(img, cv::Rect(x - radius, y0, 1, height), mask, -1);
+					if(x + radius + 1 < img.cols)
+						glcm.count(img, cv::Rect(x + radius + 1, y0, 1, height), mask);
+
+				}
+			}
+		}
+	});
+
+}
+
+int CoOccurrenceMatrix::levels() const {
+	return _levels;
+}
+
+const std::vector<cv::Point>& CoOccurrenceMatrix::offsetList() const {
+	return _offsets;
+}
+
+int64_t CoOccurrenceMatrix::total() const {
+	return _total;
+}
+
+int64_t CoOccurrenceMatrix::at(int a, int b) const {
+	return _counts[a * _levels + b];
+}
+
+}
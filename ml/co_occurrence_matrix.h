@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "opencv2/core.hpp"
+
+namespace ocv {
+
+// Haralick features in the order of the HaralickTextureDescriptor
+enum HARALICK_TYPES {
+	ANGULAR_SECOND_MOMENT,
+	CONTRAST,
+	CORRELATION,
+	SUM_OF_SQUARES_VARIANCE,
+	INVERSE_DIFFERENCE_MOMENT,
+	SUM_AVERAGE,
+	SUM_ENTROPY,
+	SUM_VARIANCE,
+	ENTROPY,
+	DIFFERENCE_VARIANCE,
+	DIFFERENCE_ENTROPY,
+	NUM_HARALICK_TYPES
+};
+
+/**
+ * Gray level co-occurrence matrix (GLCM) of a CV_8UC1 image for a set of pixel offsets,
+ * with the Haralick features derived from it. The gray values are quantized by a lookup
+ * table to a number of levels, the counts of all offsets are kept in one flat array and
+ * collected in one pass over the rows. A pair is counted for its first pixel, the second
+ * pixel (first pixel + offset) only needs to lie within the image.
+ * Counts can be added and removed, which allows to slide a window over an image and
+ * update the matrix by the columns that enter and leave it (see textureMaps).
+ * See Haralick: "Textural Features for Image Classification"
+ */
+class CoOccurrenceMatrix {
+
+public:
+
+	/**
+	 * Constructor.
+	 * @param levels the number of gray levels, value v is mapped to min(levels-1, v/(256/levels))
+	 * @param offsets the (x,y) offsets from the first to the second pixel of a pair
+	 */
+	CoOccurrenceMatrix(int levels, const std::vector<cv::Point>& offsets);
+
+	/**
+	 * The offsets of the HaralickTextureDescriptor: vertical, horizontal and diagonal
+	 */
+	static std::vector<cv::Point> offsets(int distance);
+
+	// Removes all counts
+	void clear();
+
+	/**
+	 * Counts the pairs of all offsets whose first pixel lies in the roi (and is 255 in the
+	 * optional mask). A negative weight removes pairs counted before.
+	 */
+	void count(const cv::Mat& img, const cv::Rect& roi, const cv::Mat& mask = cv::Mat(), int weight = 1);
+
+	// Counts all pairs of the image
+	void count(const cv::Mat& img, const cv::Mat& mask = cv::Mat());
+
+	/**
+	 * Computes the NUM_HARALICK_TYPES features of the normalized matrix into dst. All
+	 * features are zero if no pair was counted.
+	 */
+	void features(double* dst) const;
+
+	/**
+	 * Dense texture maps: for each pixel, the features of the pairs whose first pixel
+	 * lies in the (2 * radius + 1)^2 window around it (cut at the image border). The
+	 * window slides along the rows and only the entering and leaving columns are counted,
+	 * the rows are processed in parallel.
+	 * @param types the features to compute, one CV_32FC1 map each
+	 */
+	void textureMaps(const cv::Mat& img, int radius, const std::vector<HARALICK_TYPES>& types, std::vector<cv::Mat_<float>>& maps, const cv::Mat& mask = cv::Mat()) const;
+
+	// Getter
+	int levels() const;
+	const std::vector<cv::Point>& offsetList() const;
+	// Number of counted pairs
+	int64_t total() const;
+	// Absolute count of the level pair (a,b)
+	int64_t at(int a, int b) const;
+
+private:
+
+	int _levels;
+	std::vector<cv::Point> _offsets;
+
+	// Level of each gray value
+	std::vector<uchar> _lut;
+
+	// levels x levels counts, row major
+	std::vector<int64_t> _counts;
+	int64_t _total;
+
+};
+
+}
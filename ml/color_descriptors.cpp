@@ -1,5 +1,10 @@
 #include "oceancv/ml/color_descriptors.h"
 
+#include <cmath>
+#include <numeric>
+
+#include "oceancv/ml/integral_histogram.h"
+
 namespace ocv {
 
 template<class T>
@@ -13,20 +18,20 @@ void ColorValueDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, cons
 	int cx = img.cols / 2;
 	int cy = img.rows / 2;
 
-	std::vector<cv::Mat> imgs;
-	cv::split(img,imgs);
-	
 	bool use_mask = !mask.empty();
 	
+	// Pixels are read in place, the extraction does not allocate
+	const uchar* px;
 	for(int i = 0; i < this->_rings; i++) {
 		for(int x = -i; x <= i; x++) {
 			for(int y = -i; y <= i; y++) {
 				if(abs(x)+abs(y) == i) {
+					px = img.ptr<uchar>(cx+x*this->_offset) + (cy+y*this->_offset) * _channels;
 					for(int c = 0; c < _channels; c++) {
 						if(use_mask && mask.at<uchar>(cx+x*this->_offset,cy+y*this->_offset) != 255)
 							vec(idx++) = -1;
 						else
-							vec(idx++) = imgs[c].at<uchar>(cx+x*this->_offset,cy+y*this->_offset);
+							vec(idx++) = px[c];
 					}
 				}
 			}
@@ -35,6 +40,59 @@ void ColorValueDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, cons
 	
 }
 
+template<class T>
+void ColorValueDescriptor<T>::dense(const cv::Mat& img, cv::Mat_<T>& dst, int stride, const cv::Mat& mask) const {
+	assert(img.depth() == CV_8U && img.channels() == _channels && stride > 0);
+	assert(mask.empty() || (mask.type() == CV_8UC1 && mask.rows == img.rows && mask.cols == img.cols));
+	
+	// (column, row) offsets of the ring pixels in the order of extract
+	std::vector<cv::Point> ring;
+	for(int i = 0; i < _rings; i++) {
+		for(int x = -i; x <= i; x++) {
+			for(int y = -i; y <= i; y++) {
+				if(abs(x)+abs(y) == i)
+					ring.push_back(cv::Point(y * _offset, x * _offset));
+			}
+		}
+	}
+	
+	int grid_rows = (img.rows + stride - 1) / stride;
+	int grid_cols = (img.cols + stride - 1) / stride;
+	if(dst.empty())
+		dst = cv::Mat_<T>(grid_rows * grid_cols, size());
+	assert(dst.rows == grid_rows * grid_cols && dst.cols == size());
+	
+	bool use_mask = !mask.empty();
+	
+	int stripes = std::max(1, std::min(cv::getNumThreads(), grid_rows));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		int r, c, idx;
+		const uchar* px;
+		T* row;
+		for(int s = range.start; s < range.end; s++) {
+			for(int gy = s * grid_rows / stripes; gy < (s + 1) * grid_rows / stripes; gy++) {
+				for(int gx = 0; gx < grid_cols; gx++) {
+					row = dst[gy * grid_cols + gx];
+					idx = 0;
+					for(const cv::Point& p : ring) {
+						r = gy * stride + p.y;
+						c = gx * stride + p.x;
+						if(r < 0 || c < 0 || r >= img.rows || c >= img.cols || (use_mask && mask.ptr<uchar>(r)[c] != 255)) {
+							for(int ch = 0; ch < _channels; ch++)
+								row[idx++] = -1;
+						} else {
+							px = img.ptr<uchar>(r) + c * _channels;
+							for(int ch = 0; ch < _channels; ch++)
+								row[idx++] = px[ch];
+						}
+					}
+				}
+			}
+		}
+	});
+	
+}
+
 template<class T>
 bool ColorValueDescriptor<T>::valid(const cv::Mat& img) const {
 	return (img.channels() == _channels && img.rows > 2 * _rings * _offset + 1 && img.cols > 2 * _rings * _offset + 1);
@@ -80,69 +138,152 @@ ColorStatisticDescriptor<T>::ColorStatisticDescriptor(int channels, bool use_min
 
 template<class T>
 void ColorStatisticDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && ((mask.rows == 0 && mask.cols == 0) || (mask.rows == img.rows && mask.cols == img.cols)) && this->valid(img));
+	// The context counts the histograms of all channels in one pass over the interleaved pixels
+	ImageContext ctx(img, mask);
+	extractContext(ctx, vec);
+}
+
+template<class T>
+void ColorStatisticDescriptor<T>::extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const {
+	assert(vec.cols == size() && this->valid(ctx.image()));
 	
-	// Eventually split channels (no real effect for a CV-8UC1 mat)
-	std::vector<cv::Mat> channels;
-	cv::split(img,channels);
+	// All statistics are derived from the 256 bin histograms
+	const size_t* hists[3];
+	for(int c = 0; c < _channels; c++)
+		hists[c] = ctx.histogram(c).data();
+	_fromHistograms(hists, ctx.pixels(), ctx.image().total(), vec.template ptr<T>(0));
 	
-	size_t idx = 0;
+}
+
+template<class T>
+void ColorStatisticDescriptor<T>::dense(const cv::Mat& img, int radius, cv::Mat_<T>& dst, int stride, const cv::Mat& mask) const {
+	assert(this->valid(img) && radius >= 0 && stride > 0);
+	assert(mask.empty() || (mask.type() == CV_8UC1 && mask.rows == img.rows && mask.cols == img.cols));
 	
-	if(_use_minmax) {
-		double minv, maxv;
-		for(int c = 0; c < _channels; c++) {
-			cv::minMaxLoc(channels[c], &minv, &maxv, 0, 0, mask);
-			vec(idx++) = minv;
-			vec(idx++) = maxv;
-		}
-	}
+	int grid_rows = (img.rows + stride - 1) / stride;
+	int grid_cols = (img.cols + stride - 1) / stride;
+	if(dst.empty())
+		dst = cv::Mat_<T>(grid_rows * grid_cols, size());
+	assert(dst.rows == grid_rows * grid_cols && dst.cols == size());
 	
-	if(_use_mean) {
-		cv::Scalar mean = cv::mean(img, mask);
-		for(int c = 0; c < _channels; c++)
-			vec(idx++) = mean[c];
-	}
+	bool use_mask = !mask.empty();
+	
+	// Each grid row slides its own window histograms along the image row
+	int stripes = std::max(1, std::min(cv::getNumThreads(), grid_rows));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
 		
-	if(_use_stddev) {
-		cv::Scalar mean, stddev;
-		cv::meanStdDev(img, mean, stddev, mask);
+		std::vector<size_t> counts(_channels * 256);
+		const size_t* hists[3];
 		for(int c = 0; c < _channels; c++)
-			vec(idx++) = stddev[c];
-	}
-	
-	if(_use_median) {
-	
-		bool use_mask = !mask.empty();
+			hists[c] = &counts[c * 256];
 		
-		// Extract color values
-		std::vector<std::vector<uchar>> color_values(_channels,std::vector<uchar>(img.rows*img.cols));
-		for(int y = 0; y < img.rows; y++) {
-			for (int x = 0; x < img.cols; x++) {
-				if(!use_mask || (use_mask && mask.at<uchar>(y,x) == 255)) {
-					for(int c = 0; c < _channels; c++) {
-						color_values[c][y*img.cols+x] = channels[c].at<uchar>(y,x);
+		for(int s = range.start; s < range.end; s++) {
+			for(int gy = s * grid_rows / stripes; gy < (s + 1) * grid_rows / stripes; gy++) {
+				
+				int y = gy * stride;
+				int y0 = std::max(0, y - radius);
+				int y1 = std::min(img.rows, y + radius + 1);
+				
+				std::fill(counts.begin(), counts.end(), 0);
+				size_t num_pix = 0;
+				
+				// Adds (weight 1) or removes (weight -1) one column of the window
+				auto column = [&](int x, int weight) {
+					const uchar* px;
+					for(int yy = y0; yy < y1; yy++) {
+						if(use_mask && mask.ptr<uchar>(yy)[x] != 255)
+							continue;
+						px = img.ptr<uchar>(yy) + x * _channels;
+						for(int c = 0; c < _channels; c++)
+							counts[c * 256 + px[c]] += weight;
+						num_pix += weight;
 					}
+				};
+				
+				for(int x = 0; x < std::min(img.cols, radius + 1); x++)
+					column(x, 1);
+				
+				for(int x = 0; x < img.cols; x++) {
+					
+					if(x % stride == 0) {
+						size_t total_pix = size_t(y1 - y0) * (std::min(img.cols, x + radius + 1) - std::max(0, x - radius));
+						_fromHistograms(hists, num_pix, total_pix, dst[gy * grid_cols + x / stride]);
+					}
+					
+					if(x - radius >= 0)
+						column(x - radius, -1);
+					if(x + radius + 1 < img.cols)
+						column(x + radius + 1, 1);
+					
 				}
+				
+			}
+		}
+	});
+	
+}
+
+template<class T>
+void ColorStatisticDescriptor<T>::_fromHistograms(const size_t* const* hists, size_t num_pix, size_t total_pix, T* vec) const {
+	
+	size_t idx = 0;
+	for(int c = 0; c < _channels; c++) {
+		
+		const size_t* hist = hists[c];
+		
+		// Moments and range from the value counts
+		double sum = 0, sq_sum = 0;
+		int minv = -1, maxv = 0;
+		size_t cum = 0, median = 0;
+		bool median_found = false;
+		for(int v = 0; v < 256; v++) {
+			if(hist[v] == 0)
+				continue;
+			if(minv < 0)
+				minv = v;
+			maxv = v;
+			sum += double(v) * hist[v];
+			sq_sum += double(v) * v * hist[v];
+			// Value with rank num_pix / 2, as by ImageContext::quantile
+			cum += hist[v];
+			if(!median_found && cum > 0.5 * num_pix) {
+				median = v;
+				median_found = true;
 			}
 		}
+		double mean = num_pix > 0 ? sum / num_pix : 0;
+		double stddev = num_pix > 0 ? std::sqrt(std::max(0., sq_sum / num_pix - mean * mean)) : 0;
 		
-		size_t total_pixels = img.total();
-		size_t skip_pixels = total_pixels;
-		if(use_mask)
-			skip_pixels = cv::countNonZero(mask);
-		size_t median = total_pixels - 0.5 * skip_pixels;
-		for(int c = 0; c < _channels; c++) {
-			std::sort(color_values[c].begin(), color_values[c].end());
-			vec(idx++) = color_values[c][median];
+		idx = 0;
+		if(_use_minmax) {
+			vec[idx + 2 * c] = std::max(0, minv);
+			vec[idx + 2 * c + 1] = maxv;
+			idx += 2 * _channels;
+		}
+		if(_use_mean) {
+			vec[idx + c] = mean;
+			idx += _channels;
+		}
+		if(_use_stddev) {
+			vec[idx + c] = stddev;
+			idx += _channels;
+		}
+		if(_use_median) {
+			vec[idx + c] = median;
+			idx += _channels;
+		}
+		if(_use_entropy) {
+			// As ocv::entropy: probabilities of counts + 1 among all pixels, normalized to 0..1
+			double entropy = 0, p;
+			for(int v = 0; v < 256; v++) {
+				p = (hist[v] + 1.) / total_pix;
+				entropy -= p * std::log2(p);
+			}
+			vec[idx + c] = entropy / 8;
 		}
 		
 	}
 	
-	if(_use_entropy) {
-		for(int c = 0; c < _channels; c++)
-			vec(idx++) = ocv::entropy(channels[c], mask);
-	}
-	
 }
 
 
@@ -206,27 +347,88 @@ HistogramColorDescriptor<T>::HistogramColorDescriptor(int channels, int num_bins
 
 template<class T>
 void HistogramColorDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && ((mask.rows == 0 && mask.cols == 0) || (mask.rows == img.rows && mask.cols == img.cols)) && this->valid(img));
+	std::vector<size_t> hist;
+	_extract(img, vec, mask, hist);
+}
+
+template<class T>
+void HistogramColorDescriptor<T>::extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const {
+	assert(vec.cols == size() && this->valid(ctx.image()));
 	
-	// Prepare histogram
-	size_t hist[_channels*_num_bins];
-	for(int c = 0; c < _channels*_num_bins; c++)
-		hist[c] = 0;
+	// Merge the value counts of the context into the bins
+	size_t idx = 0;
+	size_t num_pix = ctx.pixels();
+	for(int c = 0; c < _channels; c++) {
+		const std::vector<size_t>& counts = ctx.histogram(c);
+		for(int b = 0; b < _num_bins; b++)
+			vec(idx + b) = 0;
+		for(int v = 0; v < 256; v++)
+			vec(idx + std::min(_num_bins - 1, v / _bin_size)) += counts[v];
+		for(int b = 0; b < _num_bins; b++)
+			vec(idx + b) *= 1./T(num_pix);
+		idx += _num_bins;
+	}
 	
-	std::vector<cv::Mat> channels;
-	cv::split(img,channels);
+}
+
+template<class T>
+void HistogramColorDescriptor<T>::extractBatch(const cv::Mat& img, const std::vector<cv::Rect>& rois, cv::Mat_<T>& dst, const cv::Mat& mask) const {
+	assert(this->valid(img));
+	
+	// Coarsest cell size that all region borders lie on
+	size_t area = 0;
+	int cell = 0;
+	for(const cv::Rect& roi : rois) {
+		area += roi.area();
+		cell = std::gcd(cell, std::gcd(roi.x, roi.y));
+		if(roi.x + roi.width != img.cols)
+			cell = std::gcd(cell, roi.x + roi.width);
+		if(roi.y + roi.height != img.rows)
+			cell = std::gcd(cell, roi.y + roi.height);
+	}
+	
+	// The tables hold one histogram per cell corner, limit them to 1GB
+	size_t corners = cell > 0 ? size_t(img.rows / cell + 2) * (img.cols / cell + 2) : 0;
+	if(area <= img.total() || cell == 0 || corners * size() * sizeof(uint32_t) > (size_t(1) << 30)) {
+		FeatureDescriptor<T>::extractBatch(img, rois, dst, mask);
+		return;
+	}
+	
+	IntegralHistogram ih(img, _num_bins, cell, mask, _bin_size);
+	ih.histograms(rois, dst);
+	
+}
+
+template<class T>
+void HistogramColorDescriptor<T>::_extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const {
+	std::vector<size_t> hist;
+	cv::Mat_<T> vec;
+	for(int i = begin; i < end; i++) {
+		vec = dst.row(i);
+		_extract(imgs[i], vec, masks.empty() ? cv::Mat() : masks[i], hist);
+	}
+}
+
+template<class T>
+void HistogramColorDescriptor<T>::_extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask, std::vector<size_t>& hist) const {
+	assert(vec.cols == size() && ((mask.rows == 0 && mask.cols == 0) || (mask.rows == img.rows && mask.cols == img.cols)) && this->valid(img));
+	
+	// Prepare histogram, one block of bins per channel
+	hist.assign(_channels*_num_bins, 0);
 	
 	bool use_mask = !mask.empty();
 	
-	// Count color occurrence
+	// Count color occurrence, the channels are read interleaved without splitting
 	int tmp_bin;
 	size_t num_pix = 0;
+	const uchar* px;
 	for(int y = 0; y < img.rows; y++) {
-		for(int x = 0; x < img.cols; x++) {
+		px = img.ptr<uchar>(y);
+		for(int x = 0; x < img.cols; x++, px += _channels) {
 			if(!use_mask || (use_mask && mask.at<uchar>(y,x) == 255)) {
 				for(int c = 0; c < _channels; c++) {
-					tmp_bin = floor(((double) channels[c].at<uchar>(y,x)) / _bin_size);
-					hist[c*_channels+tmp_bin]++;
+					tmp_bin = std::min(_num_bins - 1, px[c] / _bin_size);
+					hist[c*_num_bins+tmp_bin]++;
 				}
 				num_pix++;
 			}
@@ -237,7 +439,7 @@ void HistogramColorDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec,
 	size_t idx = 0;
 	for(int c = 0; c < _channels; c++) {
 		for(int b = 0; b < _num_bins; b++) {
-			vec(idx++) = (1./T(num_pix)) * hist[c * _channels + b];
+			vec(idx++) = (1./T(num_pix)) * hist[c * _num_bins + b];
 		}
 	}
 	
@@ -276,267 +478,41 @@ HaralickTextureDescriptor<T>::HaralickTextureDescriptor(int num_bins, int offset
 
 template<class T>
 void HaralickTextureDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && ((mask.rows == 0 && mask.cols == 0) || (mask.rows == img.rows && mask.cols == img.cols)) && this->valid(img));
-	
-	// Compute the pixel pair color occurrences
-	
-	// Prepare GLCM matrix
-	T* glcm = new T[_num_bins*_num_bins];
-	for(int a = 0; a < _num_bins; a++) {
-		for(int b = 0; b < _num_bins; b++) {
-			glcm[a*_num_bins+b] = 0;
-		}
-	}
-	
-	bool use_mask = !mask.empty();
-	
-	// Compute absolute counts
-	int bin, tbin;
-	float bin_width = 256 / _num_bins;
-	size_t num_pix = 0;
-	for(int y = 0; y < img.rows - _offset; y++) {
-		for(int x = 0; x < img.cols - _offset; x++) {
-		
-			if(use_mask && mask.at<uchar>(y,x) != 255)
-				continue;
-			
-			bin = img.at<uchar>(y,x) / bin_width;
-			
-			// Vertical
-			tbin = img.at<uchar>(y+_offset,x) / bin_width;
-			glcm[bin*_num_bins+tbin]++;
-			
-			// Horizontal
-			tbin = img.at<uchar>(y,x+_offset) / bin_width;
-			glcm[bin*_num_bins+tbin]++;
-		
-			// Diagonal
-			tbin = img.at<uchar>(y+_offset,x+_offset) / bin_width;
-			glcm[bin*_num_bins+tbin]++;
-			
-			num_pix++;
-			
-		}
-		
-	}
+	CoOccurrenceMatrix glcm(_num_bins, CoOccurrenceMatrix::offsets(_offset));
+	_extract(img, vec, mask, glcm);
+}
 
-	// Normalize counts to probabilites
-	
-	for(int i = 0; i < _num_bins; i++) {
-		for(int j = 0; j < _num_bins; j++) {
-			glcm[i*_num_bins+j] /= num_pix;
-		}
-	}
-	
-	
-	T p_plus[2*_num_bins];
-	for(int i = 0; i < 2 * _num_bins; i++)
-		p_plus[i] = 0;
-	for(int n = 0; n < 2* _num_bins; n++) {
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				if(i + j == n) {
-					p_plus[n] += glcm[i*_num_bins+j];
-				}
-			}
-		}
-	}
-	
-	T p_minus[_num_bins];
-	for(int i = 0; i < _num_bins; i++)
-		p_minus[i] = 0;
-	for(int n = 0; n < 2* _num_bins; n++) {
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				if(std::abs(i - j) == n) {
-					p_minus[n] += glcm[i*_num_bins+j];
-				}
-			}
-		}
-	}
-	
-	T tmp;
-	int idx = 0;
+template<class T>
+void HaralickTextureDescriptor<T>::extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const {
+	CoOccurrenceMatrix glcm(_num_bins, CoOccurrenceMatrix::offsets(_offset));
+	_extract(ctx.gray(), vec, ctx.mask(), glcm);
+}
 
-	// Angular second momentum
-	if(_subdescriptor_activity[0]) {
-		
-		tmp = 0.0;
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += std::pow(glcm[i*_num_bins+j],2);
-			}
-		}
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Contrast
-	if(_subdescriptor_activity[1]) {
-	
-		tmp = 0.0;
-		for(int n = 0; n < _num_bins; n++) {
-			tmp += std::pow(n,2) * p_minus[n];
-		}
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Correlation
-	if(_subdescriptor_activity[2]) {
-	
-		double mean_x = 0, mean_y = 0, var_x = 0, var_y = 0;
-		
-		for(int i = 0; i < _num_bins; i++) {
-			tmp = 0;
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += glcm[i*_num_bins+j];
-			}
-			mean_x += i * tmp;
-			
-			tmp = 0;
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += glcm[j*_num_bins+i];
-			}
-			mean_y += i * tmp;
-		}
-		
-		for(int i = 0; i < _num_bins; i++) {
-			tmp = 0;
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += glcm[i*_num_bins+j];
-			}
-			var_x += std::pow(i - mean_x,2) * tmp;
-			
-			tmp = 0;
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += glcm[j*_num_bins+i];
-			}
-			var_y += std::pow(i - mean_y,2) * tmp;
-		}
-		
-		tmp = 0;
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += (i - mean_x) * (j - mean_y) * glcm[i*_num_bins+j];
-			}
-		}
-		tmp /= std::sqrt(var_x);
-		tmp /= std::sqrt(var_y);
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Sum of squares variance
-	if(_subdescriptor_activity[3]) {
-	
-		T mean = 0;
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				mean += glcm[i*_num_bins+j];
-			}
-		}
-		mean /= (_num_bins * _num_bins);
-		
-		tmp = 0;
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += std::pow(i - mean,2) * glcm[i*_num_bins+j];
-			}
-		}
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Inverse Difference Moment
-	if(_subdescriptor_activity[4]) {
-	
-		tmp = 0;
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += 1/(1+std::pow(i - j,2)) * glcm[i*_num_bins+j];
-			}
-		}
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Sum average
-	if(_subdescriptor_activity[5]) {
-	
-		tmp = 0;
-		for(int n = 0; n < 2* _num_bins; n++) {
-			tmp += n * p_plus[n];
-		}
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Sum entropy
-	if(_subdescriptor_activity[6]) {
-	
-		tmp = 0;
-		for(int n = 0; n < 2* _num_bins; n++) {
-			tmp += p_plus[n] * _llog(p_plus[n]);
-		}
-		vec(idx++) += -tmp;
-		
-	}
-	
-	// Sum variance
-	if(_subdescriptor_activity[7]) {
-	
-		T fstmp = 0;
-		for(int n = 0; n < 2* _num_bins; n++) {
-			fstmp += p_plus[n] * _llog(p_plus[n]);
-		}
-		
-		tmp = 0;
-		for(int n = 0; n < 2* _num_bins; n++) {
-			tmp += std::pow(n + fstmp,2) * p_plus[n];
-		}
-		vec(idx++) += tmp;
-		
-	}
-	
-	// Entropy
-	if(_subdescriptor_activity[8]) {
-	
-		tmp = 0;
-		for(int i = 0; i < _num_bins; i++) {
-			for(int j = 0; j < _num_bins; j++) {
-				tmp += glcm[i*_num_bins+j] * _llog(glcm[i*_num_bins+j]);
-			}
-		}
-		vec(idx++) += -tmp;
-		
+template<class T>
+void HaralickTextureDescriptor<T>::_extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const {
+	CoOccurrenceMatrix glcm(_num_bins, CoOccurrenceMatrix::offsets(_offset));
+	cv::Mat_<T> vec;
+	for(int i = begin; i < end; i++) {
+		vec = dst.row(i);
+		_extract(imgs[i], vec, masks.empty() ? cv::Mat() : masks[i], glcm);
 	}
+}
+
+template<class T>
+void HaralickTextureDescriptor<T>::_extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask, CoOccurrenceMatrix& glcm) const {
+	assert(vec.cols == size() && ((mask.rows == 0 && mask.cols == 0) || (mask.rows == img.rows && mask.cols == img.cols)) && this->valid(img));
 	
-	// Difference variance
-	if(_subdescriptor_activity[9]) {
-	
-		T meanm = 0;
-		for(int n = 0; n < _num_bins; n++) {
-			meanm += p_minus[n];
-		}
-		meanm /= _num_bins;
-		tmp = 0;
-		for(int n = 0; n < _num_bins; n++) {
-			tmp += std::pow(p_minus[n] - meanm,2);
-		}
-		vec(idx++) += -tmp;
-		
-	}
+	// Count the pixel pairs of all directions in one pass
+	glcm.clear();
+	glcm.count(img, mask);
 	
-	// Difference Entropy
-	if(_subdescriptor_activity[10]) {
+	double values[NUM_HARALICK_TYPES];
+	glcm.features(values);
 	
-		tmp = 0;
-		for(int n = 0; n < _num_bins; n++) {
-			tmp += p_minus[n] * _llog(p_minus[n]);
-		}
-		vec(idx++) += -tmp;
-		
+	int idx = 0;
+	for(size_t i = 0; i < _subdescriptor_activity.size(); i++) {
+		if(_subdescriptor_activity[i])
+			vec(idx++) = values[i];
 	}
 	
 }
@@ -573,14 +549,6 @@ std::vector<std::string> HaralickTextureDescriptor<T>::setup() const {
 	
 }
 
-template<class T>
-T HaralickTextureDescriptor<T>::_llog(T val) const {
-	if(val == 0)
-		return std::log(0.0000000000001);
-	else
-		return std::log(val);
-}
-
 
 template class ColorValueDescriptor<float>;
 template class ColorStatisticDescriptor<float>;
@@ -4,6 +4,7 @@
 
 #include "oceancv/ml/feature_descriptor.h"
 #include "oceancv/img/image_entropy.h"
+#include "oceancv/ml/co_occurrence_matrix.h"
 
 namespace ocv {
 
@@ -24,9 +25,18 @@ public:
 	 * sizes, the centroid is the top/left pixel of the centroid.
 	 * Channels holds the number of channels to expect (1 for CV_8UC1, 3 for CV_8UC3)
 	 * Masked values will receive a value of -1
+	 * The pixels are read in place, so batches use the default extraction.
 	 */
 	ColorValueDescriptor(int channels, int offset, int rings);
 	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
+	
+	/**
+	 * Dense extraction centred at every stride-th pixel of every stride-th row. dst gets
+	 * one row per grid pixel in row major order, e.g. as the input of a MatPair. A row
+	 * equals extract on a square patch of odd size centred at the pixel, ring pixels
+	 * outside the image or mask are -1. If dst is empty it is allocated.
+	 */
+	void dense(const cv::Mat& img, cv::Mat_<T>& dst, int stride = 1, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
@@ -44,6 +54,8 @@ private:
  * Computes statitics for the color values in the given image
  * Possible results are mean, median, variance, entropy.
  * Only works on CV_8UC1 and CV_8UC3 images.
+ * All statistics are exact and derived from the 256 bin histograms of the channels,
+ * which are counted in one pass (or taken from an ImageContext).
  */
 template<class T>
 class ColorStatisticDescriptor : public FeatureDescriptor<T> {
@@ -52,11 +64,26 @@ public:
 	ColorStatisticDescriptor(int channels, bool use_minmax, bool use_mean, bool use_median, bool use_stddev, bool use_entropy);
 	
 	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
+	void extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const;
+	
+	/**
+	 * Dense extraction for the (2 * radius + 1)^2 window (cut at the image border) around
+	 * every stride-th pixel of every stride-th row. dst gets one row per grid pixel in row
+	 * major order, equal to extract on the window. The window histograms slide along the
+	 * rows, only the entering and leaving columns are counted, and rows run in parallel.
+	 * If dst is empty it is allocated.
+	 */
+	void dense(const cv::Mat& img, int radius, cv::Mat_<T>& dst, int stride = 1, const cv::Mat& mask = cv::Mat()) const;
+	
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
 private:
+	
+	// Writes the statistics of the channel histograms (256 counts each) to vec
+	void _fromHistograms(const size_t* const* hists, size_t num_pix, size_t total_pix, T* vec) const;
+	
 	int _channels;
 	bool _use_minmax;
 	bool _use_mean;
@@ -77,11 +104,27 @@ class HistogramColorDescriptor : public FeatureDescriptor<T> {
 public:
 	HistogramColorDescriptor(int channels, int num_bins, T max_value = 255);
 	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
+	void extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const;
+	
+	/**
+	 * Heavily overlapping regions (more region than image area) are read from an
+	 * IntegralHistogram on the coarsest cell grid all regions align to, instead of
+	 * counting the shared pixels again for each region.
+	 */
+	void extractBatch(const cv::Mat& img, const std::vector<cv::Rect>& rois, cv::Mat_<T>& dst, const cv::Mat& mask = cv::Mat()) const;
+	using FeatureDescriptor<T>::extractBatch;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const;
+
 private:
+	
+	// Extraction with the histogram buffer of the caller
+	void _extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask, std::vector<size_t>& hist) const;
+	
 	int _channels;
 	int _num_bins;
 	int _bin_size;
@@ -93,7 +136,8 @@ private:
 /**
  * (H)aralick (T)exture (D)escriptor
  * Computes various (not all) Haralick features from a CV_8UC1 cv::Mat
- 
+ * by a CoOccurrenceMatrix of the vertical, horizontal and diagonal pixel pairs.
+ * For dense per-pixel texture maps use CoOccurrenceMatrix::textureMaps.
  */
 template<class T>
 class HaralickTextureDescriptor : public FeatureDescriptor<T> {
@@ -119,13 +163,18 @@ public:
 	 **/
 	HaralickTextureDescriptor(int bins, int offset = 1, bool angular_second_moment = true, bool contrast = true, bool correlation = true, bool sum_of_squares_variance = true, bool inverse_difference_moment = true, bool sum_average = true, bool sum_variance = true, bool sum_entropy = true, bool entropy = true, bool difference_variance = true, bool difference_entropy = true);
 	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
+	void extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const;
+
 private:
 	
-	inline T _llog(T val) const;
+	// Extraction with the co-occurrence matrix of the caller
+	void _extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask, CoOccurrenceMatrix& glcm) const;
 	
 	std::vector<bool> _subdescriptor_activity;
 	
@@ -0,0 +1,226 @@
+#include "oceancv/ml/column_stats.h"
+
+namespace ocv {
+
+	template <class T>
+	ColumnStats<T>::ColumnStats(int cols) : _n(0), _cols(0) {
+		if(cols > 0)
+			_init(cols);
+	}
+
+	template <class T>
+	void ColumnStats<T>::_init(int cols) {
+		_cols = cols;
+		_mean.assign(_cols, 0.0);
+		_m2.assign(_cols, 0.0);
+		_min.assign(_cols, std::numeric_limits<T>::max());
+		_max.assign(_cols, std::numeric_limits<T>::lowest());
+	}
+
+	template <class T>
+	void ColumnStats<T>::reset() {
+		_n = 0;
+		if(_cols > 0)
+			_init(_cols);
+	}
+
+	template <class T>
+	void ColumnStats<T>::addRow(const T* row) {
+
+		_n++;
+		const double inv_n = 1.0 / _n;
+		double* mean = _mean.data();
+		double* m2 = _m2.data();
+		T* mn = _min.data();
+		T* mx = _max.data();
+
+		for(int c = 0; c < _cols; c++) {
+			double delta = row[c] - mean[c];
+			mean[c] += delta * inv_n;
+			m2[c] += delta * (row[c] - mean[c]);
+			mn[c] = std::min(mn[c], row[c]);
+			mx[c] = std::max(mx[c], row[c]);
+		}
+
+	}
+
+	template <class T>
+	void ColumnStats<T>::add(const cv::Mat_<T>& m) {
+
+		if(m.rows == 0)
+			return;
+		if(_cols == 0)
+			_init(m.cols);
+		assert(m.cols == _cols);
+
+		// Small blocks are not worth the merging
+		const int stripes = std::max(1, std::min(cv::getNumThreads(), m.rows / 1024));
+		if(stripes == 1) {
+			for(int i = 0; i < m.rows; i++)
+				addRow(m.template ptr<T>(i));
+			return;
+		}
+
+		std::vector<ocv::ColumnStats<T>> parts(stripes, ocv::ColumnStats<T>(_cols));
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			for(int s = range.start; s < range.end; s++) {
+				for(int i = (int) ((size_t) s * m.rows / stripes); i < (int) ((size_t) (s + 1) * m.rows / stripes); i++)
+					parts[s].addRow(m.template ptr<T>(i));
+			}
+		});
+
+		// Merge in a fixed order to be independent of the scheduling
+		for(auto& p : parts)
+			merge(p);
+
+	}
+
+	template <class T>
+	void ColumnStats<T>::merge(const ColumnStats<T>& other) {
+
+		if(other._n == 0)
+			return;
+		if(_n == 0) {
+			*this = other;
+			return;
+		}
+		assert(other._cols == _cols);
+
+		const double n = _n + other._n;
+		const double f = (double) other._n / n;
+		const double g = (double) _n * other._n / n;
+		for(int c = 0; c < _cols; c++) {
+			double delta = other._mean[c] - _mean[c];
+			_mean[c] += delta * f;
+			_m2[c] += other._m2[c] + delta * delta * g;
+			_min[c] = std::min(_min[c], other._min[c]);
+			_max[c] = std::max(_max[c], other._max[c]);
+		}
+		_n += other._n;
+
+	}
+
+	template <class T>
+	std::map<int,ocv::ColumnStats<T>> ColumnStats<T>::grouped(const ocv::MatPair<T,int>& mp, int o_col_idx) {
+
+		assert(o_col_idx < mp.oCols());
+
+		const int stripes = std::max(1, std::min(cv::getNumThreads(), mp.rows() / 1024));
+		std::vector<std::map<int,ocv::ColumnStats<T>>> parts(stripes);
+
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			for(int s = range.start; s < range.end; s++) {
+				std::map<int,ocv::ColumnStats<T>>& part = parts[s];
+				for(int i = (int) ((size_t) s * mp.rows() / stripes); i < (int) ((size_t) (s + 1) * mp.rows() / stripes); i++) {
+					auto it = part.find(mp.o(i,o_col_idx));
+					if(it == part.end())
+						it = part.insert(std::make_pair(mp.o(i,o_col_idx), ocv::ColumnStats<T>(mp.iCols()))).first;
+					it->second.addRow(mp.i().template ptr<T>(i));
+				}
+			}
+		});
+
+		std::map<int,ocv::ColumnStats<T>> ret = parts[0];
+		for(int s = 1; s < stripes; s++) {
+			for(auto& p : parts[s]) {
+				auto it = ret.find(p.first);
+				if(it == ret.end())
+					ret.insert(p);
+				else
+					it->second.merge(p.second);
+			}
+		}
+		return ret;
+
+	}
+
+	template <class T>
+	std::map<int,ocv::ColumnStats<T>> ColumnStats<T>::grouped(const ocv::MatPairView<T,int>& view, int o_col_idx) {
+
+		std::vector<std::pair<int,cv::Range>> groups;
+		ocv::MatPairView<T,int> partitioned = view.partition(o_col_idx, groups);
+
+		std::vector<ocv::ColumnStats<T>> parts(groups.size(), ocv::ColumnStats<T>(view.iCols()));
+		cv::parallel_for_(cv::Range(0, groups.size()), [&](const cv::Range& range) {
+			for(int g = range.start; g < range.end; g++)
+				parts[g].add(partitioned.range(groups[g].second.start, groups[g].second.end));
+		});
+
+		std::map<int,ocv::ColumnStats<T>> ret;
+		for(size_t g = 0; g < groups.size(); g++)
+			ret.insert(std::make_pair(groups[g].first, parts[g]));
+		return ret;
+
+	}
+
+	template <class T>
+	cv::Mat_<T> ColumnStats<T>::mean() const {
+		cv::Mat_<T> ret(1, _cols);
+		for(int c = 0; c < _cols; c++)
+			ret(c) = static_cast<T>(_mean[c]);
+		return ret;
+	}
+
+	template <class T>
+	cv::Mat_<T> ColumnStats<T>::variance() const {
+		cv::Mat_<T> ret(1, _cols, T(0));
+		if(_n == 0)
+			return ret;
+		for(int c = 0; c < _cols; c++)
+			ret(c) = static_cast<T>(_m2[c] / _n);
+		return ret;
+	}
+
+	template <class T>
+	cv::Mat_<T> ColumnStats<T>::min() const {
+		cv::Mat_<T> ret(1, _cols);
+		std::copy(_min.begin(), _min.end(), ret.begin());
+		return ret;
+	}
+
+	template <class T>
+	cv::Mat_<T> ColumnStats<T>::max() const {
+		cv::Mat_<T> ret(1, _cols);
+		std::copy(_max.begin(), _max.end(), ret.begin());
+		return ret;
+	}
+
+	template <class T>
+	ocv::VecPair<T> ColumnStats<T>::scaleRange(const cv::Mat_<T>& new_min, const cv::Mat_<T>& new_max) const {
+
+		cv::Mat_<T> shift(1, _cols);
+		cv::Mat_<T> scale(1, _cols);
+
+		for(int i = 0; i < _cols; i++) {
+			if(_max[i] == _min[i]) {
+				scale(i) = 0;
+				shift(i) = 0;
+			} else {
+				scale(i) = (new_max(i) - new_min(i)) / (_max[i] - _min[i]);
+				shift(i) = (_max[i] * new_min(i) - _min[i] * new_max(i)) / (_max[i] - _min[i]);
+			}
+		}
+
+		return ocv::VecPair<T>(scale,shift);
+
+	}
+
+	template <class T>
+	ocv::VecPair<T> ColumnStats<T>::scaleRange(T new_min, T new_max) const {
+		return scaleRange(cv::Mat_<T>(1, _cols, new_min), cv::Mat_<T>(1, _cols, new_max));
+	}
+
+	template <class T>
+	size_t ColumnStats<T>::count() const {
+		return _n;
+	}
+
+	template <class T>
+	int ColumnStats<T>::cols() const {
+		return _cols;
+	}
+
+	template class ColumnStats<float>;
+	template class ColumnStats<double>;
+
+}
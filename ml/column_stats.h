@@ -0,0 +1,123 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <limits>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/vec_pair.h"
+#include "oceancv/ml/mat_pair_view.h"
+
+namespace ocv {
+
+	/**
+	 * Accumulates the column-wise count, minimum, maximum, mean and variance of feature
+	 * vectors in a single pass. Rows are added by Welford's update, which is one
+	 * contiguous loop over the columns per row that the compiler can vectorize.
+	 * Partial statistics (e.g. of different threads or files) are combined with the
+	 * pairwise formula of Chan et al., so accumulating in parts gives the same result
+	 * as one sequential pass up to rounding.
+	 * Results equal malg::mean, malg::variance (population variance), malg::minElements,
+	 * malg::maxElements and malg::scaleRange, but need only one read of the data.
+	 */
+	template <class T>
+	class ColumnStats {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param cols the number of columns. If zero, it is taken from the first added data.
+		 */
+		ColumnStats(int cols = 0);
+
+		/**
+		 * Adds all rows of the matrix. Row blocks are accumulated in parallel and merged.
+		 */
+		void add(const cv::Mat_<T>& m);
+
+		/**
+		 * Adds the input vectors of all rows of the view, without copying the view.
+		 */
+		template <class T2>
+		void add(const ocv::MatPairView<T,T2>& view) {
+			if(view.rows() == 0)
+				return;
+			if(_cols == 0)
+				_init(view.iCols());
+			assert(view.iCols() == _cols);
+			std::vector<T> buf(view.contiguousCols() ? 0 : _cols);
+			for(int r = 0; r < view.rows(); r++) {
+				if(view.contiguousCols()) {
+					addRow(view.iPtr(r));
+				} else {
+					view.iRow(r, buf.data());
+					addRow(buf.data());
+				}
+			}
+		}
+
+		/**
+		 * Adds a single row of cols() values.
+		 */
+		void addRow(const T* row);
+
+		/**
+		 * Merges the statistics of other into these.
+		 */
+		void merge(const ColumnStats<T>& other);
+
+		/**
+		 * Removes all accumulated data, the column count is kept.
+		 */
+		void reset();
+
+		/**
+		 * Accumulates the statistics of the rows of each class label, found in the
+		 * o_col_idx-th output column, in one pass over the MatPair.
+		 */
+		static std::map<int,ocv::ColumnStats<T>> grouped(const ocv::MatPair<T,int>& mp, int o_col_idx = 0);
+
+		/**
+		 * Accumulates the statistics of each label group of the view. The view is split by
+		 * one stable partition and the groups are accumulated in parallel.
+		 */
+		static std::map<int,ocv::ColumnStats<T>> grouped(const ocv::MatPairView<T,int>& view, int o_col_idx = 0);
+
+		// Results, each as a single row Mat
+		cv::Mat_<T> mean() const;
+		cv::Mat_<T> variance() const;
+		cv::Mat_<T> min() const;
+		cv::Mat_<T> max() const;
+
+		/**
+		 * Shift and scale factors as computed by malg::scaleRange
+		 */
+		ocv::VecPair<T> scaleRange(const cv::Mat_<T>& new_min, const cv::Mat_<T>& new_max) const;
+		ocv::VecPair<T> scaleRange(T new_min, T new_max) const;
+
+		// Getter
+		size_t count() const;
+		int cols() const;
+
+	private:
+
+		// Allocates the accumulators once the column count is known
+		void _init(int cols);
+
+		// Number of rows
+		size_t _n;
+
+		// Number of columns
+		int _cols;
+
+		// Running mean and sum of squared deviations from it, kept in double precision
+		std::vector<double> _mean;
+		std::vector<double> _m2;
+
+		// Column-wise extrema
+		std::vector<T> _min;
+		std::vector<T> _max;
+
+	};
+
+}
@@ -1,10 +1,59 @@
 #include "oceancv/ml/feature_descriptor.h"
 
+#include <cassert>
+#include <algorithm>
+
 namespace ocv {
 
 template<class T>
 FeatureDescriptor<T>::FeatureDescriptor() { }
 
+template<class T>
+void FeatureDescriptor<T>::extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const {
+	extract(ctx.image(), vec, ctx.mask());
+}
+
+template<class T>
+void FeatureDescriptor<T>::extractBatch(const std::vector<cv::Mat>& imgs, cv::Mat_<T>& dst, const std::vector<cv::Mat>& masks) const {
+	assert(masks.empty() || masks.size() == imgs.size());
+
+	int num = imgs.size();
+	if(dst.empty())
+		dst = cv::Mat_<T>(num, size());
+	assert(dst.rows == num && dst.cols == size());
+	if(num == 0)
+		return;
+
+	int stripes = std::max(1, std::min(cv::getNumThreads(), num));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		for(int s = range.start; s < range.end; s++)
+			_extractRange(imgs, masks, dst, s * num / stripes, (s + 1) * num / stripes);
+	});
+}
+
+template<class T>
+void FeatureDescriptor<T>::extractBatch(const cv::Mat& img, const std::vector<cv::Rect>& rois, cv::Mat_<T>& dst, const cv::Mat& mask) const {
+	std::vector<cv::Mat> imgs, masks;
+	imgs.reserve(rois.size());
+	for(const cv::Rect& roi : rois)
+		imgs.push_back(img(roi));
+	if(!mask.empty()) {
+		masks.reserve(rois.size());
+		for(const cv::Rect& roi : rois)
+			masks.push_back(mask(roi));
+	}
+	extractBatch(imgs, dst, masks);
+}
+
+template<class T>
+void FeatureDescriptor<T>::_extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const {
+	cv::Mat_<T> vec;
+	for(int i = begin; i < end; i++) {
+		vec = dst.row(i);
+		extract(imgs[i], vec, masks.empty() ? cv::Mat() : masks[i]);
+	}
+}
+
 template class FeatureDescriptor <float>;
 template class FeatureDescriptor <double>;
 
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <map>
+#include <vector>
 #include <iostream>
 
 #include "opencv2/core.hpp"
 
+#include "oceancv/ml/image_context.h"
+
 namespace ocv {
 
 // Virtual base class interface for extracting features from cv::Mats
@@ -21,6 +24,14 @@ public:
 	 */
 	virtual void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const = 0;
 
+	/**
+	 * Computes the feature vector for the image and mask of the context. Intermediates
+	 * like the gray image, the channels or the channel histograms are taken from the
+	 * context, so they are computed once for all descriptors of an image. Descriptors
+	 * that work on gray images use the gray version of a color context.
+	 */
+	virtual void extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const;
+
 	// Checks whether the given image is valid for feature extraction
 	virtual bool valid(const cv::Mat& img) const = 0;
 
@@ -36,6 +47,30 @@ public:
 	 */
 	virtual std::vector<std::string> setup() const = 0;
 
+	/**
+	 * Computes the feature vectors of several images into the rows of dst. If dst is
+	 * empty it is allocated, otherwise it needs imgs.size() rows and size() columns.
+	 * The images are split into one contiguous stripe per thread and each descriptor
+	 * reuses its scratch buffers for all images of a stripe.
+	 * @param masks either empty or one mask (possibly empty) per image
+	 */
+	void extractBatch(const std::vector<cv::Mat>& imgs, cv::Mat_<T>& dst, const std::vector<cv::Mat>& masks = std::vector<cv::Mat>()) const;
+
+	/**
+	 * Computes the feature vectors of several regions of one image into the rows of dst,
+	 * e.g. for the tiles of a frame. The regions are not copied.
+	 */
+	virtual void extractBatch(const cv::Mat& img, const std::vector<cv::Rect>& rois, cv::Mat_<T>& dst, const cv::Mat& mask = cv::Mat()) const;
+
+protected:
+
+	/**
+	 * Computes the items [begin,end) of a batch into the corresponding rows of dst. The
+	 * default calls extract for each item, descriptors override this to keep their
+	 * buffers between the items.
+	 */
+	virtual void _extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const;
+
 };
 
 }
@@ -0,0 +1,321 @@
+#include "oceancv/ml/feature_transform.h"
+
+#include "oceancv/ml/pca.h"
+
+namespace ocv {
+
+	template <class T>
+	FeatureTransform<T>::FeatureTransform() {}
+
+	template <class T>
+	FeatureTransform<T>::FeatureTransform(const std::string& path) {
+		read(path);
+	}
+
+	template <class T>
+	void FeatureTransform<T>::selectColumns(const std::vector<int>& selection_vector) {
+		Stage s;
+		s.type = SELECT;
+		for(size_t i = 0; i < selection_vector.size(); i++) {
+			if(selection_vector[i] != 0)
+				s.columns.push_back(i);
+		}
+		_stages.push_back(s);
+		_compile();
+	}
+
+	template <class T>
+	void FeatureTransform<T>::scaleRange(const cv::Mat_<T>& scale, const cv::Mat_<T>& shift) {
+		assert(scale.total() == shift.total());
+		Stage s;
+		s.type = SCALE_RANGE;
+		s.a = scale.clone().reshape(1,1);
+		s.b = shift.clone().reshape(1,1);
+		_stages.push_back(s);
+		_compile();
+	}
+
+	template <class T>
+	void FeatureTransform<T>::zscore(const cv::Mat_<T>& mean, const cv::Mat_<T>& variance) {
+		assert(mean.total() == variance.total());
+		Stage s;
+		s.type = ZSCORE;
+		s.a = mean.clone().reshape(1,1);
+		s.b = variance.clone().reshape(1,1);
+		_stages.push_back(s);
+		_compile();
+	}
+
+	template <class T>
+	void FeatureTransform<T>::normalize(ocv::METRIC_TYPES metric) {
+		assert(metric == ocv::METRIC_TYPES::EUCLIDEAN || metric == ocv::METRIC_TYPES::EUCLIDEAN_SQUARED || metric == ocv::METRIC_TYPES::MANHATTAN || metric == ocv::METRIC_TYPES::MAXIMUM);
+		Stage s;
+		s.type = NORMALIZE;
+		s.metric = metric;
+		_stages.push_back(s);
+		_compile();
+	}
+
+	template <class T>
+	void FeatureTransform<T>::project(const cv::Mat_<T>& mean, const cv::Mat_<T>& basis) {
+		assert((int) mean.total() == basis.rows);
+		Stage s;
+		s.type = PROJECT;
+		s.a = mean.clone().reshape(1,1);
+		s.b = basis.clone();
+		_stages.push_back(s);
+		_compile();
+	}
+
+	template <class T>
+	void FeatureTransform<T>::fitPCA(const cv::Mat_<T>& data, int components, bool whiten) {
+
+		cv::Mat_<T> tmp;
+		apply(data, tmp);
+		assert(components > 0 && components <= tmp.cols);
+
+		ocv::PCA<T> pca(components);
+		pca.fit(tmp);
+
+		// One basis column per component
+		cv::Mat_<T> basis = pca.eigenvectors().t();
+		if(whiten) {
+			cv::Mat_<T> evals = pca.eigenvalues();
+			for(int p = 0; p < components; p++) {
+				T f = evals(p) > 0 ? static_cast<T>(1.0 / std::sqrt(evals(p))) : T(0);
+				for(int j = 0; j < basis.rows; j++)
+					basis(j,p) *= f;
+			}
+		}
+
+		project(pca.mean(), basis);
+
+	}
+
+	template <class T>
+	void FeatureTransform<T>::_compile() {
+
+		_ops.clear();
+		for(const Stage& s : _stages) {
+
+			if(s.type == SCALE_RANGE || s.type == ZSCORE) {
+
+				// Express the stage as y = a * x + b
+				std::vector<double> a(s.a.total()), b(s.a.total());
+				for(size_t j = 0; j < a.size(); j++) {
+					if(s.type == SCALE_RANGE) {
+						a[j] = s.a(j);
+						b[j] = s.b(j);
+					} else {
+						// Constant columns are mapped to 0 instead of dividing by 0
+						double sd = std::sqrt((double) s.b(j));
+						a[j] = sd > 0 ? 1.0 / sd : 0.0;
+						b[j] = -s.a(j) * a[j];
+					}
+				}
+
+				// Fold into the previous affine map
+				if(!_ops.empty() && _ops.back().type == SCALE_RANGE) {
+					Op& prev = _ops.back();
+					assert(prev.a.size() == a.size());
+					for(size_t j = 0; j < a.size(); j++) {
+						prev.b[j] = a[j] * prev.b[j] + b[j];
+						prev.a[j] *= a[j];
+					}
+				} else {
+					Op op;
+					op.type = SCALE_RANGE;
+					op.a = a;
+					op.b = b;
+					_ops.push_back(op);
+				}
+
+			} else {
+
+				Op op;
+				op.type = s.type;
+				op.columns = s.columns;
+				op.metric = s.metric;
+				if(s.type == PROJECT) {
+					op.b = std::vector<double>(s.a.begin(), s.a.end());
+					s.b.convertTo(op.basis, CV_64F);
+				}
+				_ops.push_back(op);
+
+			}
+
+		}
+
+	}
+
+	template <class T>
+	int FeatureTransform<T>::outputCols(int input_cols) const {
+		int cols = input_cols;
+		for(const Op& op : _ops) {
+			if(op.type == SELECT)
+				cols = op.columns.size();
+			else if(op.type == PROJECT)
+				cols = op.basis.cols;
+		}
+		return cols;
+	}
+
+	template <class T>
+	void FeatureTransform<T>::_transform(const T* src, T* dst, int cols, std::vector<double>& buf_1, std::vector<double>& buf_2) const {
+
+		std::copy(src, src + cols, buf_1.begin());
+		int n = cols;
+
+		for(const Op& op : _ops) {
+			switch(op.type) {
+				case SELECT:
+					for(size_t j = 0; j < op.columns.size(); j++)
+						buf_2[j] = buf_1[op.columns[j]];
+					n = op.columns.size();
+					std::swap(buf_1, buf_2);
+				break;
+				case SCALE_RANGE: {
+					assert((int) op.a.size() == n);
+					const double* a = op.a.data();
+					const double* b = op.b.data();
+					double* x = buf_1.data();
+					for(int j = 0; j < n; j++)
+						x[j] = a[j] * x[j] + b[j];
+				}
+				break;
+				case NORMALIZE: {
+					double len = 0;
+					for(int j = 0; j < n; j++) {
+						switch(op.metric) {
+							case ocv::METRIC_TYPES::MANHATTAN:
+								len += std::abs(buf_1[j]);
+							break;
+							case ocv::METRIC_TYPES::MAXIMUM:
+								len = std::max(len, std::abs(buf_1[j]));
+							break;
+							default:
+								len += buf_1[j] * buf_1[j];
+							break;
+						}
+					}
+					if(op.metric == ocv::METRIC_TYPES::EUCLIDEAN)
+						len = std::sqrt(len);
+					for(int j = 0; j < n; j++)
+						buf_1[j] = len > 0 ? buf_1[j] / len : 0;
+				}
+				break;
+				case PROJECT: {
+					assert(op.basis.rows == n);
+					for(int j = 0; j < n; j++)
+						buf_1[j] -= op.b[j];
+					for(int p = 0; p < op.basis.cols; p++)
+						buf_2[p] = 0;
+					for(int j = 0; j < n; j++) {
+						const double* w = op.basis.template ptr<double>(j);
+						for(int p = 0; p < op.basis.cols; p++)
+							buf_2[p] += buf_1[j] * w[p];
+					}
+					n = op.basis.cols;
+					std::swap(buf_1, buf_2);
+				}
+				break;
+				default:
+				break;
+			}
+		}
+
+		for(int j = 0; j < n; j++)
+			dst[j] = static_cast<T>(buf_1[j]);
+
+	}
+
+	template <class T>
+	void FeatureTransform<T>::apply(const cv::Mat_<T>& src, cv::Mat_<T>& dst) const {
+
+		// Largest intermediate dimension
+		int max_cols = src.cols;
+		for(const Op& op : _ops) {
+			if(op.type == PROJECT)
+				max_cols = std::max(max_cols, op.basis.cols);
+		}
+
+		const int out_cols = outputCols(src.cols);
+		cv::Mat_<T> ret;
+		if(dst.data == src.data && out_cols == src.cols)
+			ret = dst;
+		else
+			ret.create(src.rows, out_cols);
+
+		cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& range) {
+			std::vector<double> buf_1(max_cols), buf_2(max_cols);
+			for(int i = range.start; i < range.end; i++)
+				_transform(src.template ptr<T>(i), ret.template ptr<T>(i), src.cols, buf_1, buf_2);
+		});
+
+		dst = ret;
+
+	}
+
+	template <class T>
+	void FeatureTransform<T>::apply(cv::Mat_<T>& m) const {
+		apply(m, m);
+	}
+
+	template <class T>
+	void FeatureTransform<T>::write(const std::string& path) const {
+
+		cv::FileStorage out(path, cv::FileStorage::WRITE);
+		out << "stage_count" << (int) _stages.size();
+		for(size_t i = 0; i < _stages.size(); i++) {
+			const Stage& s = _stages[i];
+			out << "stage_" + std::to_string(i) << "{";
+			out << "type" << (int) s.type;
+			out << "metric" << (int) s.metric;
+			out << "columns" << s.columns;
+			out << "a" << s.a;
+			out << "b" << s.b;
+			out << "}";
+		}
+		out.release();
+
+	}
+
+	template <class T>
+	void FeatureTransform<T>::read(const std::string& path) {
+
+		cv::FileStorage file(path, cv::FileStorage::READ);
+		assert(file.isOpened());
+
+		_stages.clear();
+		int count = 0, tmp;
+		file["stage_count"] >> count;
+		for(int i = 0; i < count; i++) {
+			cv::FileNode node = file["stage_" + std::to_string(i)];
+			Stage s;
+			node["type"] >> tmp;
+			s.type = (STAGE_TYPES) tmp;
+			node["metric"] >> tmp;
+			s.metric = (ocv::METRIC_TYPES) tmp;
+			node["columns"] >> s.columns;
+			cv::Mat a, b;
+			node["a"] >> a;
+			node["b"] >> b;
+			a.convertTo(s.a, cv::DataType<T>::depth);
+			b.convertTo(s.b, cv::DataType<T>::depth);
+			_stages.push_back(s);
+		}
+		file.release();
+
+		_compile();
+
+	}
+
+	template <class T>
+	size_t FeatureTransform<T>::stages() const {
+		return _stages.size();
+	}
+
+	template class FeatureTransform<float>;
+	template class FeatureTransform<double>;
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/metric.h"
+
+namespace ocv {
+
+	/**
+	 * A chain of feature normalisation stages that is applied to each feature vector in
+	 * one pass. Stages are appended in the order they shall be applied: column selection
+	 * (as mpalg::selectInputColumns), malg::applyScaleRange, malg::applyZScore,
+	 * malg::normalize and a linear projection (e.g. PCA, optionally whitened).
+	 * Consecutive scale and z-score stages are folded into one affine map per column, so
+	 * each row is read once, transformed in a small buffer and written once. Rows are
+	 * processed in parallel.
+	 * The pipeline can be written to and read from disk to apply the identical transform
+	 * to inference data.
+	 */
+	template <class T>
+	class FeatureTransform {
+	public:
+
+		FeatureTransform();
+
+		/**
+		 * Reads a pipeline that was stored with write().
+		 */
+		FeatureTransform(const std::string& path);
+
+		/**
+		 * Keeps only the columns where the selection vector is non-zero.
+		 */
+		void selectColumns(const std::vector<int>& selection_vector);
+
+		/**
+		 * Multiplies each column by scale and adds shift, see malg::scaleRange.
+		 */
+		void scaleRange(const cv::Mat_<T>& scale, const cv::Mat_<T>& shift);
+
+		/**
+		 * Subtracts mean and divides by the standard deviation of each column.
+		 */
+		void zscore(const cv::Mat_<T>& mean, const cv::Mat_<T>& variance);
+
+		/**
+		 * Divides each vector by its distance to the 0-vector. Supports the EUCLIDEAN,
+		 * EUCLIDEAN_SQUARED, MANHATTAN and MAXIMUM metric.
+		 */
+		void normalize(ocv::METRIC_TYPES metric);
+
+		/**
+		 * Projects each vector x to (x - mean) * basis, basis has one column per output dimension.
+		 */
+		void project(const cv::Mat_<T>& mean, const cv::Mat_<T>& basis);
+
+		/**
+		 * Passes the data through the current stages, computes its principal components
+		 * and appends the projection onto the first ones.
+		 * @param data training feature vectors, one per row
+		 * @param components number of principal components to keep
+		 * @param whiten whether to scale each component to unit variance
+		 */
+		void fitPCA(const cv::Mat_<T>& data, int components, bool whiten = false);
+
+		/**
+		 * Applies all stages to each row of src.
+		 */
+		void apply(const cv::Mat_<T>& src, cv::Mat_<T>& dst) const;
+
+		/**
+		 * Applies all stages to each row. Works in place if the number of columns is kept.
+		 */
+		void apply(cv::Mat_<T>& m) const;
+
+		/**
+		 * Applies all stages to the input vectors of the MatPair.
+		 */
+		template <class T2>
+		void apply(ocv::MatPair<T,T2>& mp) const {
+			apply(mp.i());
+		}
+
+		/**
+		 * Stores the pipeline in a cv::FileStorage file (e.g. json or yml).
+		 */
+		void write(const std::string& path) const;
+
+		/**
+		 * Replaces the pipeline by the one stored in the file.
+		 */
+		void read(const std::string& path);
+
+		// Getter
+		size_t stages() const;
+		int outputCols(int input_cols) const;
+
+	private:
+
+		enum STAGE_TYPES {
+			SELECT,
+			SCALE_RANGE,
+			ZSCORE,
+			NORMALIZE,
+			PROJECT
+		};
+
+		// One stage as given by the user, kept for serialization
+		struct Stage {
+			STAGE_TYPES type;
+			std::vector<int> columns;
+			cv::Mat_<T> a;
+			cv::Mat_<T> b;
+			ocv::METRIC_TYPES metric;
+		};
+
+		// One step of the fused pass: column gather, affine map, normalisation or projection
+		struct Op {
+			STAGE_TYPES type;
+			std::vector<int> columns;
+			std::vector<double> a;
+			std::vector<double> b;
+			ocv::METRIC_TYPES metric;
+			cv::Mat_<double> basis;
+		};
+
+		// Rebuilds _ops from _stages, folding consecutive affine stages
+		void _compile();
+
+		// Transforms one row, buf_1 and buf_2 need to hold the largest intermediate dimension
+		void _transform(const T* src, T* dst, int cols, std::vector<double>& buf_1, std::vector<double>& buf_2) const;
+
+		std::vector<Stage> _stages;
+		std::vector<Op> _ops;
+
+	};
+
+}
@@ -1,8 +1,22 @@
 #include "oceancv/ml/genetic_algorithm.h"
 
+#include "opencv2/core.hpp"
+
 namespace ocv {
 
-	GeneticAlgorithm::GeneticAlgorithm(float (*quality)(const std::vector<int>&), size_t individual_size, size_t population_amount, size_t population_size, float mutation_rate, float keep_rate, float mutation_rate_drop) : _quality(quality),  _population_amount(population_amount), _population_size(population_size), _mutation_rate(mutation_rate), _keep_rate(keep_rate), _mutation_rate_drop(mutation_rate_drop) {
+	GeneticAlgorithm::GeneticAlgorithm(QualityFunction quality, size_t individual_size, size_t population_amount, size_t population_size, float mutation_rate, float keep_rate, float mutation_rate_drop, unsigned int seed) : GeneticAlgorithm(GenomeQualityFunction([quality](const ocv::BitGenome& individuum) { return quality(individuum.toVector()); }), individual_size, population_amount, population_size, mutation_rate, keep_rate, mutation_rate_drop, seed) {}
+
+	GeneticAlgorithm::GeneticAlgorithm(GenomeQualityFunction quality, size_t individual_size, size_t population_amount, size_t population_size, float mutation_rate, float keep_rate, float mutation_rate_drop, unsigned int seed) : _quality(quality), _cache_fitness(true), _cache_limit(100000), _evaluations(0), _total_max_population(0), _population_amount(population_amount), _population_size(population_size), _mutation_rate(mutation_rate), _keep_rate(keep_rate), _mutation_rate_drop(mutation_rate_drop) {
+		
+		if(seed == 0)
+			seed = std::random_device()();
+		_rng.seed(seed);
+		
+		// Independent random streams for the islands
+		for(std::size_t p = 0; p < _population_amount; p++) {
+			std::seed_seq seq = {seed, (unsigned int) p + 1};
+			_rngs.push_back(std::mt19937_64(seq));
+		}
 		
 		if(individual_size > 0)
 			initRandom(individual_size);
@@ -11,31 +25,32 @@ namespace ocv {
 	
 	void GeneticAlgorithm::initRandom(size_t individual_size) {
 	
+		_cache.clear();
+		
 		// Create random population
-		_populations = {};
-		_fitnesses = {};
+		_populations = std::vector<std::vector<ocv::BitGenome>>(_population_amount, std::vector<ocv::BitGenome>(_population_size, ocv::BitGenome(individual_size)));
+		_fitnesses = std::vector<std::vector<std::tuple<int,float,size_t>>>(_population_amount);
 		
-		float total_max_fitness = 0.0;
+		cv::parallel_for_(cv::Range(0, _population_amount), [&](const cv::Range& range) {
+			for(int p = range.start; p < range.end; p++)
+				for(ocv::BitGenome& individuum : _populations[p])
+					individuum.randomize(_rngs[p]);
+		});
+		
+		std::vector<const ocv::BitGenome*> individuals;
+		for(std::size_t p = 0; p < _population_amount; p++)
+			for(std::size_t i = 0; i < _population_size; i++)
+				individuals.push_back(&_populations[p][i]);
+		std::vector<float> fitness;
+		_evaluate(individuals, fitness);
 		
-		int random;
+		float total_max_fitness = 0.0;
+		size_t idx = 0;
 		for(std::size_t p = 0; p < _population_amount; p++) {
 			
-			_populations.push_back({});
-			_fitnesses.push_back({});
-			
 			for(std::size_t i = 0; i < _population_size; i++) {
 
-				_populations[p].push_back({});
-
-				for(std::size_t c = 0; c < individual_size; c++) {
-					random = rand() % 100;
-					if(random > 50)
-						_populations[p][i].push_back(1);
-					else
-						_populations[p][i].push_back(0);
-				}
-			
-				_fitnesses[p].push_back(std::tuple<int,float,size_t>(i,_quality(_populations[p][i]),0));
+				_fitnesses[p].push_back(std::tuple<int,float,size_t>(i,fitness[idx++],0));
 				
 				if(std::get<1>(_fitnesses[p][i]) > total_max_fitness) {
 					total_max_fitness = std::get<1>(_fitnesses[p][i]);
@@ -52,9 +67,12 @@ namespace ocv {
 	
 	std::pair<size_t,float> GeneticAlgorithm::optimize(float niche_merging, size_t niche_wanderers, size_t max_iterations, float max_fitness) {
 	
+		std::uniform_real_distribution<float> uniform(0, 1);
 		float tmp_fitness = 0.0, random;
 		size_t i;
 		
+		_cache.clear();
+		
 		for(i = 0; i < max_iterations; i++) {
 		
 			// Perform evolution step
@@ -66,7 +84,7 @@ namespace ocv {
 			}
 			
 			// Eventually move individuals between populations
-			random = ((double) rand() / (RAND_MAX));
+			random = uniform(_rng);
 			if(random < niche_merging) {
 				mergeNiches(niche_wanderers);
 			}
@@ -82,145 +100,158 @@ namespace ocv {
 	
 	float GeneticAlgorithm::evolve() {
 		
-		std::vector<std::tuple<int,float, size_t>> tmp_fitness, new_fitness;
-		std::vector<std::vector<int>> tmp_population, new_population, partner_population;
-		std::vector<int> individuum;
-		std::size_t partner, source;
-		double rate;
-		float sum_fitness, min_fitness, max_fitness, total_max_fitness = 0.0;
-		size_t multiplication;
+		const std::size_t limit = _population_size * _keep_rate;
 		
-		// Evolve each population individually
-		for(std::size_t p = 0; p < _population_amount; p++) {
+		std::vector<std::vector<std::tuple<int,float,size_t>>> tmp_fitnesses(_population_amount), new_fitnesses(_population_amount);
+		std::vector<std::vector<ocv::BitGenome>> tmp_populations(_population_amount), new_populations(_population_amount);
+		// Entries of new_fitnesses whose fitness is not yet known
+		std::vector<std::vector<size_t>> pending(_population_amount);
 		
-			tmp_fitness = {};
-			new_fitness = {};
+		std::vector<const ocv::BitGenome*> individuals;
+		std::vector<float> fitness;
+		float total_max_fitness = 0.0;
 			
-			tmp_population = {};
-			new_population = {};
-			partner_population = {};
+		// Create the offspring of each island
+		cv::parallel_for_(cv::Range(0, _population_amount), [&](const cv::Range& range) {
+			for(int p = range.start; p < range.end; p++) {
 			
-			sum_fitness = 0.0;
-			min_fitness = 1.0;
-			max_fitness = 0.0;
-		
-			// Compute total fitness
-			for(std::tuple<int,float, size_t> pp : _fitnesses[p]) {
-				sum_fitness += std::get<1>(pp);
-				min_fitness = std::min(min_fitness,std::get<1>(pp));
-				max_fitness = std::max(max_fitness,std::get<1>(pp));
-			}
-			if(min_fitness == 0.0) {
-				min_fitness = 0.000001;
-			}
-
-			// Compute multiplication factors to support fitter individuals in mating
-			for(std::tuple<int,float,size_t> pp : _fitnesses[p]) {
-				individuum = _populations[p][std::get<0>(pp)];
-				multiplication = std::get<1>(pp) / min_fitness;
-				for(size_t i = 0; i < multiplication; i++) {
-					partner_population.push_back(individuum);
-				}
-			}
+				std::mt19937_64& rng = _rngs[p];
+				ocv::BitGenome individuum;
 		
-			// Crossover of individuums with partner space
-			for(std::size_t i = 0; i < _population_size; i++) {
-				
-				individuum = _populations[p][i];
-				
-				// Find a random partner
-				partner = rand() % partner_population.size();
-				
-				// Combine with individuum from partner population
-				for(std::size_t c = 0; c < individuum.size(); c++) {
-					source = rand() % 2;
-					if(source == 0) {
-						individuum[c] = partner_population[partner][c];
-					}
+				float min_fitness = 1.0;
+				for(const std::tuple<int,float,size_t>& pp : _fitnesses[p])
+					min_fitness = std::min(min_fitness,std::get<1>(pp));
+				if(min_fitness == 0.0) {
+					min_fitness = 0.000001;
 				}
 				
-				// Mutate
-				for(std::size_t c = 0; c < individuum.size(); c++) {
-					rate = ((double) rand() / (RAND_MAX));
-					if(rate > _mutation_rate) {
-						individuum[c] = 1 - individuum[c];
-					}
+				// Multiplication factors to support fitter individuals in mating, as cumulated weights of a roulette wheel
+				std::vector<size_t> roulette;
+				size_t multiplication = 0;
+				for(const std::tuple<int,float,size_t>& pp : _fitnesses[p]) {
+					multiplication += std::get<1>(pp) / min_fitness;
+					roulette.push_back(multiplication);
 				}
 				
-				tmp_population.push_back(individuum);
-				tmp_fitness.push_back(std::tuple<int,float,size_t>(i,_quality(individuum),0));
+				// Crossover of individuums with partner space
+				for(std::size_t i = 0; i < _population_size; i++) {
+					
+					individuum = _populations[p][i];
+					
+					// Find a random partner, uniformly if all fitnesses are zero
+					std::size_t partner;
+					if(multiplication > 0)
+						partner = std::upper_bound(roulette.begin(), roulette.end(), std::uniform_int_distribution<size_t>(0, multiplication - 1)(rng)) - roulette.begin();
+					else
+						partner = std::uniform_int_distribution<size_t>(0, roulette.size() - 1)(rng);
+					
+					// Combine with individuum from partner population
+					individuum.crossover(_populations[p][std::get<0>(_fitnesses[p][partner])], rng);
+					
+					// Mutate
+					individuum.mutate(1 - _mutation_rate, rng);
+					tmp_populations[p].push_back(individuum);
+				
+				}
 				
 			}
+		});
 		
-			// Keep fittest fraction of lasts generation and also add mutants of them
-			std::size_t limit = _population_size * _keep_rate;
-			for(std::tuple<int,float,size_t> pp : _fitnesses[p]) {
+		// Rate the offspring of all islands in one batch
+		for(std::size_t p = 0; p < _population_amount; p++)
+			for(const ocv::BitGenome& individuum : tmp_populations[p])
+				individuals.push_back(&individuum);
+		_evaluate(individuals, fitness);
+		for(std::size_t p = 0, idx = 0; p < _population_amount; p++)
+			for(std::size_t i = 0; i < tmp_populations[p].size(); i++)
+				tmp_fitnesses[p].push_back(std::tuple<int,float,size_t>(i,fitness[idx++],0));
 				
-				individuum = _populations[p][std::get<0>(pp)];
+		// Select the next generation of each island, mutants are rated afterwards
+		cv::parallel_for_(cv::Range(0, _population_amount), [&](const cv::Range& range) {
+			for(int p = range.start; p < range.end; p++) {
 	
-				new_population.push_back(individuum);
-				new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),std::get<1>(pp),std::get<2>(pp)+1));
-				
-				// Mutate kept individuums
-				for(std::size_t c = 0; c < individuum.size(); c++) {
-					rate = ((double) rand() / (RAND_MAX));
-					if(rate > _mutation_rate) {
-						individuum[c] = 1 - individuum[c];
-					}
-				}
+				std::mt19937_64& rng = _rngs[p];
+				std::vector<std::tuple<int,float,size_t>>& tmp_fitness = tmp_fitnesses[p];
+				std::vector<std::tuple<int,float,size_t>>& new_fitness = new_fitnesses[p];
+				std::vector<ocv::BitGenome>& tmp_population = tmp_populations[p];
+				std::vector<ocv::BitGenome>& new_population = new_populations[p];
+				ocv::BitGenome individuum;
 				
-				new_population.push_back(individuum);
-				new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),_quality(individuum),std::get<2>(pp)+1));
+				// Keep fittest fraction of lasts generation and also add mutants of them
+				for(const std::tuple<int,float,size_t>& pp : _fitnesses[p]) {
+					
+					individuum = _populations[p][std::get<0>(pp)];
+					
+					new_population.push_back(individuum);
+					new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),std::get<1>(pp),std::get<2>(pp)+1));
+					
+					// Mutate kept individuums
+					individuum.mutate(1 - _mutation_rate, rng);
+					
+					pending[p].push_back(new_fitness.size());
+					new_population.push_back(individuum);
+					new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),0,std::get<2>(pp)+1));
+					
+					if(new_fitness.size() > 2 * limit)
+						break;
 				
-				if(new_fitness.size() > 2 * limit)
-					break;
-			
-			}
-			_fitnesses[p].erase(_fitnesses[p].begin(),_fitnesses[p].begin() + limit);
-			
-			// Keep fittest fraction of new generation and also add mutants of them
-			std::sort(tmp_fitness.begin(),tmp_fitness.end(),_sortFitness);
-			for(std::tuple<int,float,size_t> pp : tmp_fitness) {
+				}
+				_fitnesses[p].erase(_fitnesses[p].begin(),_fitnesses[p].begin() + std::min(limit,_fitnesses[p].size()));
 				
-				individuum = tmp_population[std::get<0>(pp)];
-	
-				new_population.push_back(individuum);
-				new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),std::get<1>(pp),std::get<2>(pp)+1));
+				// Keep fittest fraction of new generation and also add mutants of them
+				std::sort(tmp_fitness.begin(),tmp_fitness.end(),_sortFitness);
+				for(const std::tuple<int,float,size_t>& pp : tmp_fitness) {
+					
+					individuum = tmp_population[std::get<0>(pp)];
+					
+					new_population.push_back(individuum);
+					new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),std::get<1>(pp),std::get<2>(pp)+1));
+					
+					// Mutate kept individuums
+					individuum.mutate(1 - _mutation_rate, rng);
+					
+					pending[p].push_back(new_fitness.size());
+					new_population.push_back(individuum);
+					new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),0,std::get<2>(pp)+1));
+					
+					if(new_fitness.size() > 4 * limit)
+						break;
 				
-				// Mutate kept individuums
-				for(std::size_t c = 0; c < individuum.size(); c++) {
-					rate = ((double) rand() / (RAND_MAX));
-					if(rate > _mutation_rate) {
-						individuum[c] = 1 - individuum[c];
-					}
 				}
+				tmp_fitness.erase(tmp_fitness.begin(),tmp_fitness.begin() + std::min(limit,tmp_fitness.size()));
 				
-				new_population.push_back(individuum);
-				new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),_quality(individuum),std::get<2>(pp)+1));
+				// Add 90 percent fittest of last and current generation
+				for(const std::tuple<int,float,size_t>& pp : _fitnesses[p]) {
+					tmp_population.push_back(_populations[p][std::get<0>(pp)]);
+					tmp_fitness.push_back(std::tuple<int,float,size_t>(tmp_population.size() - 1,std::get<1>(pp),std::get<2>(pp)));
+				}
 				
-				if(new_fitness.size() > 4 * limit)
-					break;
+				// Pick fittest of offsprings
+				std::sort(tmp_fitness.begin(),tmp_fitness.end(),_sortFitness);
+				for(const std::tuple<int,float,size_t>& pp : tmp_fitness) {
+					if(new_fitness.size() >= _population_size)
+						break;
+					new_population.push_back(tmp_population[std::get<0>(pp)]);
+					new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),std::get<1>(pp),std::get<2>(pp)));
+				}
 			
 			}
-			tmp_fitness.erase(tmp_fitness.begin(),tmp_fitness.begin() + limit);
+		});
 			
-			// Add 90 percent fittest of last and current generation
-			for(std::tuple<int,float,size_t> pp : _fitnesses[p]) {
-				tmp_population.push_back(_populations[p][std::get<0>(pp)]);
-				tmp_fitness.push_back(std::tuple<int,float,size_t>(tmp_fitness.size(),std::get<1>(pp),std::get<2>(pp)));
-			}
-
-			// Pick fittest of offsprings
-			std::sort(tmp_fitness.begin(),tmp_fitness.end(),_sortFitness);
-			for(std::tuple<int,float,size_t> pp : tmp_fitness) {
-				new_population.push_back(tmp_population[std::get<0>(pp)]);
-				new_fitness.push_back(std::tuple<int,float,size_t>(new_fitness.size(),std::get<1>(pp),std::get<2>(pp)));
-				if(new_fitness.size() == _population_size)
-					break;
-			}
-			
-			_populations[p] = new_population;
-			_fitnesses[p] = new_fitness;
+		// Rate the mutants of all islands in one batch
+		individuals.clear();
+		for(std::size_t p = 0; p < _population_amount; p++)
+			for(size_t idx : pending[p])
+				individuals.push_back(&new_populations[p][idx]);
+		_evaluate(individuals, fitness);
+		for(std::size_t p = 0, idx = 0; p < _population_amount; p++)
+			for(size_t n : pending[p])
+				std::get<1>(new_fitnesses[p][n]) = fitness[idx++];
+				
+		_populations = new_populations;
+		_fitnesses = new_fitnesses;
+	
+		for(std::size_t p = 0; p < _population_amount; p++) {
 			
 			std::sort(_fitnesses[p].begin(),_fitnesses[p].end(),_sortFitness);
 
@@ -244,9 +275,9 @@ namespace ocv {
 		}
 		
 		std::vector<std::vector<std::tuple<int,float,size_t>>> tmp_fitnesses = {};
-		std::vector<std::vector<std::vector<int>>> tmp_populations = {};
+		std::vector<std::vector<ocv::BitGenome>> tmp_populations = {};
 
-		std::vector<int> individuum;
+		ocv::BitGenome individuum;
 		
 		float total_max_fitness = 0.0;
 		std::size_t partner;
@@ -263,7 +294,7 @@ namespace ocv {
 					continue;
 				
 				for(int i = 0; i < wanderer; i++) {
-					partner = rand() % _population_size;
+					partner = std::uniform_int_distribution<size_t>(0, _fitnesses[q].size() - 1)(_rng);
 					individuum = _populations[q][std::get<0>(_fitnesses[q][partner])];
 					tmp_populations[p].push_back(individuum);
 					tmp_fitnesses[p].push_back(std::tuple<int,float,size_t>(tmp_fitnesses[p].size(),std::get<1>(_fitnesses[q][partner]),std::get<2>(_fitnesses[q][partner])));
@@ -285,7 +316,7 @@ namespace ocv {
 			std::sort(tmp_fitnesses[p].begin(), tmp_fitnesses[p].end(), _sortFitness);
 			
 			// Find global fittest individual
-			for(size_t i = 0; i < _population_size; i++) {
+			for(size_t i = 0; i < tmp_fitnesses[p].size(); i++) {
 				if(std::get<1>(tmp_fitnesses[p][i]) > total_max_fitness) {
 					total_max_fitness = std::get<1>(tmp_fitnesses[p][i]);
 					_total_max_population = p;
@@ -301,6 +332,10 @@ namespace ocv {
 	}
 	
 	std::vector<int> GeneticAlgorithm::winner() const {
+		return winnerGenome().toVector();
+	}
+
+	const ocv::BitGenome& GeneticAlgorithm::winnerGenome() const {
 		return _populations[_total_max_population][std::get<0>(_fitnesses[_total_max_population][0])];
 	}
 	
@@ -336,8 +371,91 @@ namespace ocv {
 		return _keep_rate;
 	}
 	
+	void GeneticAlgorithm::cacheFitness(bool cache) {
+		_cache_fitness = cache;
+		if(!cache)
+			_cache.clear();
+	}
+	
+	bool GeneticAlgorithm::cacheFitness() const {
+		return _cache_fitness;
+	}
+	
+	void GeneticAlgorithm::cacheLimit(size_t entries) {
+		_cache_limit = entries;
+		if(_cache.size() >= _cache_limit)
+			_cache.clear();
+	}
+	
+	size_t GeneticAlgorithm::cacheLimit() const {
+		return _cache_limit;
+	}
+	
+	size_t GeneticAlgorithm::cacheSize() const {
+		return _cache.size();
+	}
+	
+	size_t GeneticAlgorithm::evaluations() const {
+		return _evaluations;
+	}
+	
 	bool GeneticAlgorithm::_sortFitness(const std::tuple<int,float,size_t>& f1, const std::tuple<int,float,size_t>& f2) {
 		return std::get<1>(f1) > std::get<1>(f2);
 	}
 	
+	void GeneticAlgorithm::_evaluate(const std::vector<const ocv::BitGenome*>& individuals, std::vector<float>& fitness) {
+		
+		fitness.resize(individuals.size());
+		
+		// Individuals to evaluate, with the cache enabled each distinct one only once
+		std::vector<const ocv::BitGenome*> todo;
+		std::vector<size_t> slot(individuals.size());
+		std::unordered_map<ocv::BitGenome,size_t,_IndividualHash> todo_index;
+		const size_t cached = individuals.size();
+		
+		for(size_t i = 0; i < individuals.size(); i++) {
+			if(_cache_fitness) {
+				auto it = _cache.find(*individuals[i]);
+				if(it != _cache.end()) {
+					fitness[i] = it->second;
+					slot[i] = cached;
+					continue;
+				}
+				auto ins = todo_index.emplace(*individuals[i], todo.size());
+				if(ins.second)
+					todo.push_back(individuals[i]);
+				slot[i] = ins.first->second;
+			} else {
+				slot[i] = todo.size();
+				todo.push_back(individuals[i]);
+			}
+		}
+		
+		// One task per individual, as evaluations may take long
+		std::vector<float> values(todo.size());
+		if(!todo.empty())
+			cv::parallel_for_(cv::Range(0, todo.size()), [&](const cv::Range& range) {
+				for(int t = range.start; t < range.end; t++)
+					values[t] = _quality(*todo[t]);
+			}, todo.size());
+		_evaluations += todo.size();
+		
+		for(size_t i = 0; i < individuals.size(); i++)
+			if(slot[i] != cached)
+				fitness[i] = values[slot[i]];
+		
+		// A full cache is dropped as a whole, it mostly holds individuals of past generations
+		if(_cache_fitness)
+			for(size_t t = 0; t < todo.size(); t++) {
+				if(_cache.size() >= _cache_limit)
+					_cache.clear();
+				_cache.emplace(*todo[t], values[t]);
+			}
+	
+	}
+	
+	size_t GeneticAlgorithm::_IndividualHash::operator()(const ocv::BitGenome& individuum) const {
+		return individuum.hash();
+	}
+
 }
@@ -7,13 +7,33 @@
 #include <algorithm>
 #include <iomanip>
 #include <tuple>
+#include <functional>
+#include <random>
+#include <unordered_map>
+
+#include "oceancv/ml/bit_genome.h"
 
 namespace ocv {
 
+/**
+ * Evolves several populations (islands) of binary individuals, stored as BitGenome
+ * with one bit per gene. The islands evolve in
+ * lockstep: all fitness evaluations of one generation, across all islands, are run as
+ * one batch on the OpenCV thread pool. Each island draws from its own random generator,
+ * so the result only depends on the seed, not on the thread scheduling. Islands only
+ * exchange individuals in mergeNiches().
+ * Fitness values are cached by individual, so the quality function needs to be
+ * deterministic (or the cache disabled). The cache is cleared at the start of each
+ * run (initRandom() and optimize()) and whenever it reaches cacheLimit() entries.
+ */
 class GeneticAlgorithm {
 	
 public:
 
+	// Rates an individual, may be called from several threads at once
+	typedef std::function<float(const std::vector<int>&)> QualityFunction;
+	typedef std::function<float(const ocv::BitGenome&)> GenomeQualityFunction;
+
 	/**
 	 * Constructor that initializes the optimization. Creates totally random individuals.
 	 * Does not conduct the optimization!
@@ -25,8 +45,15 @@ public:
 	 * @param mutation_rate How likely a mutation is
 	 * @param keep_rate How large the fraction of individuals is that is to be retained for the next iteration
 	 * @param mutation_rate_drop by how much the mutation_rate shall be reduced per optimization step
+	 * @param seed seed of the random generators of the islands. If zero, a random seed is used.
+	 */
+	GeneticAlgorithm(QualityFunction quality, size_t individual_size = 0, size_t population_amount = 10, size_t population_size = 100, float mutation_rate = 0.9, float keep_rate = 0.1, float mutation_rate_drop = -0.001, unsigned int seed = 0);
+	
+	/**
+	 * Constructor with a quality function that reads the packed genes directly, which
+	 * saves unpacking each individual to a std::vector<int>.
 	 */
-	GeneticAlgorithm(float (*quality)(const std::vector<int>&), size_t individual_size = 0, size_t population_amount = 10, size_t population_size = 100, float mutation_rate = 0.9, float keep_rate = 0.1, float mutation_rate_drop = -0.001);
+	GeneticAlgorithm(GenomeQualityFunction quality, size_t individual_size = 0, size_t population_amount = 10, size_t population_size = 100, float mutation_rate = 0.9, float keep_rate = 0.1, float mutation_rate_drop = -0.001, unsigned int seed = 0);
 	
 	/**
 	 * Initializes all populations randomly
@@ -62,6 +89,11 @@ public:
 	 */
 	std::vector<int> winner() const;
 	
+	/**
+	 * Returns the winner individual in packed form
+	 */
+	const ocv::BitGenome& winnerGenome() const;
+	
 	// Some getter and setter functions
 	void keepRate(float rate);
 	
@@ -79,16 +111,54 @@ public:
 	
 	float keepRate() const;
 	
+	/**
+	 * Enables or disables the fitness cache. Disabling it also clears it.
+	 */
+	void cacheFitness(bool cache);
+	
+	bool cacheFitness() const;
+	
+	/**
+	 * Sets the number of cached fitness values at which the cache is cleared.
+	 */
+	void cacheLimit(size_t entries);
+	
+	size_t cacheLimit() const;
+	
+	// Number of cached fitness values
+	size_t cacheSize() const;
+	
+	// Number of calls of the quality function so far
+	size_t evaluations() const;
+	
 private:
 
-	// Function pointer to the quality function
-	float (*_quality)(const std::vector<int>& individuum);
+	// Hash of a binary individual
+	struct _IndividualHash {
+		size_t operator()(const ocv::BitGenome& individuum) const;
+	};
+
+	// The quality function
+	GenomeQualityFunction _quality;
 	
 	// Helper function to sort a vector containing fitness values (like _fitnesses).
 	static bool _sortFitness(const std::tuple<int,float,size_t>& f1, const std::tuple<int,float,size_t>& f2);
 	
+	// Computes the fitness of all individuals in parallel, duplicates and cached individuals are evaluated once
+	void _evaluate(const std::vector<const ocv::BitGenome*>& individuals, std::vector<float>& fitness);
+	
+	// One random generator per island, another one for merging the niches
+	std::vector<std::mt19937_64> _rngs;
+	std::mt19937_64 _rng;
+	
+	// Fitness of the individuals evaluated so far
+	std::unordered_map<ocv::BitGenome,float,_IndividualHash> _cache;
+	bool _cache_fitness;
+	size_t _cache_limit;
+	size_t _evaluations;
+	
 	// Contains the different populations of individuals. Size depoends on parameters
-	std::vector<std::vector<std::vector<int>>> _populations;
+	std::vector<std::vector<ocv::BitGenome>> _populations;
 	
 	// The global list of individual's fitness
 	std::vector<std::vector<std::tuple<int,float, size_t>>> _fitnesses;
@@ -0,0 +1,325 @@
+#include "oceancv/ml/growing_neural_gas.h"
+
+namespace ocv {
+
+	template <class T>
+	GrowingNeuralGas<T>::GrowingNeuralGas(int dim, int max_nodes, size_t lambda, T eps_b, T eps_n, int max_age, T alpha, T beta, const ocv::Metric<T>* metric) : _dim(dim), _max_nodes(max_nodes), _lambda(lambda), _eps_b(eps_b), _eps_n(eps_n), _max_age(max_age), _alpha(alpha), _beta(beta), _met(metric) {
+
+		assert(_dim > 0);
+		assert(_max_nodes > 1);
+		assert(_lambda > 0);
+
+		_weights = std::vector<T>(_max_nodes * _dim, T(0));
+		_error = std::vector<T>(_max_nodes, T(0));
+		_edge_age = std::vector<int>(_max_nodes * _max_nodes, -1);
+		_degree = std::vector<int>(_max_nodes, 0);
+		_active = std::vector<unsigned char>(_max_nodes, 0);
+		_scratch = std::vector<T>(_dim, T(0));
+		_free.reserve(_max_nodes);
+
+		reset();
+
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::reset() {
+
+		std::fill(_error.begin(), _error.end(), T(0));
+		std::fill(_edge_age.begin(), _edge_age.end(), -1);
+		std::fill(_degree.begin(), _degree.end(), 0);
+		std::fill(_active.begin(), _active.end(), 0);
+
+		// Hand out the lowest slots first
+		_free.clear();
+		for(int i = _max_nodes - 1; i >= 0; i--)
+			_free.push_back(i);
+
+		_samples = 0;
+
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::adapt(const cv::Mat_<T>& vec) {
+
+		assert(vec.total() == (size_t) _dim);
+
+		// Rows of a larger matrix are contiguous anyways, anything else is copied once
+		cv::Mat_<T> tmp;
+		const T* x;
+		if(vec.isContinuous()) {
+			x = vec.template ptr<T>(0);
+		} else {
+			tmp = vec.clone();
+			x = tmp.template ptr<T>(0);
+		}
+
+		_samples++;
+
+		// The first two samples become the initial nodes
+		if(nodeCount() < 2) {
+			int node = _addNode(x, T(0));
+			if(nodeCount() == 2) {
+				for(int i = 0; i < _max_nodes; i++) {
+					if(_active[i] && i != node) {
+						_connect(i, node);
+						break;
+					}
+				}
+			}
+			return;
+		}
+
+		// Find closest and second closest node
+		int s1 = -1, s2 = -1;
+		T d1 = std::numeric_limits<T>::max(), d2 = std::numeric_limits<T>::max(), tmp_dist;
+		for(int i = 0; i < _max_nodes; i++) {
+			if(!_active[i])
+				continue;
+			tmp_dist = _distance(x, i);
+			if(tmp_dist < d1) {
+				d2 = d1;
+				s2 = s1;
+				d1 = tmp_dist;
+				s1 = i;
+			} else if(tmp_dist < d2) {
+				d2 = tmp_dist;
+				s2 = i;
+			}
+		}
+
+		// Accumulate error of the winner
+		_error[s1] += d1;
+
+		// Move the winner towards the sample
+		T* w = &_weights[s1 * _dim];
+		for(int c = 0; c < _dim; c++)
+			w[c] += _eps_b * (x[c] - w[c]);
+
+		// Age the winner's edges and move its neighbours
+		int* ages = &_edge_age[s1 * _max_nodes];
+		for(int n = 0; n < _max_nodes; n++) {
+			if(ages[n] < 0)
+				continue;
+			ages[n]++;
+			_edge_age[n * _max_nodes + s1] = ages[n];
+			w = &_weights[n * _dim];
+			for(int c = 0; c < _dim; c++)
+				w[c] += _eps_n * (x[c] - w[c]);
+		}
+
+		// Refresh the edge between winner and runner-up
+		_connect(s1, s2);
+
+		// Remove edges that are too old and nodes that become isolated by that
+		for(int n = 0; n < _max_nodes; n++) {
+			if(ages[n] > _max_age) {
+				_disconnect(s1, n);
+				if(_degree[n] == 0)
+					_removeNode(n);
+			}
+		}
+		if(_degree[s1] == 0)
+			_removeNode(s1);
+
+		// Grow the network
+		if(_samples % _lambda == 0 && !_free.empty())
+			_insertNode();
+
+		// Decay all errors
+		for(int i = 0; i < _max_nodes; i++)
+			_error[i] *= _beta;
+
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::cluster(const cv::Mat_<T>& features, size_t epochs) {
+		for(size_t e = 0; e < epochs; e++) {
+			for(int i = 0; i < features.rows; i++) {
+				adapt(features.row(i));
+			}
+		}
+	}
+
+	template <class T>
+	int GrowingNeuralGas<T>::bestMatchIndex(const cv::Mat_<T>& vec) const {
+
+		assert(vec.total() == (size_t) _dim);
+
+		cv::Mat_<T> tmp = vec.isContinuous() ? vec : vec.clone();
+		const T* x = tmp.template ptr<T>(0);
+
+		int best = -1, idx = 0, best_idx = -1;
+		T min_dist = std::numeric_limits<T>::max(), tmp_dist;
+		for(int i = 0; i < _max_nodes; i++) {
+			if(!_active[i])
+				continue;
+			tmp_dist = _distance(x, i);
+			if(best < 0 || tmp_dist < min_dist) {
+				min_dist = tmp_dist;
+				best = i;
+				best_idx = idx;
+			}
+			idx++;
+		}
+		return best_idx;
+
+	}
+
+	template <class T>
+	cv::Mat_<T> GrowingNeuralGas<T>::centroids() const {
+		cv::Mat_<T> ret(nodeCount(), _dim);
+		int row = 0;
+		for(int i = 0; i < _max_nodes; i++) {
+			if(_active[i]) {
+				std::copy(_weights.begin() + i * _dim, _weights.begin() + (i + 1) * _dim, ret.template ptr<T>(row++));
+			}
+		}
+		return ret;
+	}
+
+	template <class T>
+	std::vector<std::pair<int,int>> GrowingNeuralGas<T>::edges() const {
+		std::vector<int> idx = _slotToIndex();
+		std::vector<std::pair<int,int>> ret;
+		for(int a = 0; a < _max_nodes; a++) {
+			for(int b = a + 1; b < _max_nodes; b++) {
+				if(_edge_age[a * _max_nodes + b] >= 0)
+					ret.push_back(std::pair<int,int>(idx[a],idx[b]));
+			}
+		}
+		return ret;
+	}
+
+	template <class T>
+	std::vector<T> GrowingNeuralGas<T>::errors() const {
+		std::vector<T> ret;
+		for(int i = 0; i < _max_nodes; i++) {
+			if(_active[i])
+				ret.push_back(_error[i]);
+		}
+		return ret;
+	}
+
+	template <class T>
+	int GrowingNeuralGas<T>::nodeCount() const {
+		return _max_nodes - _free.size();
+	}
+
+	template <class T>
+	int GrowingNeuralGas<T>::maxNodes() const {
+		return _max_nodes;
+	}
+
+	template <class T>
+	size_t GrowingNeuralGas<T>::samples() const {
+		return _samples;
+	}
+
+	template <class T>
+	T GrowingNeuralGas<T>::_distance(const T* vec, int node) const {
+		const T* w = &_weights[node * _dim];
+		if(_met != nullptr) {
+			// Wrap the raw data in Mat headers, no data is copied
+			return _met->distance(cv::Mat_<T>(1, _dim, const_cast<T*>(vec)), cv::Mat_<T>(1, _dim, const_cast<T*>(w)));
+		}
+		T ret = 0, d;
+		for(int c = 0; c < _dim; c++) {
+			d = vec[c] - w[c];
+			ret += d * d;
+		}
+		return ret;
+	}
+
+	template <class T>
+	int GrowingNeuralGas<T>::_addNode(const T* vec, T error) {
+		assert(!_free.empty());
+		int node = _free.back();
+		_free.pop_back();
+		std::copy(vec, vec + _dim, _weights.begin() + node * _dim);
+		_error[node] = error;
+		_degree[node] = 0;
+		_active[node] = 1;
+		return node;
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::_removeNode(int node) {
+		if(!_active[node])
+			return;
+		for(int n = 0; n < _max_nodes; n++) {
+			if(_edge_age[node * _max_nodes + n] >= 0)
+				_disconnect(node, n);
+		}
+		_active[node] = 0;
+		_error[node] = 0;
+		_free.push_back(node);
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::_connect(int a, int b) {
+		if(_edge_age[a * _max_nodes + b] < 0) {
+			_degree[a]++;
+			_degree[b]++;
+		}
+		_edge_age[a * _max_nodes + b] = 0;
+		_edge_age[b * _max_nodes + a] = 0;
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::_disconnect(int a, int b) {
+		if(_edge_age[a * _max_nodes + b] < 0)
+			return;
+		_degree[a]--;
+		_degree[b]--;
+		_edge_age[a * _max_nodes + b] = -1;
+		_edge_age[b * _max_nodes + a] = -1;
+	}
+
+	template <class T>
+	void GrowingNeuralGas<T>::_insertNode() {
+
+		// Node with the largest error
+		int q = -1;
+		for(int i = 0; i < _max_nodes; i++) {
+			if(_active[i] && (q < 0 || _error[i] > _error[q]))
+				q = i;
+		}
+
+		// Its neighbour with the largest error
+		int f = -1;
+		for(int n = 0; n < _max_nodes; n++) {
+			if(_edge_age[q * _max_nodes + n] >= 0 && (f < 0 || _error[n] > _error[f]))
+				f = n;
+		}
+		if(f < 0)
+			return;
+
+		// Place the new node halfway between both
+		for(int c = 0; c < _dim; c++)
+			_scratch[c] = T(0.5) * (_weights[q * _dim + c] + _weights[f * _dim + c]);
+
+		_error[q] *= _alpha;
+		_error[f] *= _alpha;
+		int r = _addNode(_scratch.data(), _error[q]);
+
+		_disconnect(q, f);
+		_connect(q, r);
+		_connect(r, f);
+
+	}
+
+	template <class T>
+	std::vector<int> GrowingNeuralGas<T>::_slotToIndex() const {
+		std::vector<int> ret(_max_nodes, -1);
+		int idx = 0;
+		for(int i = 0; i < _max_nodes; i++) {
+			if(_active[i])
+				ret[i] = idx++;
+		}
+		return ret;
+	}
+
+	template class GrowingNeuralGas<float>;
+	template class GrowingNeuralGas<double>;
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cassert>
+#include <algorithm>
+
+#include "oceancv/ml/metric.h"
+#include "oceancv/ml/mat_pair_view.h"
+
+namespace ocv {
+
+	/**
+	 * Growing Neural Gas (Fritzke: "A Growing Neural Gas Network Learns Topologies").
+	 * In contrast to NeuralGas and H2SOM, the number of prototypes does not need to be
+	 * known upfront. Nodes are inserted where the accumulated quantization error is
+	 * highest and removed once they lost all their edges. Samples are fed one at a time,
+	 * so the feature stream of e.g. a video survey can be clustered without buffering it.
+	 * All node data (prototypes, errors, edge ages) is kept in flat, preallocated arrays
+	 * sized by max_nodes, thus adapting to a sample does not allocate memory.
+	 */
+	template <class T>
+	class GrowingNeuralGas {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param dim the dimension of the feature vectors
+		 * @param max_nodes upper limit for the number of prototypes
+		 * @param lambda a new node is inserted after every lambda samples
+		 * @param eps_b learn rate for the best matching node
+		 * @param eps_n learn rate for the topological neighbours of the best matching node
+		 * @param max_age edges older than this are removed
+		 * @param alpha error reduction factor for the two nodes between which a new node is inserted
+		 * @param beta global error decay factor that is applied after each sample
+		 * @param metric the distance metric to use. If not given, the squared euclidean distance is used (recommended).
+		 */
+		GrowingNeuralGas(int dim, int max_nodes = 100, size_t lambda = 100, T eps_b = 0.05, T eps_n = 0.006, int max_age = 50, T alpha = 0.5, T beta = 0.995, const ocv::Metric<T>* metric = nullptr);
+
+		/**
+		 * Adapts the network to one feature vector (a single row cv::Mat_).
+		 */
+		void adapt(const cv::Mat_<T>& vec);
+
+		/**
+		 * Feeds all rows of the given feature matrix for the given number of epochs.
+		 * Rows are fed in their stored order, shuffle beforehand if that order is not random.
+		 */
+		void cluster(const cv::Mat_<T>& features, size_t epochs = 1);
+
+		/**
+		 * Feeds the input vectors of all rows of the view for the given number of epochs, in
+		 * the order of the view. The view is not copied, so e.g. one label group of a large
+		 * MatPair can be clustered directly.
+		 */
+		template <class T2>
+		void cluster(const ocv::MatPairView<T,T2>& view, size_t epochs = 1) {
+			for(size_t e = 0; e < epochs; e++) {
+				view.forEachBlock(1024, [this](const cv::Mat_<T>& block, const cv::Mat_<T2>&) {
+					cluster(block);
+				});
+			}
+		}
+
+		/**
+		 * Returns the index (into centroids()) of the prototype closest to the given vector.
+		 */
+		int bestMatchIndex(const cv::Mat_<T>& vec) const;
+
+		/**
+		 * Removes all nodes and edges. The next two samples will become the initial nodes.
+		 */
+		void reset();
+
+		/**
+		 * Returns a copy of the current prototypes, one per row.
+		 */
+		cv::Mat_<T> centroids() const;
+
+		/**
+		 * Returns the edges of the node graph as index pairs into centroids()
+		 */
+		std::vector<std::pair<int,int>> edges() const;
+
+		/**
+		 * Returns the accumulated error of each prototype in the order of centroids()
+		 */
+		std::vector<T> errors() const;
+
+		// Getter
+		int nodeCount() const;
+		int maxNodes() const;
+		size_t samples() const;
+
+	private:
+
+		// Distance between the given vector and the node prototype
+		T _distance(const T* vec, int node) const;
+
+		// Adds a node with the given prototype to the first free slot, returns its slot index
+		int _addNode(const T* vec, T error);
+
+		// Frees the slot of a node
+		void _removeNode(int node);
+
+		// Connects two nodes by an edge of age 0
+		void _connect(int a, int b);
+
+		// Removes the edge between two nodes
+		void _disconnect(int a, int b);
+
+		// Inserts a new node between the node of maximum error and its neighbour of maximum error
+		void _insertNode();
+
+		// Maps the internal slot indices to the consecutive indices of centroids()
+		std::vector<int> _slotToIndex() const;
+
+
+		// Dimension of the feature vectors
+		int _dim;
+
+		// Maximum number of nodes (= number of slots in the flat arrays)
+		int _max_nodes;
+
+		// Node insertion interval
+		size_t _lambda;
+
+		// Learn rates of the winner and its neighbours
+		T _eps_b;
+		T _eps_n;
+
+		// Maximum edge age
+		int _max_age;
+
+		// Error reduction factors
+		T _alpha;
+		T _beta;
+
+		// Optional metric, squared euclidean distance if not set
+		const ocv::Metric<T>* _met;
+
+		// Prototype vectors, _max_nodes x _dim, row-major
+		std::vector<T> _weights;
+
+		// Accumulated error per node slot
+		std::vector<T> _error;
+
+		// Edge age between two node slots, _max_nodes x _max_nodes, -1 for no edge
+		std::vector<int> _edge_age;
+
+		// Number of edges per node slot
+		std::vector<int> _degree;
+
+		// Whether a slot is in use
+		std::vector<unsigned char> _active;
+
+		// Prototype of a node to insert, _dim values
+		std::vector<T> _scratch;
+
+		// Unused slots
+		std::vector<int> _free;
+
+		// Number of samples seen so far
+		size_t _samples;
+
+	};
+
+}
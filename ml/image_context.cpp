@@ -0,0 +1,104 @@
+#include "oceancv/ml/image_context.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "opencv2/imgproc.hpp"
+
+namespace ocv {
+
+ImageContext::ImageContext(const cv::Mat& img, const cv::Mat& mask) : _img(img), _mask(mask), _pixels(0) {
+	assert(img.depth() == CV_8U && (img.channels() == 1 || img.channels() == 3));
+	assert(mask.empty() || (mask.type() == CV_8UC1 && mask.rows == img.rows && mask.cols == img.cols));
+}
+
+const cv::Mat& ImageContext::image() const {
+	return _img;
+}
+
+const cv::Mat& ImageContext::mask() const {
+	return _mask;
+}
+
+const cv::Mat& ImageContext::gray() {
+	if(_img.channels() == 1)
+		return _img;
+	if(_gray.empty())
+		cv::cvtColor(_img, _gray, cv::COLOR_BGR2GRAY);
+	return _gray;
+}
+
+const cv::Mat& ImageContext::converted(int code) {
+	std::map<int,cv::Mat>::iterator it = _converted.find(code);
+	if(it == _converted.end()) {
+		it = _converted.insert(std::pair<int,cv::Mat>(code, cv::Mat())).first;
+		cv::cvtColor(_img, it->second, code);
+	}
+	return it->second;
+}
+
+const std::vector<cv::Mat>& ImageContext::channels() {
+	if(_channels.empty())
+		cv::split(_img, _channels);
+	return _channels;
+}
+
+const std::vector<size_t>& ImageContext::histogram(int channel) {
+	assert(channel >= 0 && channel < _img.channels());
+	if(_histograms.empty())
+		_count();
+	return _histograms[channel];
+}
+
+int ImageContext::quantile(int channel, double q) {
+	const std::vector<size_t>& hist = histogram(channel);
+	double target = std::max(0., std::min(1., q)) * _pixels;
+	size_t cum = 0;
+	int last = 0;
+	for(int v = 0; v < 256; v++) {
+		if(hist[v] == 0)
+			continue;
+		cum += hist[v];
+		last = v;
+		if(cum > target)
+			return v;
+	}
+	return last;
+}
+
+size_t ImageContext::pixels() {
+	if(_histograms.empty())
+		_count();
+	return _pixels;
+}
+
+std::shared_ptr<Frame>& ImageContext::frame() {
+	return _frame;
+}
+
+void ImageContext::_count() {
+
+	int num_channels = _img.channels();
+	_histograms.assign(num_channels, std::vector<size_t>(256, 0));
+	_pixels = 0;
+
+	bool use_mask = !_mask.empty();
+
+	const uchar* px;
+	const uchar* m = 0;
+	for(int y = 0; y < _img.rows; y++) {
+		px = _img.ptr<uchar>(y);
+		if(use_mask)
+			m = _mask.ptr<uchar>(y);
+		for(int x = 0; x < _img.cols; x++, px += num_channels) {
+			if(use_mask && m[x] != 255)
+				continue;
+			for(int c = 0; c < num_channels; c++)
+				_histograms[c][px[c]]++;
+			_pixels++;
+		}
+	}
+
+}
+
+}
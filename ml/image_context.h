@@ -0,0 +1,90 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <memory>
+
+#include "opencv2/core.hpp"
+
+// Image structure of the MPEG7 library, only created by the MPEG7 descriptors
+class Frame;
+
+namespace ocv {
+
+/**
+ * Intermediate results of one image (and optional mask) that several FeatureDescriptors
+ * need: the gray image, other color conversions, the split channels, the 256 bin
+ * histograms of the channels and the MPEG7 Frame. Each is computed on first request and
+ * then shared by all descriptors that extract from the context, so computing many
+ * descriptors for one image makes one pass per intermediate instead of one per descriptor.
+ * A context caches lazily and must not be shared between threads.
+ */
+class ImageContext {
+
+public:
+
+	/**
+	 * @param img a CV_8UC1 or CV_8UC3 (BGR) image, not copied
+	 * @param mask optional CV_8UC1 mask, 255 for foreground pixels
+	 */
+	ImageContext(const cv::Mat& img, const cv::Mat& mask = cv::Mat());
+
+	// Getter
+	const cv::Mat& image() const;
+	const cv::Mat& mask() const;
+
+	/**
+	 * Gray version of the image, the image itself if it only has one channel
+	 */
+	const cv::Mat& gray();
+
+	/**
+	 * The image converted by cv::cvtColor with the given code, e.g. cv::COLOR_BGR2HSV
+	 */
+	const cv::Mat& converted(int code);
+
+	/**
+	 * The channels of the image as by cv::split
+	 */
+	const std::vector<cv::Mat>& channels();
+
+	/**
+	 * Counts of the 256 values of a channel within the mask. All channels are counted in
+	 * one pass over the image.
+	 */
+	const std::vector<size_t>& histogram(int channel);
+
+	/**
+	 * Exact quantile of a channel within the mask from its histogram: the first value
+	 * whose cumulated count exceeds q * pixels(), q in [0,1]. For q = 0.5 this is the
+	 * value with (0-based) rank pixels() / 2, as by valg::median. Zero without pixels.
+	 */
+	int quantile(int channel, double q);
+
+	/**
+	 * Number of pixels within the mask (all pixels without a mask)
+	 */
+	size_t pixels();
+
+	/**
+	 * Slot for the MPEG7 Frame of this image, empty until an MPEG7 descriptor fills it
+	 */
+	std::shared_ptr<Frame>& frame();
+
+private:
+
+	// Counts the histograms of all channels
+	void _count();
+
+	cv::Mat _img;
+	cv::Mat _mask;
+	cv::Mat _gray;
+	std::map<int,cv::Mat> _converted;
+	std::vector<cv::Mat> _channels;
+	std::vector<std::vector<size_t>> _histograms;
+	size_t _pixels;
+	std::shared_ptr<Frame> _frame;
+
+};
+
+}
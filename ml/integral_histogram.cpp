@@ -0,0 +1,221 @@
+#include "oceancv/ml/integral_histogram.h"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+namespace ocv {
+
+IntegralHistogram::IntegralHistogram(const cv::Mat& img, int bins, int cell, const cv::Mat& mask, int bin_size) : _size(img.size()), _channels(img.channels()), _bins(bins), _cell(cell) {
+	assert(img.depth() == CV_8U && (_channels == 1 || _channels == 3) && bins > 0 && bins <= 256 && cell > 0);
+	assert(mask.empty() || (mask.type() == CV_8UC1 && mask.rows == img.rows && mask.cols == img.cols));
+
+	if(bin_size <= 0)
+		bin_size = 256 / bins;
+	_lut.resize(256);
+	for(int v = 0; v < 256; v++)
+		_lut[v] = std::min(bins - 1, v / bin_size);
+
+	_cell_rows = (img.rows + cell - 1) / cell;
+	_cell_cols = (img.cols + cell - 1) / cell;
+
+	const size_t hist_width = _channels * _bins;
+	const size_t moment_width = 1 + 2 * _channels;
+	const size_t corners_per_row = _cell_cols + 1;
+	_hist.assign((_cell_rows + 1) * corners_per_row * hist_width, 0);
+	_moments.assign((_cell_rows + 1) * corners_per_row * moment_width, 0);
+
+	bool use_mask = !mask.empty();
+
+	// Sums of each cell, cumulated along the cell rows. Stripes of cell rows are independent.
+	int stripes = std::max(1, std::min(cv::getNumThreads(), _cell_rows));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		for(int s = range.start; s < range.end; s++) {
+			for(int cr = s * _cell_rows / stripes; cr < (s + 1) * _cell_rows / stripes; cr++) {
+
+				uint32_t* hist_row = &_hist[((cr + 1) * corners_per_row + 1) * hist_width];
+				uint64_t* moment_row = &_moments[((cr + 1) * corners_per_row + 1) * moment_width];
+
+				const uchar* px;
+				const uchar* m = 0;
+				for(int y = cr * cell; y < std::min(img.rows, (cr + 1) * cell); y++) {
+					px = img.ptr<uchar>(y);
+					if(use_mask)
+						m = mask.ptr<uchar>(y);
+					for(int x = 0; x < img.cols; x++, px += _channels) {
+						if(use_mask && m[x] != 255)
+							continue;
+						uint32_t* h = hist_row + (x / cell) * hist_width;
+						uint64_t* mo = moment_row + (x / cell) * moment_width;
+						mo[0]++;
+						for(int c = 0; c < _channels; c++) {
+							h[c * _bins + _lut[px[c]]]++;
+							mo[1 + c] += px[c];
+							mo[1 + _channels + c] += px[c] * px[c];
+						}
+					}
+				}
+
+				for(int cc = 1; cc < _cell_cols; cc++) {
+					for(size_t i = 0; i < hist_width; i++)
+						hist_row[cc * hist_width + i] += hist_row[(cc - 1) * hist_width + i];
+					for(size_t i = 0; i < moment_width; i++)
+						moment_row[cc * moment_width + i] += moment_row[(cc - 1) * moment_width + i];
+				}
+
+			}
+		}
+	});
+
+	// Cumulate down the columns, stripes of corner columns are independent
+	stripes = std::max(1, std::min(cv::getNumThreads(), _cell_cols + 1));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		for(int s = range.start; s < range.end; s++) {
+			size_t begin = s * corners_per_row / stripes;
+			size_t end = (s + 1) * corners_per_row / stripes;
+			for(int r = 2; r <= _cell_rows; r++) {
+				uint32_t* h = &_hist[r * corners_per_row * hist_width];
+				uint64_t* mo = &_moments[r * corners_per_row * moment_width];
+				for(size_t i = begin * hist_width; i < end * hist_width; i++)
+					h[i] += h[i - corners_per_row * hist_width];
+				for(size_t i = begin * moment_width; i < end * moment_width; i++)
+					mo[i] += mo[i - corners_per_row * moment_width];
+			}
+		}
+	});
+
+}
+
+void IntegralHistogram::_corners(const cv::Rect& tile, size_t& c00, size_t& c01, size_t& c10, size_t& c11) const {
+	assert(tile.x >= 0 && tile.y >= 0 && tile.width >= 0 && tile.height >= 0 && tile.x + tile.width <= _size.width && tile.y + tile.height <= _size.height);
+	assert(tile.x % _cell == 0 && tile.y % _cell == 0);
+	assert((tile.x + tile.width) % _cell == 0 || tile.x + tile.width == _size.width);
+	assert((tile.y + tile.height) % _cell == 0 || tile.y + tile.height == _size.height);
+
+	size_t x0 = tile.x / _cell;
+	size_t y0 = tile.y / _cell;
+	size_t x1 = (tile.x + tile.width + _cell - 1) / _cell;
+	size_t y1 = (tile.y + tile.height + _cell - 1) / _cell;
+	size_t corners_per_row = _cell_cols + 1;
+	c00 = y0 * corners_per_row + x0;
+	c01 = y0 * corners_per_row + x1;
+	c10 = y1 * corners_per_row + x0;
+	c11 = y1 * corners_per_row + x1;
+}
+
+void IntegralHistogram::histogram(const cv::Rect& tile, std::vector<uint32_t>& hist) const {
+	size_t c00, c01, c10, c11;
+	_corners(tile, c00, c01, c10, c11);
+	size_t width = _channels * _bins;
+	hist.resize(width);
+	for(size_t i = 0; i < width; i++)
+		hist[i] = _hist[c11 * width + i] - _hist[c01 * width + i] - _hist[c10 * width + i] + _hist[c00 * width + i];
+}
+
+size_t IntegralHistogram::pixels(const cv::Rect& tile) const {
+	size_t c00, c01, c10, c11;
+	_corners(tile, c00, c01, c10, c11);
+	size_t width = 1 + 2 * _channels;
+	return _moments[c11 * width] - _moments[c01 * width] - _moments[c10 * width] + _moments[c00 * width];
+}
+
+void IntegralHistogram::moments(const cv::Rect& tile, std::vector<double>& mean, std::vector<double>& stddev) const {
+	size_t c00, c01, c10, c11;
+	_corners(tile, c00, c01, c10, c11);
+	size_t width = 1 + 2 * _channels;
+
+	uint64_t sums[7];
+	for(size_t i = 0; i < width; i++)
+		sums[i] = _moments[c11 * width + i] - _moments[c01 * width + i] - _moments[c10 * width + i] + _moments[c00 * width + i];
+
+	mean.assign(_channels, 0);
+	stddev.assign(_channels, 0);
+	if(sums[0] == 0)
+		return;
+	for(int c = 0; c < _channels; c++) {
+		mean[c] = 1. * sums[1 + c] / sums[0];
+		stddev[c] = std::sqrt(std::max(0., 1. * sums[1 + _channels + c] / sums[0] - mean[c] * mean[c]));
+	}
+}
+
+template<class T>
+void IntegralHistogram::histograms(const std::vector<cv::Rect>& tiles, cv::Mat_<T>& dst) const {
+	int num = tiles.size();
+	int width = _channels * _bins;
+	if(dst.empty())
+		dst = cv::Mat_<T>(num, width);
+	assert(dst.rows == num && dst.cols == width);
+	if(num == 0)
+		return;
+
+	int stripes = std::max(1, std::min(cv::getNumThreads(), num));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		std::vector<uint32_t> hist;
+		for(int s = range.start; s < range.end; s++) {
+			for(int t = s * num / stripes; t < (s + 1) * num / stripes; t++) {
+				histogram(tiles[t], hist);
+				size_t num_pix = pixels(tiles[t]);
+				T* row = dst[t];
+				for(int i = 0; i < width; i++)
+					row[i] = num_pix > 0 ? (1./T(num_pix)) * hist[i] : 0;
+			}
+		}
+	});
+}
+
+template<class T>
+void IntegralHistogram::moments(const std::vector<cv::Rect>& tiles, cv::Mat_<T>& dst) const {
+	int num = tiles.size();
+	if(dst.empty())
+		dst = cv::Mat_<T>(num, 2 * _channels);
+	assert(dst.rows == num && dst.cols == 2 * _channels);
+	if(num == 0)
+		return;
+
+	int stripes = std::max(1, std::min(cv::getNumThreads(), num));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		std::vector<double> mean, stddev;
+		for(int s = range.start; s < range.end; s++) {
+			for(int t = s * num / stripes; t < (s + 1) * num / stripes; t++) {
+				moments(tiles[t], mean, stddev);
+				T* row = dst[t];
+				for(int c = 0; c < _channels; c++) {
+					row[c] = mean[c];
+					row[_channels + c] = stddev[c];
+				}
+			}
+		}
+	});
+}
+
+std::vector<cv::Rect> IntegralHistogram::grid(const cv::Size& size, const cv::Size& tile, const cv::Size& step) {
+	assert(tile.width > 0 && tile.height > 0 && step.width > 0 && step.height > 0);
+	std::vector<cv::Rect> ret;
+	for(int y = 0; y + tile.height <= size.height; y += step.height)
+		for(int x = 0; x + tile.width <= size.width; x += step.width)
+			ret.push_back(cv::Rect(x, y, tile.width, tile.height));
+	return ret;
+}
+
+int IntegralHistogram::bins() const {
+	return _bins;
+}
+
+int IntegralHistogram::channels() const {
+	return _channels;
+}
+
+int IntegralHistogram::cell() const {
+	return _cell;
+}
+
+cv::Size IntegralHistogram::size() const {
+	return _size;
+}
+
+template void IntegralHistogram::histograms<float>(const std::vector<cv::Rect>& tiles, cv::Mat_<float>& dst) const;
+template void IntegralHistogram::histograms<double>(const std::vector<cv::Rect>& tiles, cv::Mat_<double>& dst) const;
+template void IntegralHistogram::moments<float>(const std::vector<cv::Rect>& tiles, cv::Mat_<float>& dst) const;
+template void IntegralHistogram::moments<double>(const std::vector<cv::Rect>& tiles, cv::Mat_<double>& dst) const;
+
+}
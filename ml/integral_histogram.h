@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "opencv2/core.hpp"
+
+namespace ocv {
+
+/**
+ * Integral histogram (and summed area tables of the channel moments) of a CV_8UC1 or
+ * CV_8UC3 image. After one pass over the image, the histogram, pixel count, mean and
+ * standard deviation of any axis-aligned tile are read from four corners in O(bins),
+ * independent of the tile size. Overlapping and multi-scale tile grids thereby cost
+ * no additional passes over the pixels.
+ * The tables are stored on a grid of cells of cell x cell pixels to bound the memory:
+ * tiles need to start and end on cell borders (or at the image border). Choose the
+ * greatest common divisor of the tile positions and sizes, e.g. the step of a grid.
+ * Counts and sums are integers, so all results are exact.
+ */
+class IntegralHistogram {
+
+public:
+
+	/**
+	 * Constructor, computes the tables in parallel.
+	 * @param img CV_8UC1 or CV_8UC3 image
+	 * @param bins the number of bins per channel
+	 * @param cell the edge length of the cells in pixels
+	 * @param mask optional CV_8UC1 mask, only pixels with value 255 are counted
+	 * @param bin_size value v is counted in bin min(bins-1, v/bin_size), 256/bins if zero.
+	 * Pass the bin size of a HistogramColorDescriptor to get identical histograms.
+	 */
+	IntegralHistogram(const cv::Mat& img, int bins, int cell = 1, const cv::Mat& mask = cv::Mat(), int bin_size = 0);
+
+	/**
+	 * Absolute counts of the tile, channels() blocks of bins() values
+	 */
+	void histogram(const cv::Rect& tile, std::vector<uint32_t>& hist) const;
+
+	/**
+	 * Number of (unmasked) pixels in the tile
+	 */
+	size_t pixels(const cv::Rect& tile) const;
+
+	/**
+	 * Mean and standard deviation (population) per channel of the tile, as by cv::meanStdDev
+	 */
+	void moments(const cv::Rect& tile, std::vector<double>& mean, std::vector<double>& stddev) const;
+
+	/**
+	 * Relative histograms of many tiles, one row per tile in the layout of the
+	 * HistogramColorDescriptor. Rows of tiles without pixels are zero. If dst is empty
+	 * it is allocated.
+	 */
+	template<class T>
+	void histograms(const std::vector<cv::Rect>& tiles, cv::Mat_<T>& dst) const;
+
+	/**
+	 * Means and standard deviations of many tiles, one row per tile with the means of
+	 * all channels followed by their standard deviations. If dst is empty it is allocated.
+	 */
+	template<class T>
+	void moments(const std::vector<cv::Rect>& tiles, cv::Mat_<T>& dst) const;
+
+	/**
+	 * Tiles of the given size at the given step over an image, tiles that would exceed
+	 * the image are left out. Steps smaller than the tile give overlapping tiles,
+	 * concatenating grids of several tile sizes gives a multi-scale grid.
+	 */
+	static std::vector<cv::Rect> grid(const cv::Size& size, const cv::Size& tile, const cv::Size& step);
+
+	// Getter
+	int bins() const;
+	int channels() const;
+	int cell() const;
+	cv::Size size() const;
+
+private:
+
+	// Cell corners of a tile, asserts that it is aligned to the cells
+	void _corners(const cv::Rect& tile, size_t& c00, size_t& c01, size_t& c10, size_t& c11) const;
+
+	cv::Size _size;
+	int _channels;
+	int _bins;
+	int _cell;
+	int _cell_rows;
+	int _cell_cols;
+
+	// Bin of each value
+	std::vector<int> _lut;
+
+	// Cumulated counts, (cell rows + 1) x (cell cols + 1) corners of channels * bins values
+	std::vector<uint32_t> _hist;
+
+	// Cumulated pixel count, sums and squared sums per channel at each corner
+	std::vector<uint64_t> _moments;
+
+};
+
+}
@@ -3,54 +3,147 @@
 namespace ocv {
 
 template<class T>
-LinearRegression<T>::LinearRegression(const cv::Mat_<T> mat, cv::Mat_<T> y) {
-	
-	assert(mat.rows == y.rows && y.cols == 1);
-	
-	// It is assumed that the data is not centered
-	this->_x_mean = ocv::malg<T>::mean(mat);
-	this->_x_centered = mat;
-	ocv::malg<T>::applyMean(this->_x_centered,this->_x_mean);
-		
-	this->_y_mean = ocv::valg<T>::mean(y);
-	this->_y_centered = y - this->_y_mean;
-	
-	// Calculate coefficients
-	cv::Mat_<T> x_trans, inv;
-	ocv::malg<T>::transpose(this->_x_centered,x_trans);
-	cv::invert(x_trans * this->_x_centered,inv);
-	this->_coefficients = inv * x_trans * this->_y_centered;
-	
-	// Calculate intersect
-	this->_intersect = this->_y_mean - ocv::valg<T>::sumElements(this->_coefficients * this->_x_mean);
-	
-	// Calculate sum of squared differences
-	this->_ssd = 0;
-	cv::Mat_<T> tmp_y = this->_y_centered + this->_y_mean;
-	for(int i = 0; i < this->_x_centered.rows; i++) {
-		T approx = ocv::valg<T>::sumElements((this->_x_centered(i) + this->_x_mean) * this->_coefficients) + this->_intersect;
-		this->_ssd += std::pow(approx-tmp_y(i),2);
+LinearRegression<T>::LinearRegression(const cv::Mat_<T> mat, cv::Mat_<T> y, T ridge) : LinearRegression(mat.cols, y.cols, ridge) {
+	this->partialFit(mat,y);
+}
+
+template<class T>
+LinearRegression<T>::LinearRegression(int dims, int targets, T ridge) : _dims(dims), _targets(targets), _ridge(ridge), _count(0) {
+
+	assert(dims > 0 && targets > 0 && ridge >= 0);
+
+	this->_mean = cv::Mat_<double>(1,dims + targets,0.0);
+	this->_scatter = cv::Mat_<double>(dims + targets,dims + targets,0.0);
+
+	this->_coefficients = cv::Mat_<T>(dims,targets,(T) 0);
+	this->_intersect = cv::Mat_<T>(1,targets,(T) 0);
+	this->_ssd = cv::Mat_<T>(1,targets,(T) 0);
+	this->_determination = cv::Mat_<T>(1,targets,(T) 0);
+
+}
+
+template<class T>
+void LinearRegression<T>::partialFit(const cv::Mat_<T>& mat, const cv::Mat_<T>& y) {
+	this->_merge(mat,y);
+	this->_solve();
+}
+
+template<class T>
+void LinearRegression<T>::partialFit(const ocv::MatPair<T,T>& mp) {
+	this->partialFit(mp.i(),mp.o());
+}
+
+template<class T>
+void LinearRegression<T>::partialFit(const ocv::MatPairView<T,T>& view) {
+	assert(view.rows() > 0);
+	view.forEachBlock(4096,[this](const cv::Mat_<T>& mat, const cv::Mat_<T>& y) {
+		this->_merge(mat,y);
+	});
+	this->_solve();
+}
+
+template<class T>
+void LinearRegression<T>::_merge(const cv::Mat_<T>& mat, const cv::Mat_<T>& y) {
+
+	assert(mat.rows == y.rows && mat.rows > 0);
+	assert(mat.cols == this->_dims && y.cols == this->_targets);
+
+	// Join x and y, so one scatter Mat holds XᵀX, Xᵀy and yᵀy
+	cv::Mat_<double> joined(mat.rows,this->_dims + this->_targets);
+	for(int i = 0; i < mat.rows; i++) {
+		double* row = joined.template ptr<double>(i);
+		std::copy(mat.template ptr<T>(i),mat.template ptr<T>(i) + this->_dims,row);
+		std::copy(y.template ptr<T>(i),y.template ptr<T>(i) + this->_targets,row + this->_dims);
 	}
-	
-	// Calculate determination
-	T denominator = 0;
-	for(int i = 0; i < this->_y_centered.rows; i++) {
-		denominator += pow(this->_y_centered(i),2);
+
+	cv::Mat_<double> chunk_mean = ocv::malg<double>::mean(joined);
+	cv::Mat_<double> chunk_scatter;
+	ocv::malg<double>::scatterMat(joined,chunk_mean,chunk_scatter);
+
+	// Pairwise merge with the previous chunks
+	const double n_a = this->_count, n_b = mat.rows, n = n_a + n_b;
+	cv::Mat_<double> delta = chunk_mean - this->_mean;
+	cv::Mat_<double> correction;
+	cv::mulTransposed(delta,correction,true);
+	this->_scatter += chunk_scatter + correction * (n_a * n_b / n);
+	this->_mean += delta * (n_b / n);
+	this->_count += mat.rows;
+
+}
+
+template<class T>
+void LinearRegression<T>::_solve() {
+
+	const int d = this->_dims;
+	const cv::Range x_range(0,d), y_range(d,d + this->_targets);
+
+	cv::Mat_<double> sxx = this->_scatter(x_range,x_range);
+	cv::Mat_<double> sxy = this->_scatter(x_range,y_range);
+
+	// One factorisation for all targets, the SVD handles singular scatter Mats
+	cv::Mat_<double> a = sxx + cv::Mat_<double>::eye(d,d) * (double) this->_ridge;
+	cv::Mat_<double> coefficients;
+	if(!cv::solve(a,sxy,coefficients,cv::DECOMP_CHOLESKY))
+		cv::solve(a,sxy,coefficients,cv::DECOMP_SVD);
+	coefficients.convertTo(this->_coefficients,cv::DataType<T>::depth);
+
+	cv::Mat_<double> x_mean = this->_mean.colRange(x_range);
+	for(int t = 0; t < this->_targets; t++) {
+
+		cv::Mat_<double> c = coefficients.col(t);
+
+		// Calculate intersect
+		this->_intersect(t) = this->_mean(d + t) - x_mean.dot(cv::Mat_<double>(c.t()));
+
+		// Calculate sum of squared differences from the scatter: syy - 2 cᵀsxy + cᵀsxx c
+		double syy = this->_scatter(d + t,d + t);
+		double ssd = syy - 2 * c.dot(sxy.col(t)) + c.dot(cv::Mat_<double>(sxx * c));
+		ssd = std::max(ssd,0.0);
+		this->_ssd(t) = ssd;
+
+		// Calculate determination, a constant response is explained completely
+		this->_determination(t) = syy > 0 ? 1 - ssd / syy : 1;
+
 	}
-	this->_determination = 1 - this->_ssd/denominator;
-	
+
 }
 
 template<class T>
-T LinearRegression<T>::predict(cv::Mat_<T> x) {
-	assert(x.rows == this->_x_mean.rows && x.cols == 1);
-	return ocv::valg<T>::sumElements(this->_coefficients*x) + this->_intersect;
+T LinearRegression<T>::predict(cv::Mat_<T> x, int target) {
+	assert((int) x.total() == this->_dims && x.isContinuous());
+	assert(target >= 0 && target < this->_targets);
+	T ret = this->_intersect(target);
+	const T* v = x.template ptr<T>(0);
+	for(int i = 0; i < this->_dims; i++)
+		ret += v[i] * this->_coefficients(i,target);
+	return ret;
 }
 
 template<class T>
 cv::Mat_<T> LinearRegression<T>::predictMat(cv::Mat_<T> x) {
-	assert(x.rows == this->_x_mean.rows);
-	return x*this->_coefficients + this->_intersect;
+
+	assert(x.cols == this->_dims);
+
+	cv::Mat_<T> ret(x.rows,this->_targets);
+	const int stripes = std::max(1, std::min(cv::getNumThreads(), x.rows / 1024));
+	cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+		cv::Mat_<T> tmp;
+		for(int s = range.start; s < range.end; s++) {
+			int begin = (size_t) s * x.rows / stripes, end = (size_t) (s + 1) * x.rows / stripes;
+			if(begin == end)
+				continue;
+			cv::gemm(x.rowRange(begin, end), this->_coefficients, 1, cv::Mat(), 0, tmp);
+			for(int i = 0; i < tmp.rows; i++) {
+				const T* y = tmp.template ptr<T>(i);
+				T* r = ret.template ptr<T>(begin + i);
+				for(int t = 0; t < this->_targets; t++)
+					r[t] = y[t] + this->_intersect(t);
+			}
+		}
+	});
+
+	return ret;
+
 }
 
 
@@ -58,18 +151,18 @@ template<class T>
 LinearRegression<T>::~LinearRegression() {}
 
 template<class T>
-T LinearRegression<T>::determination() const {
-	return this->_determination;
+T LinearRegression<T>::determination(int target) const {
+	return this->_determination(target);
 }
 
 template<class T>
-T LinearRegression<T>::sumOfSquaredDifferences() const {
-	return this->_ssd;
+T LinearRegression<T>::sumOfSquaredDifferences(int target) const {
+	return this->_ssd(target);
 }
 
 template<class T>
-T LinearRegression<T>::yIntersect() const {
-	return this->_intersect;
+T LinearRegression<T>::yIntersect(int target) const {
+	return this->_intersect(target);
 }
 
 template<class T>
@@ -77,6 +170,26 @@ cv::Mat_<T> LinearRegression<T>::regressionCoefficients() const {
 	return this->_coefficients;
 }
 
+template<class T>
+size_t LinearRegression<T>::count() const {
+	return this->_count;
+}
+
+template<class T>
+int LinearRegression<T>::dims() const {
+	return this->_dims;
+}
+
+template<class T>
+int LinearRegression<T>::targets() const {
+	return this->_targets;
+}
+
+template<class T>
+T LinearRegression<T>::ridge() const {
+	return this->_ridge;
+}
+
 
 template class LinearRegression<float>;
 template class LinearRegression<double>;
@@ -3,47 +3,98 @@
 #include "opencv2/opencv.hpp"
 
 #include "oceancv/ml/mat_algorithms.h"
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/mat_pair_view.h"
 
 namespace ocv {
 
 /**
  * Calculates the regression function for a given given dataset (X = mat,y).
  * Each row of X (i.e. each feature vector x) contains one observation of the covariables.
- * The i-th component of y contains the response for the i-th row of X.
- * Therefore X.rows == y.cols must hold (y.rows = 1).
+ * The i-th row of y contains the responses for the i-th row of X, one column per target.
+ * Therefore X.rows == y.rows must hold.
+ *
+ * The data can also be given in chunks with partialFit(). Only the means and the
+ * scatter Mats of X and y are kept (merged pairwise in double precision), so neither
+ * the design matrix nor centered copies of it are stored. All targets share one
+ * Cholesky factorisation of the (ridge regularised) scatter Mat of X.
  **/
 template<class T>
 class LinearRegression {
 public:
-	
-	LinearRegression(const cv::Mat_<T> mat, cv::Mat_<T> y);
-	
+
+	/**
+	 * Fits the regression to the whole dataset.
+	 * @param ridge the weight of the L2 penalty on the coefficients (not on the intersect)
+	 */
+	LinearRegression(const cv::Mat_<T> mat, cv::Mat_<T> y, T ridge = 0);
+
+	/**
+	 * Creates an empty regression to be fitted by partialFit().
+	 * @param dims the number of covariables (columns of X)
+	 * @param targets the number of responses (columns of y)
+	 */
+	LinearRegression(int dims, int targets = 1, T ridge = 0);
+
 	~LinearRegression();
-	
-	// Predict the y-value for the given feature vector or matrix of vectors
-	T predict(cv::Mat_<T> vec);
+
+	/**
+	 * Adds the rows of one chunk and updates the regression.
+	 */
+	void partialFit(const cv::Mat_<T>& mat, const cv::Mat_<T>& y);
+
+	/**
+	 * Adds a chunk with X as input and y as output, e.g. from MatChunkReader::next.
+	 */
+	void partialFit(const ocv::MatPair<T,T>& mp);
+
+	/**
+	 * Adds all rows of the view (X as input, y as output) and updates the regression
+	 * once. The view is merged in blocks of rows and not copied.
+	 */
+	void partialFit(const ocv::MatPairView<T,T>& view);
+
+	// Predict the y-value of one target for the given feature vector
+	T predict(cv::Mat_<T> vec, int target = 0);
+
+	// Predict all targets for each row of the matrix, in parallel
 	cv::Mat_<T> predictMat(cv::Mat_<T> mat);
-	
+
 	// Getter functions
-	T determination() const;
-	T sumOfSquaredDifferences() const;
-	T yIntersect() const;
+	T determination(int target = 0) const;
+	T sumOfSquaredDifferences(int target = 0) const;
+	T yIntersect(int target = 0) const;
+	// One column of coefficients per target
 	cv::Mat_<T> regressionCoefficients() const;
-	
+	size_t count() const;
+	int dims() const;
+	int targets() const;
+	T ridge() const;
+
 protected:
-	
-	T _determination;
-	T _ssd;
-	T _intersect;
-	
+
+	// Merges the means and scatter of a chunk into the accumulators
+	void _merge(const cv::Mat_<T>& mat, const cv::Mat_<T>& y);
+
+	// Solves for the coefficients from the current means and scatter
+	void _solve();
+
+	// One value per target
+	cv::Mat_<T> _determination;
+	cv::Mat_<T> _ssd;
+	cv::Mat_<T> _intersect;
+
 	cv::Mat_<T> _coefficients;
-	
-	cv::Mat_<T> _x_centered;
-	cv::Mat_<T> _y_centered;
-	
-	cv::Mat_<T> _x_mean;
-	T _y_mean;
-	
+
+	int _dims;
+	int _targets;
+	T _ridge;
+	size_t _count;
+
+	// Mean and scatter of the joined rows [x y]
+	cv::Mat_<double> _mean;
+	cv::Mat_<double> _scatter;
+
 };
 
 }
@@ -22,39 +22,35 @@ namespace ocv {
 	void malg<T>::autoCorrelation(const cv::Mat_<T>& m, cv::Mat_<T>& dst) {
 	    assert(m.rows > 0);
 	    assert(m.cols > 0);
-	    dst = cv::Mat_<T>(m.cols, m.cols);
-	    dst = static_cast<T>(0);
-	    for(int i = 0; i < m.rows; i++) {
-	        for(int j = 0; j < m.rows; j++) {
-	            for(int k = 0; k < m.cols; k++) {
-	            	dst(j,k) += m(i,j) * m(i,k) / m.rows;
-	            }
-	        }
-	    }
+	    ocv::malg<T>::scatterMat(m, cv::Mat_<T>(), dst, 1. / m.rows);
 	}
 
 	template<class T>
 	void malg<T>::covarianceMat(const cv::Mat_<T>& m, cv::Mat_<T>& dst) {
 	    assert(m.rows > 0);
 	    assert(m.cols > 0);
-		
-	    dst = cv::Mat_<T>(m.cols, m.cols, T(0));
-	    cv::Mat_<T> allmean = ocv::malg<T>::mean(m);
-
-	    for(int i = 0; i < m.rows-1; i++) {
-	        for(int j = 0; j < m.cols; j++) {
-	            for(int k = 0; k < m.cols; k++) {
-	            	dst(j,k) = (1. - 1. / (i + 1)) * dst(j,k) + 1. / (i + 1) * (m(i,j) - allmean(j)) * (m(i,k) - allmean(k));
-	            }
-	        }
-	    }
+	    // Unbiased estimate, a single row has zero scatter anyways
+	    ocv::malg<T>::scatterMat(m, ocv::malg<T>::mean(m), dst, 1. / std::max(m.rows - 1, 1));
+	}
 
-	    for(int j = 0; j < m.cols; j++) {
-			for(int k = 0; k < m.cols; k++) {
-				dst(j,k) = dst(j,k) + 1. / (m.rows-1) * (m(m.rows-1,j) - allmean(j)) * (m(m.rows-1,k) - allmean(k));
-			}
+	template<class T>
+	void malg<T>::scatterMat(const cv::Mat_<T>& m, const cv::Mat_<T>& mean, cv::Mat_<T>& dst, double scale) {
+		assert(mean.empty() || (int) mean.total() == m.cols);
+		// An empty delta Mat means no centering
+		cv::Mat delta;
+		if(!mean.empty())
+			delta = mean.reshape(1,1);
+		if(cv::DataType<T>::depth == CV_32F || cv::DataType<T>::depth == CV_64F) {
+			cv::mulTransposed(m, dst, true, delta, scale, cv::DataType<T>::depth);
+		} else {
+			// Integer data is multiplied in double precision to avoid overflows
+			cv::Mat tmp_m, tmp_delta, tmp_dst;
+			m.convertTo(tmp_m, CV_64F);
+			if(!delta.empty())
+				delta.convertTo(tmp_delta, CV_64F);
+			cv::mulTransposed(tmp_m, tmp_dst, true, tmp_delta, scale, CV_64F);
+			tmp_dst.convertTo(dst, cv::DataType<T>::depth);
 		}
-
 	}
 
 	template<class T>
@@ -30,6 +30,16 @@ public:
      */
 	static void covarianceMat(const cv::Mat_<T>& m, cv::Mat_<T>& dst);
 	
+	/**
+	 * Computes the scatter Mat scale * sum_i (m_i - mean)^T * (m_i - mean) as one
+	 * symmetric rank-k update (cv::mulTransposed) instead of per-element loops.
+	 * @param m the data, one vector per row
+	 * @param mean the vector to subtract from each row, no centering if empty
+	 * @param dst the resulting m.cols x m.cols Mat
+	 * @param scale factor applied to the sum
+	 */
+	static void scatterMat(const cv::Mat_<T>& m, const cv::Mat_<T>& mean, cv::Mat_<T>& dst, double scale = 1);
+	
 	/**
      * Calculate mean vector of elements (the center point)
      */
@@ -0,0 +1,105 @@
+#include "oceancv/ml/mat_chunk_reader.h"
+
+#include <cstdlib>
+
+namespace ocv {
+
+	template <class T>
+	MatChunkReader<T>::MatChunkReader(const std::string& path, int chunk_rows, char col_split, bool has_header) : _path(path), _chunk_rows(chunk_rows), _col_split(col_split), _has_header(has_header), _cols(-1), _rows_read(0) {
+		assert(_chunk_rows > 0);
+		rewind();
+	}
+
+	template <class T>
+	void MatChunkReader<T>::rewind() {
+		_file.close();
+		_file.clear();
+		_file.open(_path);
+		_rows_read = 0;
+		if(_has_header)
+			std::getline(_file, _line);
+	}
+
+	template <class T>
+	int MatChunkReader<T>::_parse(const std::string& line) {
+
+		_values.clear();
+		const char* p = line.c_str();
+		const char* end = p + line.size();
+		char* next;
+
+		// strtod skips leading whitespace, so only the separators need to be stepped over
+		while(p < end) {
+			double v = std::strtod(p, &next);
+			if(next == p)
+				break;
+			_values.push_back(static_cast<T>(v));
+			p = next;
+			while(p < end && (*p == _col_split || *p == ' ' || *p == '\r'))
+				p++;
+		}
+		return _values.size();
+
+	}
+
+	template <class T>
+	bool MatChunkReader<T>::next(cv::Mat_<T>& chunk) {
+
+		chunk.release();
+		if(!_file.is_open())
+			return false;
+
+		int rows = 0;
+		while(rows < _chunk_rows && std::getline(_file, _line)) {
+
+			int n = _parse(_line);
+			if(n == 0)
+				continue;
+
+			if(_cols < 0)
+				_cols = n;
+			assert(n == _cols);
+
+			if(chunk.empty())
+				chunk.create(_chunk_rows, _cols);
+			std::copy(_values.begin(), _values.end(), chunk.template ptr<T>(rows));
+			rows++;
+
+		}
+
+		if(rows == 0) {
+			chunk.release();
+			return false;
+		}
+
+		if(rows < _chunk_rows)
+			chunk = chunk.rowRange(0, rows);
+		_rows_read += rows;
+		return true;
+
+	}
+
+	template <class T>
+	bool MatChunkReader<T>::isOpen() const {
+		return _file.is_open();
+	}
+
+	template <class T>
+	int MatChunkReader<T>::cols() const {
+		return _cols;
+	}
+
+	template <class T>
+	int MatChunkReader<T>::chunkRows() const {
+		return _chunk_rows;
+	}
+
+	template <class T>
+	size_t MatChunkReader<T>::rowsRead() const {
+		return _rows_read;
+	}
+
+	template class MatChunkReader<float>;
+	template class MatChunkReader<double>;
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+
+#include "oceancv/ml/mat_pair.h"
+
+namespace ocv {
+
+	/**
+	 * Reads a delimited ASCI feature file (one feature vector per line) in blocks of rows,
+	 * so files larger than the available memory can be processed chunk by chunk.
+	 * Only one chunk is held in memory at a time.
+	 */
+	template <class T>
+	class MatChunkReader {
+	public:
+
+		/**
+		 * Opens the file.
+		 * @param path the path to the ASCI file
+		 * @param chunk_rows the maximum number of rows returned by one call of next()
+		 * @param col_split the character that separates the values in a line
+		 * @param has_header whether the first line holds column names and shall be skipped
+		 */
+		MatChunkReader(const std::string& path, int chunk_rows = 4096, char col_split = ',', bool has_header = false);
+
+		/**
+		 * Reads the next block of at most chunkRows() rows.
+		 * @return false if the end of the file was reached and chunk is empty
+		 */
+		bool next(cv::Mat_<T>& chunk);
+
+		/**
+		 * Reads the next block and splits each row into the first i_cols input values and
+		 * the remaining output values.
+		 */
+		template <class T2>
+		bool next(ocv::MatPair<T,T2>& chunk, int i_cols) {
+			cv::Mat_<T> tmp;
+			if(!next(tmp))
+				return false;
+			assert(i_cols <= tmp.cols);
+			cv::Mat_<T2> o;
+			tmp.colRange(i_cols, tmp.cols).convertTo(o, cv::DataType<T2>::depth);
+			chunk = ocv::MatPair<T,T2>(tmp.colRange(0, i_cols).clone(), o);
+			return true;
+		}
+
+		/**
+		 * Starts reading from the first data row again.
+		 */
+		void rewind();
+
+		// Getter
+		bool isOpen() const;
+		int cols() const;
+		int chunkRows() const;
+		size_t rowsRead() const;
+
+	private:
+
+		// Parses one line into _values, returns the number of values
+		int _parse(const std::string& line);
+
+		std::string _path;
+		std::ifstream _file;
+		int _chunk_rows;
+		char _col_split;
+		bool _has_header;
+
+		// Determined from the first data row
+		int _cols;
+
+		size_t _rows_read;
+
+		// Line and value buffers that are reused for all rows
+		std::string _line;
+		std::vector<T> _values;
+
+	};
+
+}
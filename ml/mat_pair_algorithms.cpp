@@ -27,27 +27,70 @@ namespace ocv {
 		
 	    assert(mp.rows() > 0);
 	    assert(mp.iCols() > 0);
-	    assert(mp.rows() < idx);
+	    assert(idx < mp.oCols());
 		
+		// Gather the rows of the class
 	    size_t counter = 0;
-	    dst = cv::Mat_<T1>(mp.iCols(), mp.iCols(), (T1) 0);
-	    cv::Mat_<T1> allmean = ocv::malg<T1>::mean(mp.i());
-
 	    for(int i = 0; i < mp.rows(); i++) {
-	        if(mp.o(i,idx) == class_label) {
+	        if(mp.o(i,idx) == class_label)
 	        	counter++;
-		        for(int j = 0; j < mp.iCols(); j++) {
-	    	        for(int k = 0; k < mp.iCols(); k++) {
-	    	        	dst(j,k) = (1. - 1.f / counter) * dst(j,k) + 1.f / counter * (mp.i(i,j) - allmean(j)) * (mp.i(i,k) - allmean(k));
-	    	        }
-	    	    }
-	    	}
 	    }
+	    if(counter == 0) {
+	    	dst = cv::Mat_<T1>(mp.iCols(), mp.iCols(), (T1) 0);
+	    	return 0;
+	    }
+	    
+	    cv::Mat_<T1> class_mat(counter, mp.iCols());
+	    counter = 0;
+	    for(int i = 0; i < mp.rows(); i++) {
+	        if(mp.o(i,idx) == class_label)
+	        	std::copy(mp.iBegin(i),mp.iEnd(i),class_mat.template ptr<T1>(counter++));
+	    }
+		
+		// Deviations are taken from the mean of all vectors, not of the class
+	    ocv::malg<T1>::scatterMat(class_mat, ocv::malg<T1>::mean(mp.i()), dst, 1. / counter);
 		
 		return counter;
 	
 	}
 	
+	template<class T1, class T2>
+	int mpalg<T1,T2>::covarianceMats(const ocv::MatPair<T1,T2>& mp, std::map<T2,cv::Mat_<T1>>& dst, int idx) {
+		
+	    assert(mp.rows() > 0);
+	    assert(mp.iCols() > 0);
+	    assert(idx < mp.oCols());
+		
+		dst.clear();
+		
+		// Count class sizes to allocate each class Mat once
+		std::map<T2,int> class_sizes;
+		for(int i = 0; i < mp.rows(); i++) {
+			class_sizes[mp.o(i,idx)]++;
+		}
+		
+		std::map<T2,cv::Mat_<T1>> class_mats;
+		std::map<T2,int> fill;
+		for(auto cs : class_sizes) {
+			class_mats[cs.first] = cv::Mat_<T1>(cs.second, mp.iCols());
+			fill[cs.first] = 0;
+		}
+		
+		// Group all rows in one pass
+		for(int i = 0; i < mp.rows(); i++) {
+			T2 label = mp.o(i,idx);
+			std::copy(mp.iBegin(i),mp.iEnd(i),class_mats[label].template ptr<T1>(fill[label]++));
+		}
+		
+		cv::Mat_<T1> allmean = ocv::malg<T1>::mean(mp.i());
+		for(auto cs : class_sizes) {
+			ocv::malg<T1>::scatterMat(class_mats[cs.first], allmean, dst[cs.first], 1. / cs.second);
+		}
+		
+		return class_sizes.size();
+		
+	}
+	
 	template<class T1, class T2>
 	int mpalg<T1,T2>::mean(const ocv::MatPair<T1,T2>& mp, cv::Mat_<T1>& mean, T2 class_label, int o_col_idx) {
 		
@@ -96,7 +139,7 @@ namespace ocv {
 	}
 
 	template<class T1, class T2>
-	void mpalg<T1,T2>::selectInputColumns(const ocv::MatPair<T1,T2> mp, ocv::MatPair<T1,T2>& dst, const std::vector<int> selection_vector) {
+	void mpalg<T1,T2>::selectInputColumns(const ocv::MatPair<T1,T2>& mp, ocv::MatPair<T1,T2>& dst, const std::vector<int>& selection_vector) {
 		
 		assert(mp.iCols() == (int)selection_vector.size());
 		
@@ -123,7 +166,7 @@ namespace ocv {
     }
 
     template<class T1, class T2>
-    int mpalg<T1,T2>::selectRows(const ocv::MatPair<T1,T2> mp, ocv::MatPair<T1,T2>& dst, const std::vector<int> selection_vector) {
+    int mpalg<T1,T2>::selectRows(const ocv::MatPair<T1,T2>& mp, ocv::MatPair<T1,T2>& dst, const std::vector<int>& selection_vector) {
 		
 		assert(mp.rows() == (int)selection_vector.size());
 		
@@ -239,23 +282,18 @@ namespace ocv {
 			class_sizes[mp.o(i,o_col_idx)]++;
 		}
 		
-		cv::Mat_<T1> input;
-		size_t idx;
-		
+		// Allocate one Mat per class, the indicator maps a label to its Mat
 		for(auto cs : class_sizes) {
+			indicator[cs.first] = dst.size();
+			dst.push_back(cv::Mat_<T1>(cs.second,mp.iCols()));
+		}
 		
-			input = cv::Mat_<T1>(cs.second,mp.iCols());
-			idx = 0;
-			
-			for(int i = 0; i < mp.rows(); i++) {
-				if(mp.o(i,o_col_idx) == cs.first) {
-					std::copy(mp.iBegin(i),mp.iEnd(i),input.begin()+idx*input.cols);
-					idx++;
-				}
-			}
-			
-			dst.push_back(input);
-		
+		// Distribute the rows in one pass
+		std::vector<size_t> idx(dst.size(),0);
+		int c;
+		for(int i = 0; i < mp.rows(); i++) {
+			c = indicator[mp.o(i,o_col_idx)];
+			std::copy(mp.iBegin(i),mp.iEnd(i),dst[c].template ptr<T1>(idx[c]++));
 		}
 		
 	}
@@ -265,7 +303,7 @@ namespace ocv {
 		
 		std::random_device rd;
 		std::mt19937 rng(rd());
-		std::uniform_int_distribution<int> uni(0,items);
+		std::uniform_int_distribution<int> uni(0,mp.rows()-1);
 
 		cv::Mat_<T1> input(items,mp.iCols());
 		cv::Mat_<T2> output(items,mp.oCols());
@@ -275,6 +313,7 @@ namespace ocv {
 			rnd = uni(rng);
 			std::copy(mp.iBegin(rnd),mp.iEnd(rnd),input.begin()+idx*input.cols);
 			std::copy(mp.oBegin(rnd),mp.oEnd(rnd),output.begin()+idx*output.cols);
+			idx++;
 		}
 
 		dst = ocv::MatPair<T1,T2>(input,output);
@@ -36,6 +36,16 @@ public:
      */
 	static int covarianceMat(const ocv::MatPair<T1,T2>& mp, cv::Mat_<T1>& dst, T2 class_label, int idx = 0);
 	
+	/**
+     * Calculates the covariance Mats of all classes in one pass over the MatPair. Each
+     * Mat equals the one that covarianceMat computes for that class label.
+     * @param mp Data Mat
+     * @param dst map from each class label to its covariance Mat
+     * @param idx The output column index that holds the class labels. Default is 0.
+     * @return the number of classes
+     */
+	static int covarianceMats(const ocv::MatPair<T1,T2>& mp, std::map<T2,cv::Mat_<T1>>& dst, int idx = 0);
+	
 	/**
      * Calculate mean vector of elements with class label class_label, that is looked for in output column idx
      */
@@ -56,14 +66,14 @@ public:
 	 * the indicator_vector component is 1 (i.e. removes all the colums in mm, the indicator for which
 	 * is set to 0).
 	 */
-	static void selectInputColumns(const ocv::MatPair<T1,T2> mp, ocv::MatPair<T1,T2>& dst, const std::vector<int> selection_vector);
+	static void selectInputColumns(const ocv::MatPair<T1,T2>& mp, ocv::MatPair<T1,T2>& dst, const std::vector<int>& selection_vector);
 	
     /**
 	 * Create a subset of a MatPair, containing all components of an input vector but only those items for which
 	 * the selection_vector component is 1 (i.e. removes all the rows in mp, the indicator for which
 	 * is set to 0). Values in selection_vector other than 0 or 1 will lead to failure.
 	 */
-	static int selectRows(const ocv::MatPair<T1,T2> mp, ocv::MatPair<T1,T2>& dst, const std::vector<int> selection_vector);
+	static int selectRows(const ocv::MatPair<T1,T2>& mp, ocv::MatPair<T1,T2>& dst, const std::vector<int>& selection_vector);
 	
 	/**
 	 * Returns a random subset of the matrix.
@@ -0,0 +1,146 @@
+#include "oceancv/ml/mat_pair_builder.h"
+
+#include "oceancv/ml/mat_pair_file.h"
+
+namespace ocv {
+
+	template <class T1, class T2>
+	MatPairBuilder<T1,T2>::MatPairBuilder(int i_cols, int o_cols, int shards, int initial_rows) : _i_cols(i_cols), _o_cols(o_cols), _initial_rows(initial_rows) {
+		assert(initial_rows > 0);
+		if(shards <= 0)
+			shards = std::max(1, cv::getNumThreads());
+		_shards.resize(shards);
+		clear();
+	}
+
+	template <class T1, class T2>
+	void MatPairBuilder<T1,T2>::clear() {
+		for(Shard& s : _shards) {
+			s.blocks_i.clear();
+			s.blocks_o.clear();
+			s.used = 0;
+			s.rows = 0;
+		}
+	}
+
+	template <class T1, class T2>
+	int MatPairBuilder<T1,T2>::_nextRow(Shard& s) {
+		if(s.blocks_i.empty() || s.used == s.blocks_i.back().rows) {
+			// Double the block size, up to about 2^20 rows
+			int rows = s.blocks_i.empty() ? _initial_rows : std::min(2 * s.blocks_i.back().rows, std::max(_initial_rows, 1 << 20));
+			s.blocks_i.push_back(cv::Mat_<T1>(rows, _i_cols));
+			s.blocks_o.push_back(cv::Mat_<T2>(rows, _o_cols));
+			s.used = 0;
+		}
+		s.rows++;
+		return s.used++;
+	}
+
+	template <class T1, class T2>
+	void MatPairBuilder<T1,T2>::append(const T1* vec_i, const T2* vec_o, int shard) {
+		assert(shard >= 0 && shard < (int) _shards.size());
+		Shard& s = _shards[shard];
+		int row = _nextRow(s);
+		std::copy(vec_i, vec_i + _i_cols, s.blocks_i.back().template ptr<T1>(row));
+		std::copy(vec_o, vec_o + _o_cols, s.blocks_o.back().template ptr<T2>(row));
+	}
+
+	template <class T1, class T2>
+	void MatPairBuilder<T1,T2>::append(const cv::Mat_<T1>& vec_i, const cv::Mat_<T2>& vec_o, int shard) {
+		assert((int) vec_i.total() == _i_cols && (int) vec_o.total() == _o_cols);
+		assert(vec_i.isContinuous() && vec_o.isContinuous());
+		append(vec_i.template ptr<T1>(0), vec_o.template ptr<T2>(0), shard);
+	}
+
+	template <class T1, class T2>
+	void MatPairBuilder<T1,T2>::append(const ocv::MatPair<T1,T2>& mp, int shard) {
+		assert(mp.iCols() == _i_cols && mp.oCols() == _o_cols);
+		for(int r = 0; r < mp.rows(); r++)
+			append(mp.i().template ptr<T1>(r), mp.o().template ptr<T2>(r), shard);
+	}
+
+	template <class T1, class T2>
+	template <class F>
+	void MatPairBuilder<T1,T2>::_forEachBlock(F func) const {
+		for(const Shard& s : _shards) {
+			for(size_t b = 0; b < s.blocks_i.size(); b++) {
+				int used = (b + 1 == s.blocks_i.size()) ? s.used : s.blocks_i[b].rows;
+				if(used > 0)
+					func(s.blocks_i[b].rowRange(0, used), s.blocks_o[b].rowRange(0, used));
+			}
+		}
+	}
+
+	template <class T1, class T2>
+	ocv::MatPair<T1,T2> MatPairBuilder<T1,T2>::finalize() const {
+		ocv::MatPair<T1,T2> ret(rows(), _i_cols, _o_cols);
+		int row = 0;
+		_forEachBlock([&](const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o) {
+			mat_i.copyTo(ret.i().rowRange(row, row + mat_i.rows));
+			mat_o.copyTo(ret.o().rowRange(row, row + mat_o.rows));
+			row += mat_i.rows;
+		});
+		return ret;
+	}
+
+	template <class T1, class T2>
+	bool MatPairBuilder<T1,T2>::finalize(const std::string& path) const {
+		ocv::MatPairFileWriter<T1,T2> writer(path, rows(), _i_cols, _o_cols);
+		if(!writer.isOpen())
+			return false;
+		size_t row = 0;
+		_forEachBlock([&](const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o) {
+			writer.write(row, mat_i, mat_o);
+			row += mat_i.rows;
+		});
+		return writer.close();
+	}
+
+	template <class T1, class T2>
+	bool MatPairBuilder<T1,T2>::finalize(const std::string& path, CODEC_TYPES codec, int chunk_rows) const {
+		ocv::ChunkedMatPairWriter<T1,T2> writer(path, _i_cols, _o_cols, codec, chunk_rows);
+		if(!writer.isOpen())
+			return false;
+		_forEachBlock([&](const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o) {
+			writer.append(mat_i, mat_o);
+		});
+		return writer.close();
+	}
+
+	template <class T1, class T2>
+	size_t MatPairBuilder<T1,T2>::rows() const {
+		size_t ret = 0;
+		for(const Shard& s : _shards)
+			ret += s.rows;
+		return ret;
+	}
+
+	template <class T1, class T2>
+	size_t MatPairBuilder<T1,T2>::rows(int shard) const {
+		return _shards[shard].rows;
+	}
+
+	template <class T1, class T2>
+	int MatPairBuilder<T1,T2>::shards() const {
+		return _shards.size();
+	}
+
+	template <class T1, class T2>
+	int MatPairBuilder<T1,T2>::iCols() const {
+		return _i_cols;
+	}
+
+	template <class T1, class T2>
+	int MatPairBuilder<T1,T2>::oCols() const {
+		return _o_cols;
+	}
+
+	template class MatPairBuilder<double,double>;
+	template class MatPairBuilder<double,float>;
+	template class MatPairBuilder<double,int>;
+
+	template class MatPairBuilder<float,double>;
+	template class MatPairBuilder<float,float>;
+	template class MatPairBuilder<float,int>;
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/chunked_mat_pair.h"
+
+namespace ocv {
+
+	/**
+	 * Collects the rows of a MatPair whose final size is unknown, e.g. while features
+	 * are extracted frame by frame. Rows are copied into blocks that double in size, so
+	 * appending never moves rows that are already stored and costs one allocation per
+	 * block instead of one per row.
+	 * The builder has a fixed number of shards with their own blocks. Different threads
+	 * may append concurrently as long as each one uses its own shard. finalize()
+	 * concatenates the shards in order of their index.
+	 */
+	template <class T1, class T2 = T1>
+	class MatPairBuilder {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param i_cols the dimension of the input vectors
+		 * @param o_cols the dimension of the output vectors
+		 * @param shards the number of shards, cv::getNumThreads() if zero
+		 * @param initial_rows the number of rows of the first block of each shard
+		 */
+		MatPairBuilder(int i_cols, int o_cols, int shards = 0, int initial_rows = 1024);
+
+		/**
+		 * Appends one row given by two single row Mats (or pointers to i_cols / o_cols values)
+		 * to the shard.
+		 */
+		void append(const cv::Mat_<T1>& vec_i, const cv::Mat_<T2>& vec_o, int shard = 0);
+		void append(const T1* vec_i, const T2* vec_o, int shard = 0);
+
+		/**
+		 * Appends all rows of the MatPair to the shard.
+		 */
+		void append(const ocv::MatPair<T1,T2>& mp, int shard = 0);
+
+		/**
+		 * Copies all rows to one contiguous MatPair.
+		 */
+		ocv::MatPair<T1,T2> finalize() const;
+
+		/**
+		 * Writes all rows to a binary MatPair file (see MatPairFile) without creating the
+		 * contiguous MatPair in memory.
+		 */
+		bool finalize(const std::string& path) const;
+
+		/**
+		 * Writes all rows to a chunk-compressed MatPair file (see ChunkedMatPairReader).
+		 */
+		bool finalize(const std::string& path, CODEC_TYPES codec, int chunk_rows = 4096) const;
+
+		/**
+		 * Removes all rows and frees the blocks.
+		 */
+		void clear();
+
+		// Getter
+		size_t rows() const;
+		size_t rows(int shard) const;
+		int shards() const;
+		int iCols() const;
+		int oCols() const;
+
+	private:
+
+		// Aligned to a cache line, so the counters of different threads do not share one
+		struct alignas(64) Shard {
+			std::vector<cv::Mat_<T1>> blocks_i;
+			std::vector<cv::Mat_<T2>> blocks_o;
+			// Used rows of the last block
+			int used;
+			size_t rows;
+		};
+
+		// Returns the next free row of the shard, adds a block if needed
+		int _nextRow(Shard& s);
+
+		// Calls func(mat_i, mat_o) for the filled rows of each block, in order
+		template <class F>
+		void _forEachBlock(F func) const;
+
+		int _i_cols;
+		int _o_cols;
+		int _initial_rows;
+		std::vector<Shard> _shards;
+
+	};
+
+}
@@ -0,0 +1,290 @@
+#include "oceancv/ml/mat_pair_file.h"
+
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ocv {
+
+	namespace {
+
+		const char MATPAIR_FILE_MAGIC[8] = {'O','C','V','M','P','A','I','R'};
+		const uint32_t MATPAIR_FILE_VERSION = 1;
+		const uint32_t MATPAIR_FILE_HAS_INDEX = 1;
+
+		uint64_t alignOffset(uint64_t offset) {
+			return (offset + MATPAIR_FILE_ALIGNMENT - 1) / MATPAIR_FILE_ALIGNMENT * MATPAIR_FILE_ALIGNMENT;
+		}
+
+		// Whether a block of rows x cols values of the given size at offset lies within the file
+		// and is aligned, without overflowing on crafted headers
+		bool blockFits(uint64_t offset, uint64_t rows, uint64_t cols, uint64_t value_size, uint64_t file_size) {
+			if(offset % MATPAIR_FILE_ALIGNMENT != 0 || offset > file_size)
+				return false;
+			return cols == 0 || rows <= (file_size - offset) / value_size / cols;
+		}
+
+	}
+
+	template <class T1, class T2>
+	MatPairFileWriter<T1,T2>::MatPairFileWriter(const std::string& path, size_t rows, int i_cols, int o_cols, bool with_index) : _ok(true) {
+
+		std::memset(&_header, 0, sizeof(_header));
+		std::memcpy(_header.magic, MATPAIR_FILE_MAGIC, sizeof(_header.magic));
+		_header.version = MATPAIR_FILE_VERSION;
+		_header.i_depth = cv::DataType<T1>::depth;
+		_header.o_depth = cv::DataType<T2>::depth;
+		_header.flags = with_index ? MATPAIR_FILE_HAS_INDEX : 0;
+		_header.rows = rows;
+		_header.i_cols = i_cols;
+		_header.o_cols = o_cols;
+		_header.i_offset = alignOffset(sizeof(MatPairFileHeader));
+		_header.o_offset = alignOffset(_header.i_offset + rows * i_cols * sizeof(T1));
+		uint64_t end = _header.o_offset + rows * o_cols * sizeof(T2);
+		if(with_index) {
+			_header.index_offset = alignOffset(end);
+			end = _header.index_offset + rows * sizeof(uint64_t);
+		}
+
+		_file = std::fopen(path.c_str(), "wb");
+		if(_file == nullptr) {
+			_ok = false;
+			return;
+		}
+
+		// Reserve the full size, so rows can be written in any order
+		_ok = _writeAt(0, &_header, sizeof(_header)) && (end == sizeof(_header) || ftruncate(fileno(_file), end) == 0);
+
+	}
+
+	template <class T1, class T2>
+	MatPairFileWriter<T1,T2>::~MatPairFileWriter() {
+		close();
+	}
+
+	template <class T1, class T2>
+	bool MatPairFileWriter<T1,T2>::_writeAt(uint64_t offset, const void* data, size_t bytes) {
+		if(bytes == 0)
+			return true;
+		if(fseeko(_file, offset, SEEK_SET) != 0)
+			return false;
+		return std::fwrite(data, 1, bytes, _file) == bytes;
+	}
+
+	template <class T1, class T2>
+	bool MatPairFileWriter<T1,T2>::write(size_t first_row, const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o, const uint64_t* index) {
+
+		assert(isOpen());
+		assert(mat_i.rows == mat_o.rows && first_row + mat_i.rows <= _header.rows);
+		assert(mat_i.cols == (int) _header.i_cols && mat_o.cols == (int) _header.o_cols);
+
+		const size_t i_row_bytes = _header.i_cols * sizeof(T1);
+		const size_t o_row_bytes = _header.o_cols * sizeof(T2);
+		bool ok = true;
+
+		// Continuous Mats are written as one block
+		if(mat_i.isContinuous()) {
+			ok &= _writeAt(_header.i_offset + first_row * i_row_bytes, mat_i.data, mat_i.rows * i_row_bytes);
+		} else {
+			for(int r = 0; r < mat_i.rows && ok; r++)
+				ok &= _writeAt(_header.i_offset + (first_row + r) * i_row_bytes, mat_i.template ptr<T1>(r), i_row_bytes);
+		}
+		if(mat_o.isContinuous()) {
+			ok &= _writeAt(_header.o_offset + first_row * o_row_bytes, mat_o.data, mat_o.rows * o_row_bytes);
+		} else {
+			for(int r = 0; r < mat_o.rows && ok; r++)
+				ok &= _writeAt(_header.o_offset + (first_row + r) * o_row_bytes, mat_o.template ptr<T2>(r), o_row_bytes);
+		}
+		if(index != nullptr && (_header.flags & MATPAIR_FILE_HAS_INDEX))
+			ok &= _writeAt(_header.index_offset + first_row * sizeof(uint64_t), index, mat_i.rows * sizeof(uint64_t));
+
+		_ok &= ok;
+		return ok;
+
+	}
+
+	template <class T1, class T2>
+	bool MatPairFileWriter<T1,T2>::close() {
+		if(_file == nullptr)
+			return _ok;
+		_ok &= std::fclose(_file) == 0;
+		_file = nullptr;
+		return _ok;
+	}
+
+	template <class T1, class T2>
+	bool MatPairFileWriter<T1,T2>::isOpen() const {
+		return _file != nullptr;
+	}
+
+	template <class T1, class T2>
+	const MatPairFileHeader& MatPairFileWriter<T1,T2>::header() const {
+		return _header;
+	}
+
+	template <class T1, class T2>
+	MatPairFile<T1,T2>::MatPairFile(const std::string& path) : _fd(-1), _data(nullptr), _size(0) {
+
+		_fd = open(path.c_str(), O_RDONLY);
+		if(_fd < 0)
+			return;
+
+		struct stat st;
+		if(fstat(_fd, &st) != 0 || (size_t) st.st_size < sizeof(MatPairFileHeader)) {
+			::close(_fd);
+			_fd = -1;
+			return;
+		}
+		_size = st.st_size;
+
+		// Private writable mapping: the Mats can be modified without touching the file
+		_data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, _fd, 0);
+		if(_data == MAP_FAILED) {
+			_data = nullptr;
+			::close(_fd);
+			_fd = -1;
+			return;
+		}
+
+		std::memcpy(&_header, _data, sizeof(_header));
+		if(!_check(_header, _size)) {
+			munmap(_data, _size);
+			_data = nullptr;
+			::close(_fd);
+			_fd = -1;
+		}
+
+	}
+
+	template <class T1, class T2>
+	MatPairFile<T1,T2>::~MatPairFile() {
+		if(_data != nullptr)
+			munmap(_data, _size);
+		if(_fd >= 0)
+			::close(_fd);
+	}
+
+	template <class T1, class T2>
+	bool MatPairFile<T1,T2>::_check(const MatPairFileHeader& header, uint64_t file_size) {
+		if(std::memcmp(header.magic, MATPAIR_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != MATPAIR_FILE_VERSION)
+			return false;
+		if(header.i_depth != cv::DataType<T1>::depth || header.o_depth != cv::DataType<T2>::depth)
+			return false;
+		// The Mats are addressed with int rows and columns
+		const uint64_t max_dim = std::numeric_limits<int>::max();
+		if(header.rows > max_dim || header.i_cols > max_dim || header.o_cols > max_dim)
+			return false;
+		if(!blockFits(header.i_offset, header.rows, header.i_cols, sizeof(T1), file_size) || !blockFits(header.o_offset, header.rows, header.o_cols, sizeof(T2), file_size))
+			return false;
+		if((header.flags & MATPAIR_FILE_HAS_INDEX) && !blockFits(header.index_offset, header.rows, 1, sizeof(uint64_t), file_size))
+			return false;
+		return true;
+	}
+
+	template <class T1, class T2>
+	bool MatPairFile<T1,T2>::write(const std::string& path, const ocv::MatPair<T1,T2>& mp, const std::vector<uint64_t>& index) {
+		assert(index.empty() || (int) index.size() == mp.rows());
+		ocv::MatPairFileWriter<T1,T2> writer(path, mp.rows(), mp.iCols(), mp.oCols(), !index.empty());
+		if(!writer.isOpen())
+			return false;
+		writer.write(0, mp.i(), mp.o(), index.empty() ? nullptr : index.data());
+		return writer.close();
+	}
+
+	template <class T1, class T2>
+	bool MatPairFile<T1,T2>::read(const std::string& path, ocv::MatPair<T1,T2>& dst) {
+
+		FILE* file = std::fopen(path.c_str(), "rb");
+		if(file == nullptr)
+			return false;
+
+		MatPairFileHeader header;
+		bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+		ok = ok && fseeko(file, 0, SEEK_END) == 0;
+		ok = ok && _check(header, ftello(file));
+
+		if(ok) {
+			cv::Mat_<T1> mat_i(header.rows, header.i_cols);
+			cv::Mat_<T2> mat_o(header.rows, header.o_cols);
+			const size_t i_bytes = header.rows * header.i_cols * sizeof(T1);
+			const size_t o_bytes = header.rows * header.o_cols * sizeof(T2);
+			ok = fseeko(file, header.i_offset, SEEK_SET) == 0 && (i_bytes == 0 || std::fread(mat_i.data, 1, i_bytes, file) == i_bytes);
+			ok = ok && fseeko(file, header.o_offset, SEEK_SET) == 0 && (o_bytes == 0 || std::fread(mat_o.data, 1, o_bytes, file) == o_bytes);
+			if(ok)
+				dst = ocv::MatPair<T1,T2>(mat_i, mat_o);
+		}
+
+		std::fclose(file);
+		return ok;
+
+	}
+
+	template <class T1, class T2>
+	cv::Mat_<T1> MatPairFile<T1,T2>::i() const {
+		assert(isOpen());
+		return cv::Mat_<T1>(_header.rows, _header.i_cols, reinterpret_cast<T1*>(static_cast<char*>(_data) + _header.i_offset));
+	}
+
+	template <class T1, class T2>
+	cv::Mat_<T2> MatPairFile<T1,T2>::o() const {
+		assert(isOpen());
+		return cv::Mat_<T2>(_header.rows, _header.o_cols, reinterpret_cast<T2*>(static_cast<char*>(_data) + _header.o_offset));
+	}
+
+	template <class T1, class T2>
+	ocv::MatPair<T1,T2> MatPairFile<T1,T2>::matPair() const {
+		return ocv::MatPair<T1,T2>(i(), o());
+	}
+
+	template <class T1, class T2>
+	ocv::MatPairView<T1,T2> MatPairFile<T1,T2>::view() const {
+		return ocv::MatPairView<T1,T2>(matPair());
+	}
+
+	template <class T1, class T2>
+	const uint64_t* MatPairFile<T1,T2>::index() const {
+		if(!isOpen() || !(_header.flags & MATPAIR_FILE_HAS_INDEX))
+			return nullptr;
+		return reinterpret_cast<const uint64_t*>(static_cast<const char*>(_data) + _header.index_offset);
+	}
+
+	template <class T1, class T2>
+	bool MatPairFile<T1,T2>::isOpen() const {
+		return _data != nullptr;
+	}
+
+	template <class T1, class T2>
+	size_t MatPairFile<T1,T2>::rows() const {
+		return isOpen() ? _header.rows : 0;
+	}
+
+	template <class T1, class T2>
+	int MatPairFile<T1,T2>::iCols() const {
+		return isOpen() ? _header.i_cols : 0;
+	}
+
+	template <class T1, class T2>
+	int MatPairFile<T1,T2>::oCols() const {
+		return isOpen() ? _header.o_cols : 0;
+	}
+
+	template class MatPairFileWriter<double,double>;
+	template class MatPairFileWriter<double,float>;
+	template class MatPairFileWriter<double,int>;
+
+	template class MatPairFileWriter<float,double>;
+	template class MatPairFileWriter<float,float>;
+	template class MatPairFileWriter<float,int>;
+
+	template class MatPairFile<double,double>;
+	template class MatPairFile<double,float>;
+	template class MatPairFile<double,int>;
+
+	template class MatPairFile<float,double>;
+	template class MatPairFile<float,float>;
+	template class MatPairFile<float,int>;
+
+}
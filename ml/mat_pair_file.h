@@ -0,0 +1,152 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/mat_pair_view.h"
+
+namespace ocv {
+
+	/**
+	 * Header of the binary MatPair file format (.ocvmp). All values are stored in the
+	 * byte order of the writing machine. The header is followed by three blocks, each
+	 * starting at an offset aligned to MATPAIR_FILE_ALIGNMENT bytes:
+	 * - the input Mat, rows x i_cols values of type i_depth, row-major
+	 * - the output Mat, rows x o_cols values of type o_depth, row-major
+	 * - optionally one uint64_t index per row (e.g. a frame or tile id)
+	 */
+	struct MatPairFileHeader {
+		char magic[8];
+		uint32_t version;
+		int32_t i_depth;
+		int32_t o_depth;
+		uint32_t flags;
+		uint64_t rows;
+		uint64_t i_cols;
+		uint64_t o_cols;
+		uint64_t i_offset;
+		uint64_t o_offset;
+		uint64_t index_offset;
+		uint64_t reserved[7];
+	};
+
+	static_assert(sizeof(MatPairFileHeader) == 128, "MatPairFileHeader needs a fixed size");
+
+	const size_t MATPAIR_FILE_ALIGNMENT = 64;
+
+	/**
+	 * Writes a binary MatPair file of known size, block by block of rows. Rows can be
+	 * written in any order, so the file can be filled while the data is produced.
+	 * Not thread-safe.
+	 */
+	template <class T1, class T2 = T1>
+	class MatPairFileWriter {
+	public:
+
+		/**
+		 * Creates the file and reserves space for all rows.
+		 * @param path the path of the file
+		 * @param rows the number of rows of the MatPair
+		 * @param i_cols the dimension of the input vectors
+		 * @param o_cols the dimension of the output vectors
+		 * @param with_index whether a row index is stored
+		 */
+		MatPairFileWriter(const std::string& path, size_t rows, int i_cols, int o_cols, bool with_index = false);
+		~MatPairFileWriter();
+
+		MatPairFileWriter(const MatPairFileWriter&) = delete;
+		MatPairFileWriter& operator=(const MatPairFileWriter&) = delete;
+
+		/**
+		 * Writes the rows of the two Mats to the rows starting at first_row.
+		 * @param index one value per row if the file has a row index, else ignored
+		 * @return false if writing failed
+		 */
+		bool write(size_t first_row, const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o, const uint64_t* index = nullptr);
+
+		/**
+		 * Flushes and closes the file.
+		 * @return false if any write failed
+		 */
+		bool close();
+
+		// Getter
+		bool isOpen() const;
+		const MatPairFileHeader& header() const;
+
+	private:
+
+		// Writes bytes at an absolute file offset
+		bool _writeAt(uint64_t offset, const void* data, size_t bytes);
+
+		FILE* _file;
+		MatPairFileHeader _header;
+		bool _ok;
+
+	};
+
+	/**
+	 * A binary MatPair file mapped into memory. i(), o() and matPair() are Mats that
+	 * point directly into the mapping, so opening a file of any size only reads its
+	 * header; pages are loaded by the operating system on first access.
+	 * The mapping is private: changes to the Mats are not written back to the file.
+	 * All returned Mats and views are only valid as long as this object exists.
+	 */
+	template <class T1, class T2 = T1>
+	class MatPairFile {
+	public:
+
+		/**
+		 * Maps the file. Check isOpen() for success, the value types of the file need to
+		 * match T1 and T2.
+		 */
+		MatPairFile(const std::string& path);
+		~MatPairFile();
+
+		MatPairFile(const MatPairFile&) = delete;
+		MatPairFile& operator=(const MatPairFile&) = delete;
+
+		/**
+		 * Writes the MatPair to a binary file.
+		 * @param index an optional index value per row
+		 */
+		static bool write(const std::string& path, const ocv::MatPair<T1,T2>& mp, const std::vector<uint64_t>& index = std::vector<uint64_t>());
+
+		/**
+		 * Reads the whole file into a MatPair that owns its data, without mapping.
+		 */
+		static bool read(const std::string& path, ocv::MatPair<T1,T2>& dst);
+
+		// Zero-copy access to the mapped data
+		cv::Mat_<T1> i() const;
+		cv::Mat_<T2> o() const;
+		ocv::MatPair<T1,T2> matPair() const;
+		ocv::MatPairView<T1,T2> view() const;
+
+		/**
+		 * Pointer to the row index, nullptr if the file has none.
+		 */
+		const uint64_t* index() const;
+
+		// Getter
+		bool isOpen() const;
+		size_t rows() const;
+		int iCols() const;
+		int oCols() const;
+
+	private:
+
+		// Validates the header against the file size and the value types
+		static bool _check(const MatPairFileHeader& header, uint64_t file_size);
+
+		int _fd;
+		void* _data;
+		size_t _size;
+		MatPairFileHeader _header;
+
+	};
+
+}
@@ -0,0 +1,182 @@
+#include "oceancv/ml/mat_pair_partition.h"
+
+#include <map>
+#include <memory>
+#include <algorithm>
+
+namespace ocv {
+
+	template <class T1>
+	void MatPairPartition<T1>::_count(const ocv::MatPairFile<T1,int>& file, int o_col_idx, std::vector<std::pair<int,size_t>>& counts) {
+
+		std::map<int,size_t> class_sizes;
+		const cv::Mat_<int> mat_o = file.o();
+		for(int r = 0; r < mat_o.rows; r++)
+			class_sizes[mat_o(r,o_col_idx)]++;
+
+		counts.assign(class_sizes.begin(), class_sizes.end());
+
+	}
+
+	template <class T1>
+	template <class F>
+	bool MatPairPartition<T1>::_distribute(const ocv::MatPairFile<T1,int>& file, int o_col_idx, const std::vector<std::pair<int,size_t>>& counts, size_t max_bytes, F write) {
+
+		const cv::Mat_<T1> mat_i = file.i();
+		const cv::Mat_<int> mat_o = file.o();
+		const size_t row_bytes = mat_i.cols * sizeof(T1) + mat_o.cols * sizeof(int) + sizeof(uint64_t);
+
+		// Every bucket gets the same share of the memory limit, but not more than its label needs
+		const size_t capacity = std::max<size_t>(1, max_bytes / row_bytes / std::max<size_t>(1, counts.size()));
+
+		struct Bucket {
+			cv::Mat_<T1> i;
+			cv::Mat_<int> o;
+			std::vector<uint64_t> index;
+			int used = 0;
+			size_t written = 0;
+		};
+		std::vector<Bucket> buckets(counts.size());
+
+		std::vector<int> labels(counts.size());
+		for(size_t l = 0; l < counts.size(); l++)
+			labels[l] = counts[l].first;
+
+		bool ok = true;
+		for(int r = 0; r < mat_i.rows && ok; r++) {
+
+			int l = std::lower_bound(labels.begin(), labels.end(), mat_o(r,o_col_idx)) - labels.begin();
+			Bucket& b = buckets[l];
+
+			// Buckets are allocated on first use
+			if(b.i.empty()) {
+				int rows = std::min(capacity, counts[l].second);
+				b.i = cv::Mat_<T1>(rows, mat_i.cols);
+				b.o = cv::Mat_<int>(rows, mat_o.cols);
+				b.index.resize(rows);
+			}
+
+			std::copy(mat_i.template ptr<T1>(r), mat_i.template ptr<T1>(r) + mat_i.cols, b.i.template ptr<T1>(b.used));
+			std::copy(mat_o.template ptr<int>(r), mat_o.template ptr<int>(r) + mat_o.cols, b.o.template ptr<int>(b.used));
+			b.index[b.used] = r;
+			b.used++;
+
+			if(b.used == b.i.rows) {
+				ok = write(l, b.written, b.i, b.o, b.index.data());
+				b.written += b.used;
+				b.used = 0;
+			}
+
+		}
+
+		// Write the remaining rows of each bucket
+		for(size_t l = 0; l < buckets.size() && ok; l++) {
+			Bucket& b = buckets[l];
+			if(b.used > 0)
+				ok = write(l, b.written, b.i.rowRange(0, b.used), b.o.rowRange(0, b.used), b.index.data());
+		}
+
+		return ok;
+
+	}
+
+	template <class T1>
+	bool MatPairPartition<T1>::partition(const std::string& src, const std::string& dst, std::vector<std::pair<int,cv::Range>>& segments, int o_col_idx, size_t max_bytes) {
+
+		segments.clear();
+
+		ocv::MatPairFile<T1,int> file(src);
+		if(!file.isOpen())
+			return false;
+		assert(o_col_idx >= 0 && o_col_idx < file.oCols());
+
+		std::vector<std::pair<int,size_t>> counts;
+		_count(file, o_col_idx, counts);
+
+		// The first row of each label in dst
+		std::vector<size_t> offsets(counts.size());
+		size_t row = 0;
+		for(size_t l = 0; l < counts.size(); l++) {
+			offsets[l] = row;
+			segments.push_back({counts[l].first, cv::Range(row, row + counts[l].second)});
+			row += counts[l].second;
+		}
+
+		ocv::MatPairFileWriter<T1,int> writer(dst, file.rows(), file.iCols(), file.oCols(), true);
+		if(!writer.isOpen())
+			return false;
+
+		bool ok = _distribute(file, o_col_idx, counts, max_bytes, [&](int l, size_t first_row, const cv::Mat_<T1>& mat_i, const cv::Mat_<int>& mat_o, const uint64_t* index) {
+			return writer.write(offsets[l] + first_row, mat_i, mat_o, index);
+		});
+
+		return writer.close() && ok;
+
+	}
+
+	template <class T1>
+	bool MatPairPartition<T1>::partitionToFiles(const std::string& src, const std::string& dst_prefix, std::vector<int>& labels, int o_col_idx, size_t max_bytes) {
+
+		labels.clear();
+
+		ocv::MatPairFile<T1,int> file(src);
+		if(!file.isOpen())
+			return false;
+		assert(o_col_idx >= 0 && o_col_idx < file.oCols());
+
+		std::vector<std::pair<int,size_t>> counts;
+		_count(file, o_col_idx, counts);
+
+		std::vector<std::unique_ptr<ocv::MatPairFileWriter<T1,int>>> writers;
+		bool ok = true;
+		for(auto& c : counts) {
+			labels.push_back(c.first);
+			writers.emplace_back(new ocv::MatPairFileWriter<T1,int>(labelPath(dst_prefix, c.first), c.second, file.iCols(), file.oCols(), true));
+			ok &= writers.back()->isOpen();
+		}
+
+		if(ok) {
+			ok = _distribute(file, o_col_idx, counts, max_bytes, [&](int l, size_t first_row, const cv::Mat_<T1>& mat_i, const cv::Mat_<int>& mat_o, const uint64_t* index) {
+				return writers[l]->write(first_row, mat_i, mat_o, index);
+			});
+		}
+
+		for(auto& w : writers)
+			ok &= w->close();
+		return ok;
+
+	}
+
+	template <class T1>
+	bool MatPairPartition<T1>::segments(const ocv::MatPairFile<T1,int>& file, std::vector<std::pair<int,cv::Range>>& segments, int o_col_idx) {
+
+		segments.clear();
+		if(!file.isOpen())
+			return false;
+		assert(o_col_idx >= 0 && o_col_idx < file.oCols());
+
+		const cv::Mat_<int> mat_o = file.o();
+		int begin = 0;
+		for(int r = 1; r <= mat_o.rows; r++) {
+			if(r == mat_o.rows || mat_o(r,o_col_idx) != mat_o(begin,o_col_idx)) {
+				if(r < mat_o.rows && mat_o(r,o_col_idx) < mat_o(begin,o_col_idx)) {
+					segments.clear();
+					return false;
+				}
+				segments.push_back({mat_o(begin,o_col_idx), cv::Range(begin, r)});
+				begin = r;
+			}
+		}
+		return true;
+
+	}
+
+	template <class T1>
+	std::string MatPairPartition<T1>::labelPath(const std::string& dst_prefix, int label) {
+		return dst_prefix + std::to_string(label) + ".ocvmp";
+	}
+
+	template class MatPairPartition<float>;
+	template class MatPairPartition<double>;
+
+}
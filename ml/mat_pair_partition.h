@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/mat_pair_file.h"
+
+namespace ocv {
+
+	/**
+	 * Partitions binary MatPair files (see MatPairFile) by the label stored in one output
+	 * column without loading them into memory, the out-of-core counterpart of
+	 * mpalg::splitMatPair.
+	 * A first pass counts the labels, which fixes the target rows of each label. The
+	 * second pass distributes the rows to one bucket per label and writes a bucket to its
+	 * target rows whenever it is full. Each row is read twice and written once, the memory
+	 * use is bounded by max_bytes for the buckets (plus the pages of the source file that
+	 * the system keeps cached).
+	 */
+	template <class T1>
+	class MatPairPartition {
+	public:
+
+		/**
+		 * Writes the rows of src to one file dst, grouped by increasing label. Rows with the
+		 * same label keep their order. The index of dst (see MatPairFile::index) holds the
+		 * row of each row in src.
+		 * @param segments receives each label with its row range in dst
+		 * @param o_col_idx the output column that holds the label
+		 * @param max_bytes the memory limit of the buckets
+		 * @return false if reading or writing failed
+		 */
+		static bool partition(const std::string& src, const std::string& dst, std::vector<std::pair<int,cv::Range>>& segments, int o_col_idx = 0, size_t max_bytes = 256 << 20);
+
+		/**
+		 * Writes the rows of each label to its own file, see labelPath(). Keeps one file per
+		 * label open while writing.
+		 * @param labels receives the labels in increasing order
+		 */
+		static bool partitionToFiles(const std::string& src, const std::string& dst_prefix, std::vector<int>& labels, int o_col_idx = 0, size_t max_bytes = 256 << 20);
+
+		/**
+		 * Finds the label ranges of a file that was written by partition().
+		 * @return false if the rows are not grouped by increasing label
+		 */
+		static bool segments(const ocv::MatPairFile<T1,int>& file, std::vector<std::pair<int,cv::Range>>& segments, int o_col_idx = 0);
+
+		/**
+		 * The path of the file of one label: dst_prefix + label + ".ocvmp"
+		 */
+		static std::string labelPath(const std::string& dst_prefix, int label);
+
+	private:
+
+		// Counts the rows of each label, ordered by label
+		static void _count(const ocv::MatPairFile<T1,int>& file, int o_col_idx, std::vector<std::pair<int,size_t>>& counts);
+
+		// Distributes the rows to the label buckets, write(label_idx, first_row, mat_i, mat_o, index) stores a full bucket
+		template <class F>
+		static bool _distribute(const ocv::MatPairFile<T1,int>& file, int o_col_idx, const std::vector<std::pair<int,size_t>>& counts, size_t max_bytes, F write);
+
+	};
+
+}
@@ -0,0 +1,224 @@
+#include "oceancv/ml/mat_pair_view.h"
+
+#include <map>
+#include <random>
+#include <numeric>
+
+namespace ocv {
+
+	template <class T1, class T2>
+	MatPairView<T1,T2>::MatPairView() : _begin(0), _end(0) {}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2>::MatPairView(const ocv::MatPair<T1,T2>& mp) : _mat_i(mp.i()), _mat_o(mp.o()), _begin(0), _end(mp.rows()) {}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2>::MatPairView(const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o, std::shared_ptr<const std::vector<int>> rows, int begin, int end, std::shared_ptr<const std::vector<int>> cols) : _mat_i(mat_i), _mat_o(mat_o), _rows(rows), _begin(begin), _end(end), _cols(cols) {}
+
+	template <class T1, class T2>
+	int MatPairView<T1,T2>::rows() const {
+		return _end - _begin;
+	}
+
+	template <class T1, class T2>
+	int MatPairView<T1,T2>::iCols() const {
+		return _cols ? (int) _cols->size() : _mat_i.cols;
+	}
+
+	template <class T1, class T2>
+	int MatPairView<T1,T2>::oCols() const {
+		return _mat_o.cols;
+	}
+
+	template <class T1, class T2>
+	int MatPairView<T1,T2>::sourceRow(int row) const {
+		return _rows ? (*_rows)[_begin + row] : _begin + row;
+	}
+
+	template <class T1, class T2>
+	int MatPairView<T1,T2>::sourceCol(int col) const {
+		return _cols ? (*_cols)[col] : col;
+	}
+
+	template <class T1, class T2>
+	T1 MatPairView<T1,T2>::i(int row, int col) const {
+		return _mat_i(sourceRow(row), sourceCol(col));
+	}
+
+	template <class T1, class T2>
+	T2 MatPairView<T1,T2>::o(int row, int col) const {
+		return _mat_o(sourceRow(row), col);
+	}
+
+	template <class T1, class T2>
+	bool MatPairView<T1,T2>::contiguousCols() const {
+		return !_cols;
+	}
+
+	template <class T1, class T2>
+	const T1* MatPairView<T1,T2>::iPtr(int row) const {
+		assert(contiguousCols());
+		return _mat_i.template ptr<T1>(sourceRow(row));
+	}
+
+	template <class T1, class T2>
+	const T2* MatPairView<T1,T2>::oPtr(int row) const {
+		return _mat_o.template ptr<T2>(sourceRow(row));
+	}
+
+	template <class T1, class T2>
+	void MatPairView<T1,T2>::iRow(int row, T1* dst) const {
+		const T1* src = _mat_i.template ptr<T1>(sourceRow(row));
+		if(!_cols) {
+			std::copy(src, src + _mat_i.cols, dst);
+			return;
+		}
+		for(int c : *_cols)
+			*dst++ = src[c];
+	}
+
+	template <class T1, class T2>
+	std::vector<int> MatPairView<T1,T2>::_rowIndices() const {
+		std::vector<int> ret(rows());
+		if(_rows)
+			std::copy(_rows->begin() + _begin, _rows->begin() + _end, ret.begin());
+		else
+			std::iota(ret.begin(), ret.end(), _begin);
+		return ret;
+	}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2> MatPairView<T1,T2>::range(int begin, int end) const {
+		assert(0 <= begin && begin <= end && end <= rows());
+		return MatPairView<T1,T2>(_mat_i, _mat_o, _rows, _begin + begin, _begin + end, _cols);
+	}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2> MatPairView<T1,T2>::selectRows(const std::vector<int>& selection_vector) const {
+		assert((int) selection_vector.size() == rows());
+		auto idx = std::make_shared<std::vector<int>>();
+		for(int r = 0; r < rows(); r++) {
+			if(selection_vector[r] != 0)
+				idx->push_back(sourceRow(r));
+		}
+		int n = idx->size();
+		return MatPairView<T1,T2>(_mat_i, _mat_o, idx, 0, n, _cols);
+	}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2> MatPairView<T1,T2>::selectInputColumns(const std::vector<int>& selection_vector) const {
+		assert((int) selection_vector.size() == iCols());
+		auto cols = std::make_shared<std::vector<int>>();
+		for(int c = 0; c < iCols(); c++) {
+			if(selection_vector[c] != 0)
+				cols->push_back(sourceCol(c));
+		}
+		return MatPairView<T1,T2>(_mat_i, _mat_o, _rows, _begin, _end, cols);
+	}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2> MatPairView<T1,T2>::randomSubset(size_t items, unsigned int seed) const {
+
+		items = std::min(items, (size_t) rows());
+		auto idx = std::make_shared<std::vector<int>>(_rowIndices());
+
+		// Partial Fisher-Yates shuffle, only the first items positions are drawn
+		std::mt19937 rng(seed == 0 ? std::random_device()() : seed);
+		for(size_t k = 0; k < items; k++) {
+			std::uniform_int_distribution<size_t> uni(k, idx->size() - 1);
+			std::swap((*idx)[k], (*idx)[uni(rng)]);
+		}
+		idx->resize(items);
+
+		return MatPairView<T1,T2>(_mat_i, _mat_o, idx, 0, items, _cols);
+
+	}
+
+	template <class T1, class T2>
+	MatPairView<T1,T2> MatPairView<T1,T2>::partition(int o_col_idx, std::vector<std::pair<T2,cv::Range>>& groups) const {
+
+		assert(o_col_idx < oCols());
+
+		// Count the rows per label, the map keeps the labels sorted
+		std::map<T2,int> offsets;
+		for(int r = 0; r < rows(); r++)
+			offsets[_mat_o(sourceRow(r), o_col_idx)]++;
+
+		groups.clear();
+		int begin = 0;
+		for(auto& o : offsets) {
+			int count = o.second;
+			groups.push_back(std::make_pair(o.first, cv::Range(begin, begin + count)));
+			o.second = begin;
+			begin += count;
+		}
+
+		// Place each row behind the previous rows of its label, keeping their order
+		auto idx = std::make_shared<std::vector<int>>(rows());
+		for(int r = 0; r < rows(); r++) {
+			int src = sourceRow(r);
+			(*idx)[offsets[_mat_o(src, o_col_idx)]++] = src;
+		}
+
+		return MatPairView<T1,T2>(_mat_i, _mat_o, idx, 0, rows(), _cols);
+
+	}
+
+	template <class T1, class T2>
+	std::vector<ocv::MatPairView<T1,T2>> MatPairView<T1,T2>::split(int o_col_idx) const {
+		std::vector<std::pair<T2,cv::Range>> groups;
+		MatPairView<T1,T2> partitioned = partition(o_col_idx, groups);
+		std::vector<ocv::MatPairView<T1,T2>> ret;
+		for(auto& g : groups)
+			ret.push_back(partitioned.range(g.second.start, g.second.end));
+		return ret;
+	}
+
+	template <class T1, class T2>
+	void MatPairView<T1,T2>::forEachBlock(int block_rows, const std::function<void(const cv::Mat_<T1>&, const cv::Mat_<T2>&)>& func) const {
+
+		assert(block_rows > 0);
+
+		// Consecutive source rows with all columns are passed without copying
+		if(!_rows && !_cols) {
+			for(int b = _begin; b < _end; b += block_rows) {
+				int e = std::min(_end, b + block_rows);
+				func(_mat_i.rowRange(b, e), _mat_o.rowRange(b, e));
+			}
+			return;
+		}
+
+		cv::Mat_<T1> buf_i(std::min(block_rows, rows()), iCols());
+		cv::Mat_<T2> buf_o(buf_i.rows, oCols());
+		for(int b = 0; b < rows(); b += block_rows) {
+			int n = std::min(rows() - b, block_rows);
+			for(int r = 0; r < n; r++) {
+				iRow(b + r, buf_i.template ptr<T1>(r));
+				const T2* o = oPtr(b + r);
+				std::copy(o, o + oCols(), buf_o.template ptr<T2>(r));
+			}
+			func(buf_i.rowRange(0, n), buf_o.rowRange(0, n));
+		}
+
+	}
+
+	template <class T1, class T2>
+	ocv::MatPair<T1,T2> MatPairView<T1,T2>::copy() const {
+		ocv::MatPair<T1,T2> ret(rows(), iCols(), oCols());
+		for(int r = 0; r < rows(); r++) {
+			iRow(r, ret.i().template ptr<T1>(r));
+			const T2* o = oPtr(r);
+			std::copy(o, o + oCols(), ret.o().template ptr<T2>(r));
+		}
+		return ret;
+	}
+
+	template class MatPairView<double,double>;
+	template class MatPairView<double,float>;
+	template class MatPairView<double,int>;
+
+	template class MatPairView<float,double>;
+	template class MatPairView<float,float>;
+	template class MatPairView<float,int>;
+
+}
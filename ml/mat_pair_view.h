@@ -0,0 +1,141 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "oceancv/ml/mat_pair.h"
+
+namespace ocv {
+
+	/**
+	 * A lightweight view on the rows and input columns of a MatPair that does not copy
+	 * any feature data. It holds the Mat headers of the source (so the data stays alive)
+	 * plus a shared row index list and an optional input column list.
+	 * Subsets of a view are views again: selecting rows or columns, random subsets and
+	 * label groups only create new index lists. Label groups are contiguous ranges of
+	 * one stably partitioned index list, so splitting by label never copies vectors.
+	 */
+	template <class T1, class T2 = T1>
+	class MatPairView {
+	public:
+
+		/**
+		 * Creates an empty view
+		 */
+		MatPairView();
+
+		/**
+		 * Creates a view on all rows and columns of the MatPair, shares its data.
+		 */
+		MatPairView(const ocv::MatPair<T1,T2>& mp);
+
+		// Dimensions of the view
+		int rows() const;
+		int iCols() const;
+		int oCols() const;
+
+		/**
+		 * Returns the index of the row / input column in the source MatPair.
+		 */
+		int sourceRow(int row) const;
+		int sourceCol(int col) const;
+
+		/**
+		 * Returns a copy of the col-th dimension of the row-th input / output vector.
+		 */
+		T1 i(int row, int col) const;
+		T2 o(int row, int col) const;
+
+		/**
+		 * Whether all input columns of the source are kept in order, so iPtr() can be used.
+		 */
+		bool contiguousCols() const;
+
+		/**
+		 * Pointer to the row-th input vector in the source data. Only valid if contiguousCols().
+		 */
+		const T1* iPtr(int row) const;
+
+		/**
+		 * Pointer to the row-th output vector in the source data.
+		 */
+		const T2* oPtr(int row) const;
+
+		/**
+		 * Copies the iCols() values of the row-th input vector to dst.
+		 */
+		void iRow(int row, T1* dst) const;
+
+		/**
+		 * A view on the rows [begin,end) of this view.
+		 */
+		MatPairView<T1,T2> range(int begin, int end) const;
+
+		/**
+		 * A view on all rows for which the selection vector is non-zero, see mpalg::selectRows.
+		 */
+		MatPairView<T1,T2> selectRows(const std::vector<int>& selection_vector) const;
+
+		/**
+		 * A view on all input columns for which the selection vector is non-zero, see
+		 * mpalg::selectInputColumns.
+		 */
+		MatPairView<T1,T2> selectInputColumns(const std::vector<int>& selection_vector) const;
+
+		/**
+		 * A view on a uniform random subset of items rows, drawn without replacement.
+		 * @param seed seed of the random number generator. If zero, a random seed is used.
+		 */
+		MatPairView<T1,T2> randomSubset(size_t items, unsigned int seed = 0) const;
+
+		/**
+		 * Stably partitions the rows by the value in the o_col_idx-th output column in one
+		 * counting pass. The returned view holds the groups as contiguous ranges, sorted by
+		 * increasing label. groups receives each label with its range.
+		 */
+		MatPairView<T1,T2> partition(int o_col_idx, std::vector<std::pair<T2,cv::Range>>& groups) const;
+
+		/**
+		 * One view per label of the o_col_idx-th output column, by increasing label as
+		 * mpalg::splitMatPair. All views share one partitioned index list.
+		 */
+		std::vector<ocv::MatPairView<T1,T2>> split(int o_col_idx = 0) const;
+
+		/**
+		 * Calls func for consecutive blocks of at most block_rows rows of the view with their
+		 * input and output vectors. A view on consecutive source rows and all columns passes
+		 * headers on the source data, other views gather each block into buffers that are
+		 * reused for all blocks. Thus algorithms that take cv::Mat_ chunks (partialFit,
+		 * cluster, ...) consume a view with memory bounded by the block size.
+		 */
+		void forEachBlock(int block_rows, const std::function<void(const cv::Mat_<T1>&, const cv::Mat_<T2>&)>& func) const;
+
+		/**
+		 * Copies the viewed rows and columns to a new MatPair.
+		 */
+		ocv::MatPair<T1,T2> copy() const;
+
+	private:
+
+		// Creates a view on the given index lists
+		MatPairView(const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o, std::shared_ptr<const std::vector<int>> rows, int begin, int end, std::shared_ptr<const std::vector<int>> cols);
+
+		// The viewed source rows as a new index list
+		std::vector<int> _rowIndices() const;
+
+		// Headers of the source data
+		cv::Mat_<T1> _mat_i;
+		cv::Mat_<T2> _mat_o;
+
+		// Source row of view row r is (*_rows)[_begin + r], or _begin + r if _rows is empty
+		std::shared_ptr<const std::vector<int>> _rows;
+		int _begin;
+		int _end;
+
+		// Source input columns, all if empty
+		std::shared_ptr<const std::vector<int>> _cols;
+
+	};
+
+}
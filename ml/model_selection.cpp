@@ -0,0 +1,196 @@
+#include "oceancv/ml/model_selection.h"
+
+namespace ocv {
+
+	template <class T>
+	ModelSelection<T>::ModelSelection(const cv::Mat_<T>& features) : _features(features), _engine(features) {
+
+		_sq_norm = std::vector<T>(_features.rows);
+		cv::parallel_for_(cv::Range(0, _features.rows), [&](const cv::Range& range) {
+			for(int i = range.start; i < range.end; i++) {
+				const T* x = _features.template ptr<T>(i);
+				T len = 0;
+				for(int c = 0; c < _features.cols; c++)
+					len += x[c] * x[c];
+				_sq_norm[i] = len;
+			}
+		});
+
+	}
+
+	template <class T>
+	std::vector<ocv::SweepResult<T>> ModelSelection<T>::sweep(const std::vector<int>& settings, const ClusterFunc& func, bool warm_start, int chains) const {
+
+		std::vector<ocv::SweepResult<T>> ret(settings.size());
+		if(settings.empty())
+			return ret;
+
+		if(!warm_start)
+			chains = settings.size();
+		else if(chains <= 0)
+			chains = std::max(1, cv::getNumThreads());
+		chains = std::min(chains, (int) settings.size());
+
+		cv::parallel_for_(cv::Range(0, chains), [&](const cv::Range& range) {
+
+			// Buffers and index engine of this chain
+			ocv::ClusterIndexEngine<T> engine(_engine);
+			std::vector<int> labels;
+			std::vector<T> dist;
+
+			for(int ch = range.start; ch < range.end; ch++) {
+
+				cv::Mat_<T> prev;
+				for(size_t s = (size_t) ch * settings.size() / chains; s < (size_t) (ch + 1) * settings.size() / chains; s++) {
+
+					ocv::SweepResult<T>& res = ret[s];
+					res.setting = settings[s];
+					res.centroids = func(_features, settings[s], prev);
+					if(warm_start)
+						prev = res.centroids;
+
+					assign(res.centroids, labels, dist);
+
+					std::vector<unsigned char> used(res.centroids.rows, 0);
+					for(int l : labels)
+						used[l] = 1;
+					res.classes = std::count(used.begin(), used.end(), 1);
+
+					res.indices = std::vector<T>(5, std::numeric_limits<T>::quiet_NaN());
+					if(res.classes > 1) {
+						engine.evaluate(labels);
+						for(int t = 0; t < 5; t++)
+							res.indices[t] = engine.index((ocv::CI_TYPES) t);
+					}
+
+				}
+			}
+
+		});
+
+		return ret;
+
+	}
+
+	template <class T>
+	typename ModelSelection<T>::ClusterFunc ModelSelection<T>::kMeans(size_t iterations, unsigned int seed) const {
+
+		return [this,iterations,seed](const cv::Mat_<T>& features, int k, const cv::Mat_<T>& warm_start) -> cv::Mat_<T> {
+
+			assert(k > 0 && k <= features.rows);
+			assert(features.data == _features.data);
+
+			std::vector<int> labels;
+			std::vector<T> dist;
+			cv::Mat_<T> centroids(k, features.cols);
+
+			if(warm_start.empty()) {
+				// Distinct random rows, seeded by k to have reproducible sweeps
+				std::mt19937 rng(seed == 0 ? std::random_device()() : seed + k);
+				std::vector<int> rows(features.rows);
+				for(int i = 0; i < features.rows; i++)
+					rows[i] = i;
+				for(int j = 0; j < k; j++) {
+					std::uniform_int_distribution<int> uni(j, features.rows - 1);
+					std::swap(rows[j], rows[uni(rng)]);
+					features.row(rows[j]).copyTo(centroids.row(j));
+				}
+			} else {
+				int keep = std::min(k, warm_start.rows);
+				warm_start.rowRange(0, keep).copyTo(centroids.rowRange(0, keep));
+				// Add the row that is worst represented by the current centroids
+				for(int j = keep; j < k; j++) {
+					assign(centroids.rowRange(0, j), labels, dist);
+					int far = std::max_element(dist.begin(), dist.end()) - dist.begin();
+					features.row(far).copyTo(centroids.row(j));
+				}
+			}
+
+			// Lloyd iterations
+			std::vector<int> prev_labels;
+			std::vector<int> counts(k);
+			cv::Mat_<double> sums(k, features.cols);
+			for(size_t it = 0; it < iterations; it++) {
+
+				assign(centroids, labels, dist);
+				if(labels == prev_labels)
+					break;
+				std::swap(labels, prev_labels);
+
+				sums = 0;
+				std::fill(counts.begin(), counts.end(), 0);
+				for(int i = 0; i < features.rows; i++) {
+					const T* x = features.template ptr<T>(i);
+					double* s = sums.template ptr<double>(prev_labels[i]);
+					for(int c = 0; c < features.cols; c++)
+						s[c] += x[c];
+					counts[prev_labels[i]]++;
+				}
+
+				// Empty clusters keep their centroid
+				for(int j = 0; j < k; j++) {
+					if(counts[j] == 0)
+						continue;
+					for(int c = 0; c < features.cols; c++)
+						centroids(j,c) = static_cast<T>(sums(j,c) / counts[j]);
+				}
+
+			}
+
+			return centroids;
+
+		};
+
+	}
+
+	template <class T>
+	void ModelSelection<T>::assign(const cv::Mat_<T>& centroids, std::vector<int>& labels, std::vector<T>& dist) const {
+
+		assert(centroids.rows > 0 && centroids.cols == _features.cols);
+
+		labels.resize(_features.rows);
+		dist.resize(_features.rows);
+
+		// |x - c|^2 = |x|^2 + |c|^2 - 2 x*c, where |x|^2 is cached
+		std::vector<T> c_norm(centroids.rows);
+		for(int j = 0; j < centroids.rows; j++)
+			c_norm[j] = centroids.row(j).dot(centroids.row(j));
+
+		cv::parallel_for_(cv::Range(0, _features.rows), [&](const cv::Range& range) {
+			for(int i = range.start; i < range.end; i++) {
+				const T* x = _features.template ptr<T>(i);
+				T best = std::numeric_limits<T>::max(), d;
+				int best_idx = 0;
+				for(int j = 0; j < centroids.rows; j++) {
+					const T* c = centroids.template ptr<T>(j);
+					d = 0;
+					for(int l = 0; l < _features.cols; l++)
+						d += x[l] * c[l];
+					d = c_norm[j] - 2 * d;
+					if(d < best) {
+						best = d;
+						best_idx = j;
+					}
+				}
+				labels[i] = best_idx;
+				dist[i] = std::max(T(0), best + _sq_norm[i]);
+			}
+		});
+
+	}
+
+	template <class T>
+	void ModelSelection<T>::write(const std::vector<ocv::SweepResult<T>>& results, std::ostream& os) {
+		os << "setting\tclasses\tcalinski_harabasz\tindex_i\tdavies_bouldin\tinter_class_variance\tintra_class_variance" << std::endl;
+		for(auto& res : results) {
+			os << res.setting << "\t" << res.classes;
+			for(T v : res.indices)
+				os << "\t" << v;
+			os << std::endl;
+		}
+	}
+
+	template class ModelSelection<float>;
+	template class ModelSelection<double>;
+
+}
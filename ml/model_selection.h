@@ -0,0 +1,101 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <random>
+#include <limits>
+
+#include "oceancv/ml/cluster_index_engine.h"
+
+namespace ocv {
+
+	/**
+	 * Outcome of one clustering of a model selection sweep.
+	 */
+	template <class T>
+	struct SweepResult {
+		// The swept parameter, e.g. the number of clusters
+		int setting;
+		// The prototypes returned by the clustering
+		cv::Mat_<T> centroids;
+		// Number of prototypes that got at least one feature vector assigned
+		int classes;
+		// All cluster indices, indexed by CI_TYPES. NaN if less than two classes remained.
+		std::vector<T> indices;
+	};
+
+	/**
+	 * Runs one clustering per candidate setting (e.g. k of kMeans, the cluster count of
+	 * NeuralGas or the rings of an H2SOM) and rates each by all CI_TYPES indices.
+	 * The settings are split into contiguous chains that run concurrently. Within a chain,
+	 * each clustering receives the centroids of the previous setting as a warm start.
+	 * All chains share the read-only features, their cached squared row norms (used to
+	 * assign feature vectors to centroids) and the cached norms of one ClusterIndexEngine.
+	 */
+	template <class T>
+	class ModelSelection {
+	public:
+
+		/**
+		 * A clustering to evaluate. Receives the features, the setting and the centroids of
+		 * the previous setting in the same chain (empty for the first one) and returns the
+		 * resulting centroids, one per row.
+		 */
+		typedef std::function<cv::Mat_<T>(const cv::Mat_<T>& features, int setting, const cv::Mat_<T>& warm_start)> ClusterFunc;
+
+		/**
+		 * Constructor.
+		 * @param features the feature vectors, one per row. Data is not copied.
+		 */
+		ModelSelection(const cv::Mat_<T>& features);
+
+		/**
+		 * Clusters the features for every setting and computes the cluster indices of the
+		 * resulting nearest-centroid labeling. Settings should be sorted so that neighbouring
+		 * settings are similar.
+		 * @param settings the parameter values to evaluate
+		 * @param func the clustering to run for each setting
+		 * @param warm_start whether to pass the previous centroids on to the next setting
+		 * @param chains number of concurrent chains. If zero, the number of threads is used.
+		 * Without warm starts every setting runs on its own.
+		 * @return one result per setting, in the order of settings
+		 */
+		std::vector<ocv::SweepResult<T>> sweep(const std::vector<int>& settings, const ClusterFunc& func, bool warm_start = true, int chains = 0) const;
+
+		/**
+		 * Returns a kMeans clustering (Lloyd iterations) where the setting is k.
+		 * Warm starts are extended by the feature vectors farthest from their closest
+		 * centroid, without a warm start k random feature vectors are chosen.
+		 * The returned function refers to this object, so it must not outlive it.
+		 * @param iterations maximum number of Lloyd iterations
+		 * @param seed seed for choosing initial centroids. If zero, a random seed is used.
+		 */
+		ClusterFunc kMeans(size_t iterations = 100, unsigned int seed = 1) const;
+
+		/**
+		 * Assigns each feature vector to its closest centroid (euclidean distance).
+		 * @param centroids the prototypes, one per row
+		 * @param labels the index of the closest centroid per feature vector
+		 * @param dist the squared distance to that centroid per feature vector
+		 */
+		void assign(const cv::Mat_<T>& centroids, std::vector<int>& labels, std::vector<T>& dist) const;
+
+		/**
+		 * Writes the results of a sweep as a tab separated table with a header line.
+		 */
+		static void write(const std::vector<ocv::SweepResult<T>>& results, std::ostream& os);
+
+	private:
+
+		// Feature data
+		cv::Mat_<T> _features;
+
+		// Squared euclidean length of each row
+		std::vector<T> _sq_norm;
+
+		// Index engine whose copies share its cached norms
+		ocv::ClusterIndexEngine<T> _engine;
+
+	};
+
+}
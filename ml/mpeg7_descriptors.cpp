@@ -1,17 +1,106 @@
 #include "oceancv/ml/mpeg7_descriptors.h"
 
+#include <mutex>
+
 namespace ocv {
 
+// The MPEG7 library keeps intermediate results in globals and statics and is not
+// reentrant, all extractions from a Frame are serialized by this mutex
+static std::mutex mpeg7_mutex;
+
 template<class T>
-ColorLayoutDescriptor<T>::ColorLayoutDescriptor(int num_y_coeff, int num_c_coeff) : _num_y_coeff(num_y_coeff), _num_c_coeff(num_c_coeff) { }
+MPEG7Descriptor<T>::MPEG7Descriptor(bool gray) : _gray(gray) { }
 
 template<class T>
-void ColorLayoutDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && this->valid(img) );
+void MPEG7Descriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
+	assert(vec.cols == this->size() && this->valid(img));
+	
+	Frame* frame = 0;
+	_prepare(frame, img, mask);
+	{
+		std::lock_guard<std::mutex> lock(mpeg7_mutex);
+		_extract(frame, vec);
+	}
+	delete frame;
 	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
+}
+
+template<class T>
+void MPEG7Descriptor<T>::extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const {
+	assert(vec.cols == this->size() && this->valid(_gray ? ctx.gray() : ctx.image()));
+	
+	std::shared_ptr<Frame>& frame = ctx.frame();
+	if(!frame) {
+		frame.reset(new Frame(ctx.image().cols, ctx.image().rows));
+		if(ctx.image().channels() == 3)
+			frame->setImage(ctx.image());
+		frame->setGray(ctx.gray());
+	}
+	// The previous descriptor of the context may have changed the mask of the Frame
+	_applyMask(frame.get(), ctx.mask());
+	std::lock_guard<std::mutex> lock(mpeg7_mutex);
+	_extract(frame.get(), vec);
+	
+}
+
+template<class T>
+void MPEG7Descriptor<T>::_extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const {
+	
+	Frame* frame = 0;
+	cv::Mat_<T> vec;
+	for(int i = begin; i < end; i++) {
+		assert(this->valid(imgs[i]));
+		vec = dst.row(i);
+		const cv::Mat& mask = masks.empty() ? cv::Mat() : masks[i];
+		_prepare(frame, imgs[i], mask);
+		std::lock_guard<std::mutex> lock(mpeg7_mutex);
+		_extract(frame, vec);
+	}
+	delete frame;
+	
+}
+
+template<class T>
+void MPEG7Descriptor<T>::_prepare(Frame*& frame, const cv::Mat& img, const cv::Mat& mask) const {
+	
+	if(!frame) {
+		// Gray frames carry a mask as well, so masks apply to all descriptors
+		if(_gray)
+			frame = new Frame(img.cols, img.rows, false, true, true);
+		else
+			frame = new Frame(img.cols, img.rows);
+	} else {
+		frame->resize(img.cols, img.rows);
+	}
+	
+	if(_gray)
+		frame->setGray(img);
+	else
+		frame->setImage(img);
+	_applyMask(frame, mask);
+	
+}
+
+template<class T>
+void MPEG7Descriptor<T>::_applyMask(Frame* frame, const cv::Mat& mask) const {
+	
+	if(mask.empty()) {
+		// The whole image is the shape, the color and gray channels stay unmasked
+		frame->setMaskValue(255);
+		frame->resetMaskAll();
+	} else {
 		frame->setMaskAll(mask,255,255,0);
+	}
+	
+}
+
+
+
+template<class T>
+ColorLayoutDescriptor<T>::ColorLayoutDescriptor(int num_y_coeff, int num_c_coeff) : _num_y_coeff(num_y_coeff), _num_c_coeff(num_c_coeff) { }
+
+template<class T>
+void ColorLayoutDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 
 	XM::ColorLayoutDescriptor* cld = Feature::getColorLayoutD(frame, _num_y_coeff, _num_c_coeff);
 	
@@ -28,7 +117,6 @@ void ColorLayoutDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, con
 		vec(c++) = cr_coeff[i];
 	
 	delete cld;
-	delete frame;
 	
 }
 
@@ -59,12 +147,7 @@ ColorStructureDescriptor<T>::ColorStructureDescriptor(int size) : _size(size) {}
 
 
 template<class T>
-void ColorStructureDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && this->valid(img));
-	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
+void ColorStructureDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 
 	XM::ColorStructureDescriptor* csd = Feature::getColorStructureD(frame, _size);
 
@@ -73,7 +156,6 @@ void ColorStructureDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec,
 	}
 
 	delete csd;
-	delete frame;
 
 }
 
@@ -99,12 +181,7 @@ DominantColorDescriptor<T>::DominantColorDescriptor(int num_dc, bool normalizati
 
 
 template<class T>
-void DominantColorDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && this->valid(img));
-	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
+void DominantColorDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 
 	XM::DominantColorDescriptor* dcd = Feature::getDominantColorD(frame,_normalization_flag,_variance_flag,_spatial_flag,_num_bin_0,_num_bin_1,_num_bin_2);
 
@@ -133,7 +210,6 @@ void DominantColorDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, c
 
 	delete dcd;
 	delete domcol;
-	delete frame;
 	
 }
 
@@ -184,12 +260,7 @@ template<class T>
 EdgeHistogramDescriptor<T>::EdgeHistogramDescriptor() { }
 
 template<class T>
-void EdgeHistogramDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && this->valid(img));
-	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
+void EdgeHistogramDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 
 	XM::EdgeHistogramDescriptor* ehd = Feature::getEdgeHistogramD(frame);
 	char* de = ehd->GetEdgeHistogramElement();
@@ -198,7 +269,6 @@ void EdgeHistogramDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, c
 	}
 	
 	delete ehd;
-	delete frame;
 	
 }
 
@@ -220,25 +290,17 @@ std::vector<std::string> EdgeHistogramDescriptor<T>::setup() const {
 
 
 template<class T>
-HomogeneousTextureDescriptor<T>::HomogeneousTextureDescriptor(bool layerFlag) : _layerFlag(layerFlag) { }
+HomogeneousTextureDescriptor<T>::HomogeneousTextureDescriptor(bool layerFlag) : MPEG7Descriptor<T>(true), _layerFlag(layerFlag) { }
 
 
 template<class T>
-void HomogeneousTextureDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == size() && this->valid(img));
-
-	Frame* frame = new Frame(img.cols, img.rows, false, true, false);
-	frame->setGray(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
-
+void HomogeneousTextureDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 	XM::HomogeneousTextureDescriptor* htd = Feature::getHomogeneousTextureD(frame, _layerFlag);
 	int* ht_values = htd->GetHomogeneousTextureFeature();
 
 	for(int i = 0; i < size(); i++)
 		vec(i) = ht_values[i];
 
-	delete frame;
 	delete htd;
 	
 }
@@ -276,14 +338,9 @@ template<class T>
 ScalableColorDescriptor<T>::ScalableColorDescriptor(int size) : _size(size) { }
 
 template<class T>
-void ScalableColorDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == this->size() && this->valid(img));
+void ScalableColorDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
-	
-	XM::ScalableColorDescriptor* scd = Feature::getScalableColorD(frame, mask.empty(), _size);
+	XM::ScalableColorDescriptor* scd = Feature::getScalableColorD(frame, frame->image->a_chan == 0, _size);
 	
 	int coeff = (int) scd->GetNumberOfCoefficients();
 	for(int i = 0; i < coeff; i++) {
@@ -291,7 +348,6 @@ void ScalableColorDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, c
 	}
 
 	delete scd;
-	delete frame;
 	
 }
 
@@ -316,12 +372,7 @@ template<class T>
 ContourShapeDescriptor<T>::ContourShapeDescriptor(int max_num) : _max_num(max_num) { }
 
 template<class T>
-void ContourShapeDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == this->size() && this->valid(img));
-	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
+void ContourShapeDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 	
 	size_t idx = 0;
 	
@@ -357,7 +408,6 @@ void ContourShapeDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, co
 	}
 	
 	delete csd;
-	delete frame;
 	
 }
 
@@ -390,12 +440,7 @@ template<class T>
 RegionShapeDescriptor<T>::RegionShapeDescriptor() { }
 
 template<class T>
-void RegionShapeDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask) const {
-	assert(vec.cols == this->size() && this->valid(img));
-	
-	Frame* frame = new Frame(img);
-	if(!mask.empty())
-		frame->setMaskAll(mask,255,255,0);
+void RegionShapeDescriptor<T>::_extract(Frame* frame, cv::Mat_<T>& vec) const {
 	
 	XM::RegionShapeDescriptor* rsd = Feature::getRegionShapeD(frame);
 	
@@ -407,7 +452,6 @@ void RegionShapeDescriptor<T>::extract(const cv::Mat& img, cv::Mat_<T>& vec, con
 	}
 
 	delete rsd;
-	delete frame;
 	
 }
 
@@ -429,6 +473,9 @@ std::vector<std::string> RegionShapeDescriptor<T>::setup() const {
 
 
 
+template class MPEG7Descriptor<float>;
+template class MPEG7Descriptor<double>;
+
 template class ScalableColorDescriptor<float>;
 template class ScalableColorDescriptor<double>;
 
@@ -447,4 +494,10 @@ template class ColorStructureDescriptor<double>;
 template class ColorLayoutDescriptor<float>;
 template class ColorLayoutDescriptor<double>;
 
+template class ContourShapeDescriptor<float>;
+template class ContourShapeDescriptor<double>;
+
+template class RegionShapeDescriptor<float>;
+template class RegionShapeDescriptor<double>;
+
 }
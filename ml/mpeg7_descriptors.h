@@ -6,6 +6,57 @@
 
 namespace ocv {
 
+/**
+ * Common base of the MPEG7 descriptors. The images are copied into the Frame structure
+ * of the MPEG7 library before the extraction, a batch keeps one Frame per thread and
+ * only reallocates it when the image size changes. With an ImageContext, all MPEG7
+ * descriptors of an image share one Frame.
+ * The MPEG7 library keeps its state in globals and is not reentrant. All extractions
+ * from a Frame are therefore serialized over all threads and descriptors: a batch of
+ * MPEG7 descriptors is extracted serially, only the Frame preparation runs in parallel.
+ **/
+template<class T>
+class MPEG7Descriptor : public FeatureDescriptor<T> {
+
+public:
+	
+	/**
+	 * @param gray whether the descriptor works on the gray channel of the Frame (CV_8UC1 images)
+	 */
+	MPEG7Descriptor(bool gray = false);
+	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
+	
+	/**
+	 * Extracts from the Frame of the context, the first MPEG7 descriptor of an image
+	 * creates it with the color image and the gray image. The mask of the context is
+	 * set before every extraction.
+	 */
+	void extractContext(ImageContext& ctx, cv::Mat_<T>& vec) const;
+
+protected:
+	void _extractRange(const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks, cv::Mat_<T>& dst, int begin, int end) const;
+	
+	// Computes the descriptor from a prepared Frame, called only while the MPEG7 library is locked
+	virtual void _extract(Frame* frame, cv::Mat_<T>& vec) const = 0;
+
+private:
+	
+	// Creates or resizes the Frame and copies the image and mask into it
+	void _prepare(Frame*& frame, const cv::Mat& img, const cv::Mat& mask) const;
+	
+	/**
+	 * Sets the mask of the Frame to the given mask, or to the whole image without one.
+	 * The MPEG7 library changes the mask of a Frame during some extractions (e.g. the
+	 * ScalableColorDescriptor), so this is done before every extraction from a Frame
+	 * that is reused or shared between descriptors.
+	 */
+	void _applyMask(Frame* frame, const cv::Mat& mask) const;
+	
+	bool _gray;
+	
+};
+
+
 /**
  * (C)olor (L)ayout (D)escriptor for extraction from an CV_8UC3 image.
  * "The extraction for the descriptor consists of four stages;
@@ -24,15 +75,17 @@ namespace ocv {
  * See Sikora: "The MPEG-7 visual standard for content description-an overview"
  **/
 template<class T>
-class ColorLayoutDescriptor : public FeatureDescriptor<T> {
+class ColorLayoutDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	ColorLayoutDescriptor(int num_y_coeff = 64, int num_c_coeff = 28);
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 private:
 	int _num_y_coeff;
 	int _num_c_coeff;
@@ -44,17 +97,19 @@ private:
  * (C)olor (S)tructure (D)escriptor for extraction from an CV_8UC3 image.
  **/
 template<class T>
-class ColorStructureDescriptor : public FeatureDescriptor<T> {
+class ColorStructureDescriptor : public MPEG7Descriptor<T> {
 	
 public:
 
 	// size  can be: 32, 64, 128 or 256
 	ColorStructureDescriptor(int size = 64);
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 private:
 	int _size;
 	
@@ -65,7 +120,7 @@ private:
  * (D)ominant (C)olor (D)escriptor for extraction from an CV_8UC3 image.
  **/
 template<class T>
-class DominantColorDescriptor : public FeatureDescriptor<T> {
+class DominantColorDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	
@@ -81,11 +136,13 @@ public:
 	 * @param num_bin_2 bin numbers to quantize the dominant color values to
 	 */
 	DominantColorDescriptor(int num_dc = 5, bool normalization_flag = true, bool variance_flag = true, bool spatial_flag = true, int num_bin_0 = 32, int num_bin_1 = 32, int num_bin_2 = 32);
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 private:
 	int _num_dc;
 	bool _normalization_flag, _variance_flag, _spatial_flag;
@@ -98,14 +155,16 @@ private:
  * (E)dge (H)istogram (D)escriptor for extraction from an CV_8UC3 image.
  **/
 template<class T>
-class EdgeHistogramDescriptor : public FeatureDescriptor<T> {
+class EdgeHistogramDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	EdgeHistogramDescriptor();
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
+
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
 	
 };
 
@@ -114,15 +173,17 @@ public:
  * (H)omogeneous (T)exture (D)escriptor for extraction from an CV_8UC1 (gray) image.
  **/
 template<class T>
-class HomogeneousTextureDescriptor : public FeatureDescriptor<T> {
+class HomogeneousTextureDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	HomogeneousTextureDescriptor(bool layer_flag = true);
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 private:
 	bool _layerFlag;
 	
@@ -133,16 +194,18 @@ private:
  * (S)calable (C)olor Descriptor for extraction from an CV_8UC3 image.
  **/
 template<class T>
-class ScalableColorDescriptor : public FeatureDescriptor<T> {
+class ScalableColorDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	// Size can be 16, 32, 64, 128 or 256
 	ScalableColorDescriptor(int size = 256);
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 private:
 	int _size;
 	
@@ -154,15 +217,17 @@ private:
  * (S)calable (C)olor Descriptor for extraction from an CV_8UC3 image.
  **/
 template<class T>
-class ContourShapeDescriptor : public FeatureDescriptor<T> {
+class ContourShapeDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	ContourShapeDescriptor(int max_num);
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 private:
 	int _max_num;
 	
@@ -171,15 +236,17 @@ private:
 
 // TODO: XM::RegionShapeDescriptor* getRegionShapeD( Frame* f );
 template<class T>
-class RegionShapeDescriptor : public FeatureDescriptor<T> {
+class RegionShapeDescriptor : public MPEG7Descriptor<T> {
 
 public:
 	RegionShapeDescriptor();
-	void extract(const cv::Mat& img, cv::Mat_<T>& vec, const cv::Mat& mask = cv::Mat()) const;
 	bool valid(const cv::Mat& img) const;
 	int size() const;
 	std::vector<std::string> setup() const;
 
+protected:
+	void _extract(Frame* frame, cv::Mat_<T>& vec) const;
+
 };
 
 }
@@ -0,0 +1,317 @@
+#include "oceancv/ml/pca.h"
+
+#include <random>
+
+namespace ocv {
+
+	template <class T>
+	PCA<T>::PCA(int components) : _components(components), _count(0), _total_variance(0) {
+		assert(_components > 0);
+	}
+
+	template <class T>
+	PCA<T>::PCA(const std::string& path) : _components(0), _count(0), _total_variance(0) {
+		read(path);
+	}
+
+	template <class T>
+	void PCA<T>::fit(const cv::Mat_<T>& data) {
+		_count = 0;
+		_running_mean.release();
+		_scatter.release();
+		partialFit(data);
+	}
+
+	template <class T>
+	bool PCA<T>::partialFit(const cv::Mat_<T>& batch) {
+		if(!_merge(batch))
+			return false;
+		_solve();
+		return true;
+	}
+
+	template <class T>
+	bool PCA<T>::_merge(const cv::Mat_<T>& batch) {
+
+		if(batch.rows == 0)
+			return false;
+		const int d = batch.cols;
+		if(_count == 0) {
+			_running_mean = cv::Mat_<double>(1, d, 0.0);
+			_scatter = cv::Mat_<double>(d, d, 0.0);
+		}
+
+		// A randomized fit or a model read from disk keeps no scatter Mat to continue from
+		if(_scatter.empty() || _scatter.cols != d)
+			return false;
+
+		// Batch mean and the scatter around it as one rank-k update
+		cv::Mat_<double> centered;
+		batch.convertTo(centered, CV_64F);
+		cv::Mat_<double> batch_mean(1, d, 0.0);
+		for(int i = 0; i < centered.rows; i++) {
+			const double* x = centered.template ptr<double>(i);
+			for(int c = 0; c < d; c++)
+				batch_mean(c) += x[c];
+		}
+		batch_mean /= centered.rows;
+		for(int i = 0; i < centered.rows; i++) {
+			double* x = centered.template ptr<double>(i);
+			for(int c = 0; c < d; c++)
+				x[c] -= batch_mean(c);
+		}
+		cv::Mat_<double> batch_scatter;
+		cv::mulTransposed(centered, batch_scatter, true);
+
+		// Pairwise merge with the previous batches
+		const double n_a = _count, n_b = batch.rows, n = n_a + n_b;
+		cv::Mat_<double> delta = batch_mean - _running_mean;
+		cv::Mat_<double> correction;
+		cv::mulTransposed(delta, correction, true);
+		_scatter += batch_scatter + correction * (n_a * n_b / n);
+		_running_mean += delta * (n_b / n);
+		_count += batch.rows;
+		return true;
+
+	}
+
+	template <class T>
+	void PCA<T>::_solve() {
+
+		cv::Mat_<double> cov = _scatter / std::max(1.0, _count - 1.0);
+
+		// Eigenvectors are returned as rows, sorted by decreasing eigenvalue
+		cv::Mat_<double> evals, evecs;
+		cv::eigen(cov, evals, evecs);
+
+		const int k = std::min(_components, cov.cols);
+		evecs.rowRange(0, k).convertTo(_eigenvectors, cv::DataType<T>::depth);
+		evals.rowRange(0, k).reshape(1, 1).convertTo(_eigenvalues, cv::DataType<T>::depth);
+		_running_mean.convertTo(_mean, cv::DataType<T>::depth);
+		_total_variance = cv::trace(cov)[0];
+
+	}
+
+	template <class T>
+	void PCA<T>::_orthonormalize(cv::Mat_<T>& m) {
+		cv::Mat_<T> w, u, vt;
+		cv::SVD::compute(m, w, u, vt);
+		m = u;
+	}
+
+	template <class T>
+	void PCA<T>::fitRandomized(const cv::Mat_<T>& data, int oversampling, int power_iterations, unsigned int seed) {
+
+		const int n = data.rows;
+		const int d = data.cols;
+		assert(n > 1);
+		const int k = std::min(_components, d);
+		const int l = std::min(k + oversampling, std::min(n, d));
+
+		// Column means and total variance in one pass
+		std::vector<double> sum(d, 0.0), sq_sum(d, 0.0);
+		for(int i = 0; i < n; i++) {
+			const T* x = data.template ptr<T>(i);
+			for(int c = 0; c < d; c++) {
+				sum[c] += x[c];
+				sq_sum[c] += (double) x[c] * x[c];
+			}
+		}
+		cv::Mat_<T> mu(1, d);
+		_total_variance = 0;
+		for(int c = 0; c < d; c++) {
+			mu(c) = static_cast<T>(sum[c] / n);
+			_total_variance += (sq_sum[c] - sum[c] * sum[c] / n) / (n - 1);
+		}
+
+		// The centered data X - 1 * mu is never formed, its products are corrected instead
+		auto centeredTimes = [&](const cv::Mat_<T>& m, cv::Mat_<T>& dst) {
+			cv::gemm(data, m, 1, cv::Mat(), 0, dst);
+			cv::Mat_<T> offset = mu * m;
+			for(int i = 0; i < n; i++) {
+				T* y = dst.template ptr<T>(i);
+				for(int c = 0; c < dst.cols; c++)
+					y[c] -= offset(c);
+			}
+		};
+		auto centeredTransposedTimes = [&](const cv::Mat_<T>& m, cv::Mat_<T>& dst) {
+			cv::gemm(m, data, 1, cv::Mat(), 0, dst, cv::GEMM_1_T);
+			cv::Mat_<T> col_sum(m.cols, 1, T(0));
+			for(int i = 0; i < n; i++) {
+				const T* y = m.template ptr<T>(i);
+				for(int c = 0; c < m.cols; c++)
+					col_sum(c) += y[c];
+			}
+			dst -= col_sum * mu;
+		};
+
+		// Range finder: sample the column space by random directions
+		cv::Mat_<T> omega(d, l), y, z;
+		cv::RNG rng(seed == 0 ? std::random_device()() : seed);
+		rng.fill(omega, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+		centeredTimes(omega, y);
+		_orthonormalize(y);
+
+		for(int q = 0; q < power_iterations; q++) {
+			centeredTransposedTimes(y, z);
+			z = z.t();
+			_orthonormalize(z);
+			centeredTimes(z, y);
+			_orthonormalize(y);
+		}
+
+		// Exact SVD of the small projected Mat B = Q^T X
+		cv::Mat_<T> b, w, u, vt;
+		centeredTransposedTimes(y, b);
+		cv::SVD::compute(b, w, u, vt);
+
+		vt.rowRange(0, k).copyTo(_eigenvectors);
+		_eigenvalues.create(1, k);
+		for(int p = 0; p < k; p++)
+			_eigenvalues(p) = static_cast<T>((double) w(p) * w(p) / (n - 1));
+
+		_mean = mu;
+		_count = n;
+		mu.convertTo(_running_mean, CV_64F);
+		_scatter.release();
+
+	}
+
+	template <class T>
+	void PCA<T>::project(const cv::Mat_<T>& src, cv::Mat_<T>& dst, bool whiten) const {
+
+		assert(src.cols == _mean.cols);
+		const int k = _eigenvectors.rows;
+
+		// (x - mean) * W^T = x * W^T - mean * W^T
+		cv::Mat_<T> offset;
+		cv::gemm(_mean, _eigenvectors, 1, cv::Mat(), 0, offset, cv::GEMM_2_T);
+		std::vector<T> factor(k, T(1));
+		if(whiten) {
+			for(int p = 0; p < k; p++)
+				factor[p] = _eigenvalues(p) > 0 ? static_cast<T>(1.0 / std::sqrt((double) _eigenvalues(p))) : T(0);
+		}
+
+		cv::Mat_<T> ret(src.rows, k);
+		const int stripes = std::max(1, std::min(cv::getNumThreads(), src.rows / 1024));
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			cv::Mat_<T> tmp;
+			for(int s = range.start; s < range.end; s++) {
+				int begin = (size_t) s * src.rows / stripes, end = (size_t) (s + 1) * src.rows / stripes;
+				if(begin == end)
+					continue;
+				cv::gemm(src.rowRange(begin, end), _eigenvectors, 1, cv::Mat(), 0, tmp, cv::GEMM_2_T);
+				for(int i = 0; i < tmp.rows; i++) {
+					T* y = tmp.template ptr<T>(i);
+					T* r = ret.template ptr<T>(begin + i);
+					for(int p = 0; p < k; p++)
+						r[p] = (y[p] - offset(p)) * factor[p];
+				}
+			}
+		});
+
+		dst = ret;
+
+	}
+
+	template <class T>
+	void PCA<T>::backProject(const cv::Mat_<T>& src, cv::Mat_<T>& dst, bool whiten) const {
+
+		assert(src.cols == _eigenvectors.rows);
+		cv::Mat_<T> y = src.clone();
+		if(whiten) {
+			for(int i = 0; i < y.rows; i++) {
+				for(int p = 0; p < y.cols; p++)
+					y(i,p) *= static_cast<T>(std::sqrt(std::max(0.0, (double) _eigenvalues(p))));
+			}
+		}
+
+		cv::Mat_<T> ret;
+		cv::gemm(y, _eigenvectors, 1, cv::Mat(), 0, ret);
+		for(int i = 0; i < ret.rows; i++) {
+			T* x = ret.template ptr<T>(i);
+			for(int c = 0; c < ret.cols; c++)
+				x[c] += _mean(c);
+		}
+		dst = ret;
+
+	}
+
+	template <class T>
+	void PCA<T>::write(const std::string& path) const {
+		cv::FileStorage out(path, cv::FileStorage::WRITE);
+		out << "components" << _components;
+		out << "count" << (double) _count;
+		out << "total_variance" << _total_variance;
+		out << "mean" << _mean;
+		out << "eigenvectors" << _eigenvectors;
+		out << "eigenvalues" << _eigenvalues;
+		out.release();
+	}
+
+	template <class T>
+	void PCA<T>::read(const std::string& path) {
+
+		cv::FileStorage file(path, cv::FileStorage::READ);
+		assert(file.isOpened());
+
+		double count = 0;
+		cv::Mat mean, eigenvectors, eigenvalues;
+		file["components"] >> _components;
+		file["count"] >> count;
+		file["total_variance"] >> _total_variance;
+		file["mean"] >> mean;
+		file["eigenvectors"] >> eigenvectors;
+		file["eigenvalues"] >> eigenvalues;
+		file.release();
+
+		_count = count;
+		mean.convertTo(_mean, cv::DataType<T>::depth);
+		eigenvectors.convertTo(_eigenvectors, cv::DataType<T>::depth);
+		eigenvalues.convertTo(_eigenvalues, cv::DataType<T>::depth);
+
+		// The scatter Mat is not stored, so a loaded model can not be refined further
+		_mean.convertTo(_running_mean, CV_64F);
+		_scatter.release();
+
+	}
+
+	template <class T>
+	int PCA<T>::components() const {
+		return _eigenvectors.rows;
+	}
+
+	template <class T>
+	size_t PCA<T>::count() const {
+		return _count;
+	}
+
+	template <class T>
+	cv::Mat_<T> PCA<T>::mean() const {
+		return _mean;
+	}
+
+	template <class T>
+	cv::Mat_<T> PCA<T>::eigenvectors() const {
+		return _eigenvectors;
+	}
+
+	template <class T>
+	cv::Mat_<T> PCA<T>::eigenvalues() const {
+		return _eigenvalues;
+	}
+
+	template <class T>
+	cv::Mat_<T> PCA<T>::explainedVarianceRatio() const {
+		cv::Mat_<T> ret(1, _eigenvalues.cols, T(0));
+		if(_total_variance > 0) {
+			for(int p = 0; p < ret.cols; p++)
+				ret(p) = static_cast<T>(_eigenvalues(p) / _total_variance);
+		}
+		return ret;
+	}
+
+	template class PCA<float>;
+	template class PCA<double>;
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/mat_pair_view.h"
+
+namespace ocv {
+
+	/**
+	 * Principal component analysis for reducing the dimension of feature vectors.
+	 * The basis can be fitted either
+	 * - incrementally, batch by batch: mean and scatter Mat are merged with the pairwise
+	 *   update of Chan et al., so memory is bounded by the dimension, not the number of rows
+	 * - or by a randomized SVD (Halko et al.) of the data, which only computes the leading
+	 *   components and never forms the scatter Mat
+	 * Projection of feature Mats runs in parallel over blocks of rows. The fitted basis can
+	 * be written to and read from disk.
+	 */
+	template <class T>
+	class PCA {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param components the number of principal components to keep
+		 */
+		PCA(int components);
+
+		/**
+		 * Reads a PCA that was stored with write().
+		 */
+		PCA(const std::string& path);
+
+		/**
+		 * Fits the basis to all rows of data, discarding previous batches.
+		 */
+		void fit(const cv::Mat_<T>& data);
+
+		/**
+		 * Adds a batch of rows to the fitted model and updates the basis.
+		 * Each call solves an eigen problem of the feature dimension, so prefer large batches.
+		 * A model that was read from disk or fitted by fitRandomized() keeps no scatter Mat
+		 * to continue from, then the model is left unchanged.
+		 * @return false if the batch is empty or could not be merged into the model
+		 */
+		bool partialFit(const cv::Mat_<T>& batch);
+
+		/**
+		 * Adds the input vectors of all rows of the view and updates the basis once. The
+		 * view is merged in blocks of rows and not copied.
+		 * @return false if the view is empty or could not be merged into the model
+		 */
+		template <class T2>
+		bool partialFit(const ocv::MatPairView<T,T2>& view) {
+			if(view.rows() == 0)
+				return false;
+			// Only the first block can fail, the model is unchanged then
+			bool ok = true;
+			view.forEachBlock(4096, [this,&ok](const cv::Mat_<T>& block, const cv::Mat_<T2>&) {
+				ok = ok && _merge(block);
+			});
+			if(ok)
+				_solve();
+			return ok;
+		}
+
+		/**
+		 * Fits the leading components by a randomized SVD of the centered data.
+		 * @param data feature vectors, one per row
+		 * @param oversampling the number of additional random directions to sample
+		 * @param power_iterations the number of subspace iterations, improves accuracy for slowly decaying spectra
+		 * @param seed seed of the random projection. If zero, a random seed is used.
+		 */
+		void fitRandomized(const cv::Mat_<T>& data, int oversampling = 10, int power_iterations = 2, unsigned int seed = 0);
+
+		/**
+		 * Projects each row of src onto the components.
+		 * @param whiten whether to scale each component to unit variance
+		 */
+		void project(const cv::Mat_<T>& src, cv::Mat_<T>& dst, bool whiten = false) const;
+
+		/**
+		 * Maps projected vectors back to the feature space.
+		 */
+		void backProject(const cv::Mat_<T>& src, cv::Mat_<T>& dst, bool whiten = false) const;
+
+		/**
+		 * Stores mean, components and eigenvalues in a cv::FileStorage file.
+		 */
+		void write(const std::string& path) const;
+
+		/**
+		 * Replaces the model by the one stored in the file.
+		 */
+		void read(const std::string& path);
+
+		// Getter
+		int components() const;
+		size_t count() const;
+		cv::Mat_<T> mean() const;
+
+		// The components as rows, sorted by decreasing variance
+		cv::Mat_<T> eigenvectors() const;
+
+		// The variance of the data along each component
+		cv::Mat_<T> eigenvalues() const;
+
+		// The fraction of the total variance along each component
+		cv::Mat_<T> explainedVarianceRatio() const;
+
+	private:
+
+		// Merges the mean and scatter of a batch into the accumulators, false if they can not take it
+		bool _merge(const cv::Mat_<T>& batch);
+
+		// Solves the eigen problem of the accumulated scatter Mat
+		void _solve();
+
+		// Replaces the columns of m by an orthonormal basis of their span
+		static void _orthonormalize(cv::Mat_<T>& m);
+
+		int _components;
+		size_t _count;
+
+		// Double precision accumulators of the incremental fit
+		cv::Mat_<double> _running_mean;
+		cv::Mat_<double> _scatter;
+
+		double _total_variance;
+
+		cv::Mat_<T> _mean;
+		cv::Mat_<T> _eigenvectors;
+		cv::Mat_<T> _eigenvalues;
+
+	};
+
+}
@@ -0,0 +1,254 @@
+#include "oceancv/ml/streaming_aggregation.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace ocv {
+
+	template <class T>
+	QuantileSketch<T>::QuantileSketch(int k, unsigned int seed) : _levels(1), _k(k), _count(0), _size(0), _rng(seed), _seed(seed) {
+		assert(k >= 2);
+	}
+
+	template <class T>
+	size_t QuantileSketch<T>::_capacity(size_t level) const {
+		size_t depth = _levels.size() - 1 - level;
+		return std::max<size_t>(2, std::ceil(_k * std::pow(2. / 3., depth)));
+	}
+
+	template <class T>
+	void QuantileSketch<T>::add(T value) {
+		_levels[0].push_back(value);
+		_count++;
+		_size++;
+		_compress();
+	}
+
+	template <class T>
+	void QuantileSketch<T>::merge(const QuantileSketch<T>& other) {
+		if(other._levels.size() > _levels.size())
+			_levels.resize(other._levels.size());
+		for(size_t h = 0; h < other._levels.size(); h++)
+			_levels[h].insert(_levels[h].end(), other._levels[h].begin(), other._levels[h].end());
+		_count += other._count;
+		_size += other._size;
+		_compress();
+	}
+
+	template <class T>
+	void QuantileSketch<T>::_compress() {
+
+		size_t total_capacity = 0;
+		for(size_t h = 0; h < _levels.size(); h++)
+			total_capacity += _capacity(h);
+
+		while(_size > total_capacity) {
+
+			// Compact the lowest full level
+			for(size_t h = 0; h < _levels.size(); h++) {
+
+				if(_levels[h].size() < _capacity(h))
+					continue;
+
+				if(h + 1 == _levels.size())
+					_levels.emplace_back();
+
+				std::vector<T>& level = _levels[h];
+				std::sort(level.begin(), level.end());
+
+				// Up to k values no offset is drawn, so a random seed is only needed from now on
+				if(_seed == 0) {
+					_seed = std::random_device()();
+					_rng.seed(_seed);
+				}
+
+				// An odd value stays on this level
+				size_t pairs = level.size() / 2;
+				size_t offset = _rng() & 1;
+				for(size_t i = 0; i < pairs; i++)
+					_levels[h + 1].push_back(level[2 * i + offset]);
+				if(level.size() % 2 == 1)
+					level[0] = level.back();
+				level.resize(level.size() % 2);
+				_size -= pairs;
+				break;
+
+			}
+
+			total_capacity = 0;
+			for(size_t h = 0; h < _levels.size(); h++)
+				total_capacity += _capacity(h);
+
+		}
+
+	}
+
+	template <class T>
+	std::vector<std::pair<T,size_t>> QuantileSketch<T>::_sorted() const {
+		std::vector<std::pair<T,size_t>> ret;
+		ret.reserve(_size);
+		for(size_t h = 0; h < _levels.size(); h++)
+			for(T v : _levels[h])
+				ret.push_back({v, size_t(1) << h});
+		std::sort(ret.begin(), ret.end());
+		return ret;
+	}
+
+	template <class T>
+	T QuantileSketch<T>::quantile(double q) const {
+		return quantiles({q})[0];
+	}
+
+	template <class T>
+	std::vector<T> QuantileSketch<T>::quantiles(const std::vector<double>& qs) const {
+
+		assert(_count > 0);
+
+		std::vector<std::pair<T,size_t>> items = _sorted();
+		size_t total = 0;
+		for(auto& item : items)
+			total += item.second;
+
+		std::vector<T> ret;
+		for(double q : qs) {
+			// The first value whose cumulated weight exceeds q * total
+			double target = std::max(0., std::min(1., q)) * total;
+			size_t cum = 0;
+			T value = items.back().first;
+			for(auto& item : items) {
+				cum += item.second;
+				if(cum > target) {
+					value = item.first;
+					break;
+				}
+			}
+			ret.push_back(value);
+		}
+		return ret;
+
+	}
+
+	template <class T>
+	double QuantileSketch<T>::rank(T value) const {
+		if(_count == 0)
+			return 0;
+		size_t below = 0, total = 0;
+		for(size_t h = 0; h < _levels.size(); h++) {
+			for(T v : _levels[h]) {
+				total += size_t(1) << h;
+				if(v <= value)
+					below += size_t(1) << h;
+			}
+		}
+		return 1. * below / total;
+	}
+
+	template <class T>
+	size_t QuantileSketch<T>::count() const {
+		return _count;
+	}
+
+	template <class T>
+	size_t QuantileSketch<T>::size() const {
+		return _size;
+	}
+
+	template <class T>
+	int QuantileSketch<T>::k() const {
+		return _k;
+	}
+
+	template <class T>
+	StreamingAggregation<T>::StreamingAggregation(int k, unsigned int seed) : _count(0), _mean(0), _m2(0), _min(std::numeric_limits<T>::max()), _max(std::numeric_limits<T>::lowest()), _sketch(k, seed) {}
+
+	template <class T>
+	void StreamingAggregation<T>::add(T value) {
+		_count++;
+		double delta = value - _mean;
+		_mean += delta / _count;
+		_m2 += delta * (value - _mean);
+		_min = std::min(_min, value);
+		_max = std::max(_max, value);
+		_sketch.add(value);
+	}
+
+	template <class T>
+	void StreamingAggregation<T>::add(const cv::Mat_<T>& values) {
+		for(auto it = values.begin(); it != values.end(); ++it)
+			add(*it);
+	}
+
+	template <class T>
+	void StreamingAggregation<T>::merge(const StreamingAggregation<T>& other) {
+		if(other._count == 0)
+			return;
+		const double n_a = _count, n_b = other._count, n = n_a + n_b;
+		double delta = other._mean - _mean;
+		_mean += delta * n_b / n;
+		_m2 += other._m2 + delta * delta * n_a * n_b / n;
+		_count += other._count;
+		_min = std::min(_min, other._min);
+		_max = std::max(_max, other._max);
+		_sketch.merge(other._sketch);
+	}
+
+	template <class T>
+	ocv::Aggregation<T> StreamingAggregation<T>::aggregation(AggregationType at, DeviationType dt) const {
+		T val = at == AggregationType::MEDIAN ? median() : mean();
+		T dev = dt == DeviationType::STDDEV ? stdDev() : variance();
+		return ocv::Aggregation<T>(val, dev, _count, at, dt);
+	}
+
+	template <class T>
+	size_t StreamingAggregation<T>::count() const {
+		return _count;
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::mean() const {
+		return _mean;
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::variance() const {
+		return _count > 0 ? _m2 / _count : 0;
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::stdDev() const {
+		return std::sqrt(variance());
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::min() const {
+		return _min;
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::max() const {
+		return _max;
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::median() const {
+		return _count > 0 ? _sketch.quantile(0.5) : 0;
+	}
+
+	template <class T>
+	T StreamingAggregation<T>::quantile(double q) const {
+		return _count > 0 ? _sketch.quantile(q) : 0;
+	}
+
+	template <class T>
+	const QuantileSketch<T>& StreamingAggregation<T>::sketch() const {
+		return _sketch;
+	}
+
+	template class QuantileSketch<float>;
+	template class QuantileSketch<double>;
+
+	template class StreamingAggregation<float>;
+	template class StreamingAggregation<double>;
+
+}
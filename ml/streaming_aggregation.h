@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <random>
+
+#include "opencv2/core.hpp"
+
+#include "oceancv/ml/aggregation.h"
+
+namespace ocv {
+
+	/**
+	 * Mergeable quantile sketch (KLL). Values are kept in a hierarchy of compactors, a
+	 * value on level h stands for 2^h inserted values. Whenever a level is full, it is
+	 * sorted and every other value (starting at a random offset) is promoted to the next
+	 * level. With parameter k the rank error is about 1.7 / k with high probability, the
+	 * memory is O(k) values. Up to k values the quantiles are exact.
+	 * Sketches from threads or shards can be merged in any order.
+	 */
+	template <class T>
+	class QuantileSketch {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param k the capacity of the top level, controls the accuracy
+		 * @param seed seed of the random promotion offsets. If zero, a random seed is drawn at the first compaction.
+		 */
+		QuantileSketch(int k = 200, unsigned int seed = 0);
+
+		void add(T value);
+
+		/**
+		 * Adds the values of another sketch, the sketches should have the same k
+		 */
+		void merge(const QuantileSketch<T>& other);
+
+		/**
+		 * The value below which the fraction q of all values lies, q in [0,1]. As for
+		 * valg::median, quantile(0.5) of n values is the value with (0-based) rank n/2.
+		 */
+		T quantile(double q) const;
+
+		/**
+		 * Several quantiles at once, sorts the retained values only once
+		 */
+		std::vector<T> quantiles(const std::vector<double>& qs) const;
+
+		/**
+		 * Fraction of values that are smaller than or equal to value
+		 */
+		double rank(T value) const;
+
+		// Getter
+		size_t count() const;
+		// Number of retained values
+		size_t size() const;
+		int k() const;
+
+	private:
+
+		// Capacity of a level, shrinks by 2/3 per level below the top
+		size_t _capacity(size_t level) const;
+
+		// Compacts levels until the retained values fit
+		void _compress();
+
+		// Retained values with their weights, sorted by value
+		std::vector<std::pair<T,size_t>> _sorted() const;
+
+		std::vector<std::vector<T>> _levels;
+		int _k;
+		size_t _count;
+		size_t _size;
+		std::mt19937 _rng;
+		// Zero until the random seed is drawn at the first compaction
+		unsigned int _seed;
+
+	};
+
+	/**
+	 * Streaming aggregation of scalar values: count, mean and variance by Welford updates
+	 * (in double precision), minimum, maximum and a QuantileSketch for the median and
+	 * other quantiles. Partial aggregations merge exactly (count, mean, variance, min, max)
+	 * or approximately (quantiles), so values can be aggregated per thread, per image or
+	 * per dive and combined later without keeping them in memory.
+	 */
+	template <class T>
+	class StreamingAggregation {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param k the accuracy parameter of the quantile sketch
+		 * @param seed seed of the quantile sketch. If zero, a random seed is used.
+		 */
+		StreamingAggregation(int k = 200, unsigned int seed = 0);
+
+		void add(T value);
+
+		// Adds all values of the Mat
+		void add(const cv::Mat_<T>& values);
+
+		/**
+		 * Adds the values of another aggregation. Mean and variance are merged exactly by
+		 * Chan's formula.
+		 */
+		void merge(const StreamingAggregation<T>& other);
+
+		/**
+		 * Summary as an Aggregation: mean or median with the standard deviation or variance
+		 */
+		ocv::Aggregation<T> aggregation(AggregationType at = AggregationType::MEAN, DeviationType dt = DeviationType::VARIANCE) const;
+
+		// Getter
+		size_t count() const;
+		T mean() const;
+		// Population variance (divided by the count), the square of valg::deviation
+		T variance() const;
+		T stdDev() const;
+		T min() const;
+		T max() const;
+		T median() const;
+		T quantile(double q) const;
+		const QuantileSketch<T>& sketch() const;
+
+	private:
+
+		size_t _count;
+		double _mean;
+		// Sum of squared differences to the mean
+		double _m2;
+		T _min;
+		T _max;
+		QuantileSketch<T> _sketch;
+
+	};
+
+}
@@ -0,0 +1,158 @@
+#include "oceancv/ml/streaming_algorithms.h"
+
+#include <future>
+#include <limits>
+
+namespace ocv {
+
+	template <class T1, class T2>
+	ReservoirSampler<T1,T2>::ReservoirSampler(size_t items, unsigned int seed) : _items(items), _seen(0), _next(0), _w(1), _rng(seed == 0 ? std::random_device()() : seed), _uni(std::numeric_limits<double>::min(), 1.0) {}
+
+	template <class T1, class T2>
+	void ReservoirSampler<T1,T2>::_skip() {
+		double skip = std::floor(std::log(_uni(_rng)) / std::log(1 - _w)) + 1;
+		if(skip >= std::numeric_limits<size_t>::max() / 2)
+			_next = std::numeric_limits<size_t>::max();
+		else
+			_next += static_cast<size_t>(skip);
+	}
+
+	template <class T1, class T2>
+	void ReservoirSampler<T1,T2>::add(const ocv::MatPair<T1,T2>& mp) {
+		add(mp.i(), mp.o());
+	}
+
+	template <class T1, class T2>
+	void ReservoirSampler<T1,T2>::add(const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o) {
+
+		assert(mat_i.rows == mat_o.rows);
+		if(_items == 0 || mat_i.rows == 0)
+			return;
+
+		if(_mat_i.empty()) {
+			_mat_i.create(_items, mat_i.cols);
+			_mat_o.create(_items, mat_o.cols);
+		}
+		assert(mat_i.cols == _mat_i.cols && mat_o.cols == _mat_o.cols);
+
+		const size_t rows = mat_i.rows;
+		size_t r = 0;
+
+		// Fill the reservoir with the first rows of the stream
+		for(; r < rows && _seen < _items; r++, _seen++) {
+			std::copy(mat_i.template ptr<T1>(r), mat_i.template ptr<T1>(r) + mat_i.cols, _mat_i.template ptr<T1>(_seen));
+			std::copy(mat_o.template ptr<T2>(r), mat_o.template ptr<T2>(r) + mat_o.cols, _mat_o.template ptr<T2>(_seen));
+			if(_seen + 1 == _items) {
+				_w = std::exp(std::log(_uni(_rng)) / _items);
+				_next = _items - 1;
+				_skip();
+			}
+		}
+
+		// Jump directly to the rows that replace a random reservoir item
+		const size_t end = _seen + (rows - r);
+		std::uniform_int_distribution<size_t> slot(0, _items - 1);
+		while(_next < end) {
+			size_t src = r + (_next - _seen);
+			size_t dst = slot(_rng);
+			std::copy(mat_i.template ptr<T1>(src), mat_i.template ptr<T1>(src) + mat_i.cols, _mat_i.template ptr<T1>(dst));
+			std::copy(mat_o.template ptr<T2>(src), mat_o.template ptr<T2>(src) + mat_o.cols, _mat_o.template ptr<T2>(dst));
+			_w *= std::exp(std::log(_uni(_rng)) / _items);
+			_skip();
+		}
+		_seen = end;
+
+	}
+
+	template <class T1, class T2>
+	ocv::MatPair<T1,T2> ReservoirSampler<T1,T2>::sample() const {
+		int rows = std::min(_items, _seen);
+		if(rows == 0)
+			return ocv::MatPair<T1,T2>();
+		return ocv::MatPair<T1,T2>(_mat_i.rowRange(0, rows).clone(), _mat_o.rowRange(0, rows).clone());
+	}
+
+	template <class T1, class T2>
+	size_t ReservoirSampler<T1,T2>::seen() const {
+		return _seen;
+	}
+
+	template <class T1, class T2>
+	size_t ReservoirSampler<T1,T2>::items() const {
+		return _items;
+	}
+
+	template <class T>
+	void salg<T>::forEachChunk(ocv::MatChunkReader<T>& reader, const std::function<void(const cv::Mat_<T>&)>& func) {
+
+		reader.rewind();
+		cv::Mat_<T> current, next;
+		bool has_next = reader.next(current);
+
+		// Read ahead: the next chunk is parsed while func processes the current one
+		while(has_next) {
+			std::future<bool> pending = std::async(std::launch::async, [&reader, &next]() { return reader.next(next); });
+			func(current);
+			has_next = pending.get();
+			current = next;
+			next = cv::Mat_<T>();
+		}
+
+	}
+
+	template <class T>
+	ocv::ColumnStats<T> salg<T>::columnStats(ocv::MatChunkReader<T>& reader) {
+		ocv::ColumnStats<T> stats;
+		forEachChunk(reader, [&stats](const cv::Mat_<T>& chunk) {
+			stats.add(chunk);
+		});
+		return stats;
+	}
+
+	template <class T>
+	cv::Mat_<T> salg<T>::mean(ocv::MatChunkReader<T>& reader) {
+		return columnStats(reader).mean();
+	}
+
+	template <class T>
+	cv::Mat_<T> salg<T>::variance(ocv::MatChunkReader<T>& reader) {
+		return columnStats(reader).variance();
+	}
+
+	template <class T>
+	cv::Mat_<T> salg<T>::minElements(ocv::MatChunkReader<T>& reader) {
+		return columnStats(reader).min();
+	}
+
+	template <class T>
+	cv::Mat_<T> salg<T>::maxElements(ocv::MatChunkReader<T>& reader) {
+		return columnStats(reader).max();
+	}
+
+	template <class T>
+	ocv::VecPair<T> salg<T>::scaleRange(ocv::MatChunkReader<T>& reader, T new_min, T new_max) {
+		return columnStats(reader).scaleRange(new_min, new_max);
+	}
+
+	template <class T>
+	void salg<T>::randomSubset(ocv::MatChunkReader<T>& reader, ocv::MatPair<T,T>& dst, size_t items, int i_cols, unsigned int seed) {
+		ocv::ReservoirSampler<T,T> sampler(items, seed);
+		forEachChunk(reader, [&sampler, i_cols](const cv::Mat_<T>& chunk) {
+			assert(i_cols <= chunk.cols);
+			sampler.add(chunk.colRange(0, i_cols), chunk.colRange(i_cols, chunk.cols));
+		});
+		dst = sampler.sample();
+	}
+
+	template class ReservoirSampler<double,double>;
+	template class ReservoirSampler<double,float>;
+	template class ReservoirSampler<double,int>;
+
+	template class ReservoirSampler<float,double>;
+	template class ReservoirSampler<float,float>;
+	template class ReservoirSampler<float,int>;
+
+	template class salg<float>;
+	template class salg<double>;
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <random>
+#include <functional>
+
+#include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/vec_pair.h"
+#include "oceancv/ml/column_stats.h"
+#include "oceancv/ml/mat_chunk_reader.h"
+
+namespace ocv {
+
+	/**
+	 * Draws a uniform random subset of fixed size, without replacement, from a stream of
+	 * MatPair rows of unknown length. Memory is bounded by the subset size.
+	 * Uses the skipping reservoir sampling of Li (Algorithm L), so only O(k log(N/k))
+	 * random numbers are drawn and skipped rows are never copied.
+	 */
+	template <class T1, class T2 = T1>
+	class ReservoirSampler {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param items the size of the subset
+		 * @param seed seed of the random number generator, reproducible for equal seeds. If zero, a random seed is used.
+		 */
+		ReservoirSampler(size_t items, unsigned int seed = 0);
+
+		/**
+		 * Offers all rows of the MatPair to the reservoir.
+		 */
+		void add(const ocv::MatPair<T1,T2>& mp);
+
+		/**
+		 * Offers all rows of the two Mats to the reservoir, they need the same number of rows.
+		 */
+		void add(const cv::Mat_<T1>& mat_i, const cv::Mat_<T2>& mat_o);
+
+		/**
+		 * Returns the current subset, min(items, seen()) rows in no particular order.
+		 */
+		ocv::MatPair<T1,T2> sample() const;
+
+		// Getter
+		size_t seen() const;
+		size_t items() const;
+
+	private:
+
+		// Draws the number of rows to skip until the next replacement
+		void _skip();
+
+		size_t _items;
+		size_t _seen;
+
+		// Index of the next stream row that enters the reservoir
+		size_t _next;
+
+		// Algorithm L state
+		double _w;
+
+		std::mt19937 _rng;
+		std::uniform_real_distribution<double> _uni;
+
+		cv::Mat_<T1> _mat_i;
+		cv::Mat_<T2> _mat_o;
+
+	};
+
+	/**
+	 * Streaming equivalents of the malg / mpalg statistics for data that does not fit
+	 * into memory. Each function reads the file once, chunk by chunk, and reads the next
+	 * chunk while the current one is processed.
+	 */
+	template <class T>
+	class salg {
+
+	public:
+
+		/**
+		 * Computes count, minimum, maximum, mean and variance of all columns in one pass.
+		 * Prefer this to the single statistics below if more than one is needed.
+		 */
+		static ocv::ColumnStats<T> columnStats(ocv::MatChunkReader<T>& reader);
+
+		/**
+		 * Column-wise mean, as malg::mean.
+		 */
+		static cv::Mat_<T> mean(ocv::MatChunkReader<T>& reader);
+
+		/**
+		 * Column-wise (population) variance, as malg::variance.
+		 */
+		static cv::Mat_<T> variance(ocv::MatChunkReader<T>& reader);
+
+		/**
+		 * Column-wise minimum and maximum, as malg::minElements / malg::maxElements.
+		 */
+		static cv::Mat_<T> minElements(ocv::MatChunkReader<T>& reader);
+		static cv::Mat_<T> maxElements(ocv::MatChunkReader<T>& reader);
+
+		/**
+		 * Shift and scale factors, as malg::scaleRange.
+		 */
+		static ocv::VecPair<T> scaleRange(ocv::MatChunkReader<T>& reader, T new_min, T new_max);
+
+		/**
+		 * Uniform random subset of rows without replacement, the streaming version of
+		 * mpalg::randomSubset.
+		 * @param reader the chunk source
+		 * @param dst the result MatPair, holds the first i_cols values of each row as input and the rest as output
+		 * @param items the size of the subset
+		 * @param i_cols the number of input columns
+		 * @param seed seed of the random number generator. If zero, a random seed is used.
+		 */
+		static void randomSubset(ocv::MatChunkReader<T>& reader, ocv::MatPair<T,T>& dst, size_t items, int i_cols, unsigned int seed = 0);
+
+		/**
+		 * Calls func for each chunk of the reader. Starts from the first row of the file.
+		 */
+		static void forEachChunk(ocv::MatChunkReader<T>& reader, const std::function<void(const cv::Mat_<T>&)>& func);
+
+	};
+
+}
@@ -0,0 +1,246 @@
+#include "oceancv/ml/subset_cluster_index.h"
+
+namespace ocv {
+
+	template <class T>
+	SubsetClusterIndex<T>::SubsetClusterIndex(const cv::Mat_<T>& features, const std::vector<int>& labels) {
+		_init(features, labels);
+	}
+
+	template <class T>
+	SubsetClusterIndex<T>::SubsetClusterIndex(const ocv::MatPair<T,int>& mp, size_t o_col_idx) {
+		assert((int) o_col_idx < mp.oCols());
+		std::vector<int> labels(mp.rows());
+		for(int i = 0; i < mp.rows(); i++)
+			labels[i] = mp.o(i, o_col_idx);
+		_init(mp.i(), labels);
+	}
+
+	template <class T>
+	void SubsetClusterIndex<T>::_init(const cv::Mat_<T>& features, const std::vector<int>& labels) {
+
+		assert(features.rows > 0 && (int) labels.size() == features.rows);
+
+		_n = features.rows;
+		_d = features.cols;
+
+		// Map labels to class indices, sorted by label
+		std::map<int,int> indicator;
+		for(int l : labels)
+			indicator[l] = 0;
+		_k = 0;
+		for(auto& ind : indicator)
+			ind.second = _k++;
+		std::vector<int> cls(_n);
+		_counts.assign(_k, 0);
+		for(size_t i = 0; i < _n; i++) {
+			cls[i] = indicator[labels[i]];
+			_counts[cls[i]]++;
+		}
+
+		assert(_k > 1);
+
+		const int stripes = std::max(1, std::min(cv::getNumThreads(), (int) _n));
+		const int kd = _k * _d;
+
+		// First pass: class sums, each stripe into its own buffer
+		std::vector<double> part(stripes * kd, 0.0);
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			for(int s = range.start; s < range.end; s++) {
+				double* sum = &part[s * kd];
+				for(size_t i = s * _n / stripes; i < (s + 1) * _n / stripes; i++) {
+					const T* x = features.template ptr<T>(i);
+					double* cs = sum + cls[i] * _d;
+					for(int c = 0; c < _d; c++)
+						cs[c] += x[c];
+				}
+			}
+		});
+
+		_mean.assign(kd, 0.0);
+		_all_mean.assign(_d, 0.0);
+		for(int s = 0; s < stripes; s++) {
+			for(int j = 0; j < kd; j++)
+				_mean[j] += part[s * kd + j];
+		}
+		for(int j = 0; j < _k; j++) {
+			for(int c = 0; c < _d; c++) {
+				_all_mean[c] += _mean[j * _d + c] / _n;
+				_mean[j * _d + c] /= _counts[j];
+			}
+		}
+
+		// Second pass: deviations from the class means. Blocks of rows are centered and
+		// multiplied at once, so the cross-products are rank-k updates of the scatter Mat.
+		const int block = 1024;
+		std::vector<cv::Mat_<double>> part_within(stripes);
+		std::fill(part.begin(), part.end(), 0.0);
+		cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+			cv::Mat_<double> centered, tmp;
+			for(int s = range.start; s < range.end; s++) {
+				part_within[s] = cv::Mat_<double>(_d, _d, 0.0);
+				double* scatter = &part[s * kd];
+				size_t begin = s * _n / stripes, end = (s + 1) * _n / stripes;
+				for(size_t b = begin; b < end; b += block) {
+					int rows = std::min((size_t) block, end - b);
+					centered.create(rows, _d);
+					for(int r = 0; r < rows; r++) {
+						const T* x = features.template ptr<T>(b + r);
+						const double* m = &_mean[cls[b + r] * _d];
+						double* y = centered.template ptr<double>(r);
+						double* cs = scatter + cls[b + r] * _d;
+						for(int c = 0; c < _d; c++) {
+							y[c] = x[c] - m[c];
+							cs[c] += y[c] * y[c];
+						}
+					}
+					cv::mulTransposed(centered, tmp, true);
+					part_within[s] += tmp;
+				}
+			}
+		});
+
+		_scatter.assign(kd, 0.0);
+		_within = cv::Mat_<double>(_d, _d, 0.0);
+		for(int s = 0; s < stripes; s++) {
+			for(int j = 0; j < kd; j++)
+				_scatter[j] += part[s * kd + j];
+			_within += part_within[s];
+		}
+
+	}
+
+	template <class T>
+	std::vector<int> SubsetClusterIndex<T>::_columns(const std::vector<int>& selection) const {
+		assert((int) selection.size() == _d);
+		std::vector<int> ret;
+		for(int c = 0; c < _d; c++) {
+			if(selection[c] != 0)
+				ret.push_back(c);
+		}
+		return ret;
+	}
+
+	template <class T>
+	void SubsetClusterIndex<T>::_classScatter(const std::vector<int>& cols, std::vector<double>& scatter) const {
+		scatter.assign(_k, 0.0);
+		for(int j = 0; j < _k; j++) {
+			for(int c : cols)
+				scatter[j] += _scatter[j * _d + c];
+		}
+	}
+
+	template <class T>
+	T SubsetClusterIndex<T>::withinScatter(const std::vector<int>& selection) const {
+		std::vector<double> scatter;
+		_classScatter(_columns(selection), scatter);
+		double ret = 0;
+		for(double s : scatter)
+			ret += s;
+		return static_cast<T>(ret);
+	}
+
+	template <class T>
+	T SubsetClusterIndex<T>::betweenScatter(const std::vector<int>& selection) const {
+		std::vector<int> cols = _columns(selection);
+		double ret = 0, tmp;
+		for(int j = 0; j < _k; j++) {
+			for(int c : cols) {
+				tmp = _mean[j * _d + c] - _all_mean[c];
+				ret += _counts[j] * tmp * tmp;
+			}
+		}
+		return static_cast<T>(ret);
+	}
+
+	template <class T>
+	T SubsetClusterIndex<T>::calinskiHarabasz(const std::vector<int>& selection) const {
+		T within = withinScatter(selection);
+		if(within <= 0)
+			return 0;
+		return static_cast<T>(1.0 * betweenScatter(selection) / within * (_n - _k) / (_k - 1));
+	}
+
+	template <class T>
+	T SubsetClusterIndex<T>::varianceRatio(const std::vector<int>& selection) const {
+		T between = betweenScatter(selection);
+		T total = between + withinScatter(selection);
+		if(total <= 0)
+			return 0;
+		return between / total;
+	}
+
+	template <class T>
+	T SubsetClusterIndex<T>::daviesBouldin(const std::vector<int>& selection) const {
+
+		std::vector<int> cols = _columns(selection);
+		std::vector<double> spread;
+		_classScatter(cols, spread);
+		for(int j = 0; j < _k; j++)
+			spread[j] = std::sqrt(spread[j] / _counts[j]);
+
+		double ret = 0, maxfrac, dist, tmp;
+		for(int j = 0; j < _k; j++) {
+			maxfrac = 0;
+			for(int l = 0; l < _k; l++) {
+				if(j == l)
+					continue;
+				dist = 0;
+				for(int c : cols) {
+					tmp = _mean[j * _d + c] - _mean[l * _d + c];
+					dist += tmp * tmp;
+				}
+				if(dist > 0)
+					maxfrac = std::max(maxfrac, (spread[j] + spread[l]) / std::sqrt(dist));
+			}
+			ret += maxfrac;
+		}
+		return static_cast<T>(ret / _k);
+
+	}
+
+	template <class T>
+	T SubsetClusterIndex<T>::fisherCriterion(const std::vector<int>& selection) const {
+
+		std::vector<int> cols = _columns(selection);
+		const int s = cols.size();
+		if(s == 0)
+			return 0;
+
+		cv::Mat_<double> sw(s, s), sb(s, s, 0.0), diff(_k, s);
+		for(int a = 0; a < s; a++) {
+			for(int b = 0; b < s; b++)
+				sw(a,b) = _within(cols[a], cols[b]);
+		}
+
+		// Sb = sum_j n_j (m_j - m)(m_j - m)^T as one product of the weighted mean deviations
+		for(int j = 0; j < _k; j++) {
+			double w = std::sqrt((double) _counts[j]);
+			for(int a = 0; a < s; a++)
+				diff(j,a) = w * (_mean[j * _d + cols[a]] - _all_mean[cols[a]]);
+		}
+		cv::mulTransposed(diff, sb, true);
+
+		cv::Mat_<double> x;
+		if(!cv::solve(sw, sb, x, cv::DECOMP_CHOLESKY)) {
+			// Singular within scatter, e.g. due to constant columns
+			cv::solve(sw, sb, x, cv::DECOMP_SVD);
+		}
+		return static_cast<T>(cv::trace(x)[0]);
+
+	}
+
+	template <class T>
+	int SubsetClusterIndex<T>::classCount() const {
+		return _k;
+	}
+
+	template <class T>
+	int SubsetClusterIndex<T>::cols() const {
+		return _d;
+	}
+
+	template class SubsetClusterIndex<float>;
+	template class SubsetClusterIndex<double>;
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+
+#include "oceancv/ml/mat_pair_algorithms.h"
+
+namespace ocv {
+
+	/**
+	 * Rates the class separation of arbitrary subsets of the feature columns without
+	 * materializing the subset, e.g. as the fitness of a GeneticAlgorithm that selects
+	 * feature dimensions. Per-class column means, squared deviations and the pooled within-class
+	 * cross-product Mat are gathered once in the constructor. Afterwards the euclidean
+	 * scatter based indices cost O(k * |subset|) and the Fisher criterion O(|subset|^3),
+	 * independent of the number of feature vectors.
+	 * In contrast to ci, distances are euclidean: the normalized scalar distance depends on
+	 * the length of each subset vector and can thus not be derived from column statistics.
+	 * A selection is given as in mpalg::selectInputColumns: one entry per column, non-zero
+	 * entries select that column.
+	 */
+	template <class T>
+	class SubsetClusterIndex {
+	public:
+
+		/**
+		 * Constructor.
+		 * @param features the feature vectors, one per row
+		 * @param labels the class label of each row
+		 */
+		SubsetClusterIndex(const cv::Mat_<T>& features, const std::vector<int>& labels);
+
+		/**
+		 * Constructor that takes the class labels from the o_col_idx-th output column
+		 */
+		SubsetClusterIndex(const ocv::MatPair<T,int>& mp, size_t o_col_idx = 0);
+
+		/**
+		 * Summed squared distance of all vectors to their class mean, within the selected columns
+		 */
+		T withinScatter(const std::vector<int>& selection) const;
+
+		/**
+		 * Summed squared distance of the class means to the total mean, weighted by class size
+		 */
+		T betweenScatter(const std::vector<int>& selection) const;
+
+		/**
+		 * Calinski-Harabasz index: between / within scatter * (N - k) / (k - 1)
+		 */
+		T calinskiHarabasz(const std::vector<int>& selection) const;
+
+		/**
+		 * Fraction of the total scatter that is explained by the classes. Lies in [0,1] and
+		 * can thus directly be used as a GeneticAlgorithm fitness.
+		 */
+		T varianceRatio(const std::vector<int>& selection) const;
+
+		/**
+		 * Davies-Bouldin index with the root mean squared distance to the class mean as
+		 * class spread and the euclidean distance between class means. Lower is better.
+		 */
+		T daviesBouldin(const std::vector<int>& selection) const;
+
+		/**
+		 * Fisher criterion trace(Sw^-1 * Sb) of the within class scatter Mat Sw and the
+		 * between class scatter Mat Sb, restricted to the selected columns.
+		 */
+		T fisherCriterion(const std::vector<int>& selection) const;
+
+		// Getter
+		int classCount() const;
+		int cols() const;
+
+	private:
+
+		// Gathers all statistics
+		void _init(const cv::Mat_<T>& features, const std::vector<int>& labels);
+
+		// Indices of the selected columns
+		std::vector<int> _columns(const std::vector<int>& selection) const;
+
+		// Within class scatter per class, summed over the given columns
+		void _classScatter(const std::vector<int>& cols, std::vector<double>& scatter) const;
+
+
+		// Number of vectors, dimensions and classes
+		size_t _n;
+		int _d;
+		int _k;
+
+		// Vectors per class
+		std::vector<size_t> _counts;
+
+		// Class means and squared deviations from them per column, _k x _d
+		std::vector<double> _mean;
+		std::vector<double> _scatter;
+
+		// Mean of all vectors
+		std::vector<double> _all_mean;
+
+		// Pooled within class scatter Mat, _d x _d
+		cv::Mat_<double> _within;
+
+	};
+
+}
@@ -59,9 +59,9 @@ namespace ocv {
 
 	template<class T>
 	T valg<T>::median(const cv::Mat_<T>& vec) {
-		std::vector<T> v2(vec.end()-vec.begin());
-		std::copy(vec.begin(),vec.end(),v2.begin());
-		std::sort(v2.begin(),v2.end());
+		std::vector<T> v2(vec.begin(),vec.end());
+		// Only the median needs to be in place, not the whole vector sorted
+		std::nth_element(v2.begin(),v2.begin() + v2.size() / 2,v2.end());
 		return v2[v2.size() / 2];
 	}
 
@@ -0,0 +1,137 @@
+#include "oceancv/ml/approximate_cluster_indices.h"
+#include "oceancv/ml/model_selection.h"
+#include "oceancv/ml/subset_cluster_index.h"
+
+class TestClusterIndices : public ::testing::Test {
+protected:
+		virtual void SetUp() {
+			
+			mp = ocv::MatPair<double,int>(60,3,1,static_cast<double>(0),static_cast<int>(0));
+			
+			// Three noisy blobs in different directions, labels not starting at 0
+			for(int i = 0; i < mp.rows(); i++) {
+				int c = i % 3;
+				mp.i(i,0) = 1 + (c == 0 ? 5 : 0) + 0.1 * ((i * 7) % 5);
+				mp.i(i,1) = 1 + (c == 1 ? 5 : 0) + 0.1 * ((i * 3) % 7);
+				mp.i(i,2) = 1 + (c == 2 ? 5 : 0) + 0.1 * ((i * 11) % 3);
+				mp.o(i,0) = 2 * c + 1;
+			}
+			
+		}
+		ocv::MatPair<double,int> mp;
+};
+
+TEST_F(TestClusterIndices, engine) {
+	
+	ocv::ClusterIndexEngine<double> engine(mp.i(), 4);
+	engine.evaluate(mp, 0);
+	
+	EXPECT_EQ(engine.classCount(),3);
+	
+	std::vector<ocv::CI_TYPES> types = {ocv::CI_TYPES::CALINSKI_HARABASZ, ocv::CI_TYPES::INDEX_I, ocv::CI_TYPES::DAVIES_BOULDIN, ocv::CI_TYPES::INTER_CLASS_VARIANCE, ocv::CI_TYPES::INTRA_CLASS_VARIANCE};
+	for(auto t : types) {
+		double ref = ocv::ci<double,int>::compute(mp, t, 0);
+		EXPECT_NEAR(engine.index(t), ref, 1e-9 * std::max(1.0, std::abs(ref)));
+	}
+	
+	// Re-evaluating with fewer classes reuses the engine
+	std::vector<int> labels(mp.rows());
+	for(int i = 0; i < mp.rows(); i++)
+		labels[i] = (i % 3 == 0) ? 0 : 1;
+	engine.evaluate(labels);
+	EXPECT_EQ(engine.classCount(),2);
+	
+	cv::Mat_<double> means = engine.means();
+	EXPECT_NEAR(means(0,0), 6.2, 1e-9);
+	
+}
+
+TEST_F(TestClusterIndices, approximate) {
+	
+	std::vector<int> labels(mp.rows());
+	for(int i = 0; i < mp.rows(); i++)
+		labels[i] = mp.o(i,0);
+	
+	ocv::ApproximateClusterIndex<double> approx(mp.i(), labels, 42);
+	
+	// A sample larger than the data gives the exact value
+	auto est = approx.estimate(ocv::CI_TYPES::DAVIES_BOULDIN, 0.01, 0.95, 100);
+	EXPECT_EQ(est.samples,60);
+	double exact = ocv::ci<double,int>::compute(mp, ocv::CI_TYPES::DAVIES_BOULDIN, 0);
+	EXPECT_NEAR(est.value, exact, 1e-9);
+	EXPECT_DOUBLE_EQ(est.lower, est.upper);
+	
+	// Sampled estimates have to be close to the exact value
+	est = approx.estimate(ocv::CI_TYPES::INTRA_CLASS_VARIANCE, 0.2, 0.95, 12);
+	exact = ocv::ci<double,int>::compute(mp, ocv::CI_TYPES::INTRA_CLASS_VARIANCE, 0);
+	EXPECT_LE(est.lower, est.upper);
+	EXPECT_NEAR(est.value, exact, 0.5 * exact);
+	
+	// Well separated blobs
+	double sil = ocv::ApproximateClusterIndex<double>::silhouette(mp.i(), labels);
+	EXPECT_GT(sil, 0.8);
+	EXPECT_LE(sil, 1);
+	est = approx.silhouette(nullptr, 0.05, 0.95, 12);
+	EXPECT_NEAR(est.value, sil, 0.1);
+	
+	// An unreachable tolerance stops at the sample budget with an interval, not the exact value
+	est = approx.silhouette(nullptr, 0, 0.95, 12, 4, 24);
+	EXPECT_LT(est.lower, est.upper);
+	// Samples of about 12 and 24 rows, four repetitions each
+	EXPECT_GE(est.samples, 4 * (12 + 24));
+	EXPECT_LE(est.samples, 4 * (12 + 24 + 2 * 3));
+	
+	// Labels unrelated to the blobs have a silhouette close to 0, which converges absolutely
+	std::vector<int> mixed(mp.rows());
+	for(int i = 0; i < mp.rows(); i++)
+		mixed[i] = (i / 3) % 2;
+	ocv::ApproximateClusterIndex<double> approx_mixed(mp.i(), mixed, 42);
+	sil = ocv::ApproximateClusterIndex<double>::silhouette(mp.i(), mixed);
+	EXPECT_LT(std::abs(sil), 0.2);
+	est = approx_mixed.silhouette(nullptr, 0.2, 0.95, 16);
+	EXPECT_LT(est.samples, 4 * 8 * 16);
+	EXPECT_LT(est.lower, est.upper);
+	EXPECT_NEAR(est.value, sil, 0.2);
+	
+}
+
+TEST_F(TestClusterIndices, sweep) {
+	
+	ocv::ModelSelection<double> ms(mp.i());
+	auto results = ms.sweep({2,3,4}, ms.kMeans(), true, 2);
+	
+	ASSERT_EQ(results.size(),3);
+	EXPECT_EQ(results[1].setting,3);
+	EXPECT_EQ(results[1].classes,3);
+	double exact = ocv::ci<double,int>::compute(mp, ocv::CI_TYPES::DAVIES_BOULDIN, 0);
+	EXPECT_NEAR(results[1].indices[ocv::CI_TYPES::DAVIES_BOULDIN], exact, 1e-9);
+	
+	// Warm starts only change the initialization, not the labeling of the separated blobs
+	auto cold = ms.sweep({2,3,4}, ms.kMeans(), false);
+	EXPECT_NEAR(cold[1].indices[ocv::CI_TYPES::DAVIES_BOULDIN], results[1].indices[ocv::CI_TYPES::DAVIES_BOULDIN], 1e-9);
+	
+}
+
+TEST_F(TestClusterIndices, subset) {
+	
+	ocv::SubsetClusterIndex<double> sci(mp, 0);
+	EXPECT_EQ(sci.classCount(),3);
+	
+	std::vector<int> selection = {1,0,1};
+	ocv::MatPair<double,int> sub;
+	ocv::mpalg<double,int>::selectInputColumns(mp, sub, selection);
+	
+	// The within scatter equals the trace of the materialized within class scatter Mat
+	cv::Mat_<double> within = ocv::ci<double,int>::compute(sub, ocv::SC_TYPES::WITHIN_CLASS_SCATTER, 0);
+	EXPECT_NEAR(sci.withinScatter(selection), within(0,0) + within(1,1), 1e-9);
+	
+	double ratio = sci.varianceRatio(selection);
+	EXPECT_GT(ratio, 0.9);
+	EXPECT_LT(ratio, 1);
+	EXPECT_NEAR(sci.calinskiHarabasz(selection), ratio / (1 - ratio) * 57 / 2, 1e-6);
+	
+	// Column 1 alone only separates one of the three blobs
+	EXPECT_GT(sci.daviesBouldin({0,1,0}), sci.daviesBouldin({1,1,1}));
+	EXPECT_GT(sci.fisherCriterion({1,1,0}), sci.fisherCriterion({0,1,0}));
+	
+}
@@ -0,0 +1,336 @@
+#include <numeric>
+
+#include "oceancv/ml/color_descriptors.h"
+#include "oceancv/ml/integral_histogram.h"
+#include "oceancv/ml/co_occurrence_matrix.h"
+
+class TestFeatureDescriptor : public ::testing::Test {
+protected:
+		// Deterministic color image with some texture
+		static cv::Mat image(int rows, int cols, int seed) {
+			cv::Mat img(rows, cols, CV_8UC3);
+			for(int y = 0; y < rows; y++)
+				for(int x = 0; x < cols; x++)
+					for(int c = 0; c < 3; c++)
+						img.ptr<uchar>(y)[x * 3 + c] = (x * (c + 1) + 7 * y + 31 * seed + ((x * y) % 5) * 13) % 256;
+			return img;
+		}
+
+		// Batch extraction equals single extraction for each image
+		static void compare(const ocv::FeatureDescriptor<float>& desc, const std::vector<cv::Mat>& imgs) {
+			cv::Mat_<float> batch;
+			desc.extractBatch(imgs, batch);
+			ASSERT_EQ(batch.rows, (int) imgs.size());
+			ASSERT_EQ(batch.cols, desc.size());
+			cv::Mat_<float> vec(1, desc.size());
+			for(size_t i = 0; i < imgs.size(); i++) {
+				vec = 0;
+				desc.extract(imgs[i], vec);
+				for(int j = 0; j < vec.cols; j++)
+					EXPECT_FLOAT_EQ(batch(i, j), vec(j));
+			}
+		}
+};
+
+TEST_F(TestFeatureDescriptor, extractBatch) {
+
+	std::vector<cv::Mat> color, gray;
+	for(int i = 0; i < 9; i++) {
+		color.push_back(image(20 + i, 24, i));
+		cv::Mat g(color.back().rows, color.back().cols, CV_8UC1);
+		for(int y = 0; y < g.rows; y++)
+			for(int x = 0; x < g.cols; x++)
+				g.ptr<uchar>(y)[x] = color.back().ptr<uchar>(y)[x * 3 + 1];
+		gray.push_back(g);
+	}
+
+	compare(ocv::ColorValueDescriptor<float>(3, 2, 3), color);
+	compare(ocv::ColorStatisticDescriptor<float>(3, true, true, true, true, false), color);
+	compare(ocv::HistogramColorDescriptor<float>(3, 8), color);
+	compare(ocv::HaralickTextureDescriptor<float>(16), gray);
+
+	// Histograms of each channel sum to one
+	ocv::HistogramColorDescriptor<float> hcd(3, 8);
+	cv::Mat_<float> hists;
+	hcd.extractBatch(color, hists);
+	for(int c = 0; c < 3; c++) {
+		float sum = 0;
+		for(int b = 0; b < 8; b++)
+			sum += hists(0, c * 8 + b);
+		EXPECT_NEAR(sum, 1, 1e-5);
+	}
+
+	// Regions of one image give the same rows as copies of the regions
+	cv::Mat img = image(40, 60, 3);
+	std::vector<cv::Rect> rois;
+	std::vector<cv::Mat> tiles;
+	for(int y = 0; y < 2; y++) {
+		for(int x = 0; x < 3; x++) {
+			rois.push_back(cv::Rect(x * 20, y * 20, 20, 20));
+			tiles.push_back(img(rois.back()).clone());
+		}
+	}
+	cv::Mat_<float> from_rois(rois.size(), hcd.size()), from_tiles;
+	hcd.extractBatch(img, rois, from_rois);
+	hcd.extractBatch(tiles, from_tiles);
+	EXPECT_EQ(cv::norm(from_rois, from_tiles), 0);
+
+}
+
+TEST_F(TestFeatureDescriptor, imageContext) {
+
+	cv::Mat img = image(30, 40, 5);
+	cv::Mat gray;
+	cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+
+	ocv::ImageContext ctx(img);
+	EXPECT_EQ(ctx.gray().type(), CV_8UC1);
+	EXPECT_EQ(ctx.channels().size(), 3u);
+	EXPECT_EQ(ctx.pixels(), img.total());
+	for(int c = 0; c < 3; c++) {
+		size_t sum = 0;
+		for(size_t v : ctx.histogram(c))
+			sum += v;
+		EXPECT_EQ(sum, img.total());
+	}
+
+	// Context extraction equals the extraction from the image (or its gray version)
+	std::vector<std::pair<ocv::FeatureDescriptor<float>*,cv::Mat>> descs = {
+		{new ocv::ColorValueDescriptor<float>(3, 2, 3), img},
+		{new ocv::ColorStatisticDescriptor<float>(3, true, true, true, true, false), img},
+		{new ocv::HistogramColorDescriptor<float>(3, 8), img},
+		{new ocv::HaralickTextureDescriptor<float>(16), gray}
+	};
+	for(auto& desc : descs) {
+		cv::Mat_<float> a(1, desc.first->size()), b(1, desc.first->size());
+		desc.first->extract(desc.second, a);
+		desc.first->extractContext(ctx, b);
+		for(int j = 0; j < a.cols; j++)
+			EXPECT_NEAR(a(j), b(j), 1e-5);
+		delete desc.first;
+	}
+
+	// Masked pixels are not counted
+	cv::Mat mask(img.rows, img.cols, CV_8UC1);
+	for(int y = 0; y < mask.rows; y++)
+		for(int x = 0; x < mask.cols; x++)
+			mask.ptr<uchar>(y)[x] = x < 10 ? 255 : 0;
+	ocv::ImageContext masked(img, mask);
+	EXPECT_EQ(masked.pixels(), size_t(10 * img.rows));
+
+}
+
+TEST_F(TestFeatureDescriptor, integralHistogram) {
+
+	cv::Mat img = image(45, 70, 2);
+
+	// Overlapping grids at two scales, all aligned to 5 pixel cells
+	std::vector<cv::Rect> tiles = ocv::IntegralHistogram::grid(img.size(), cv::Size(20, 20), cv::Size(5, 5));
+	std::vector<cv::Rect> large = ocv::IntegralHistogram::grid(img.size(), cv::Size(40, 30), cv::Size(10, 15));
+	EXPECT_EQ(tiles.size(), size_t(6 * 11));
+	EXPECT_EQ(large.size(), size_t(2 * 4));
+	tiles.insert(tiles.end(), large.begin(), large.end());
+	tiles.push_back(cv::Rect(0, 0, img.cols, img.rows));
+
+	ocv::HistogramColorDescriptor<float> hcd(3, 8);
+	ocv::IntegralHistogram ih(img, 8, 5, cv::Mat(), 255 / 8);
+	EXPECT_EQ(ih.pixels(tiles.back()), img.total());
+
+	cv::Mat_<float> hists, moments;
+	ih.histograms(tiles, hists);
+	ih.moments(tiles, moments);
+
+	cv::Mat_<float> vec(1, hcd.size());
+	cv::Scalar mean, stddev;
+	for(size_t t = 0; t < tiles.size(); t++) {
+		cv::Mat tile = img(tiles[t]).clone();
+		hcd.extract(tile, vec);
+		for(int j = 0; j < vec.cols; j++)
+			EXPECT_FLOAT_EQ(hists(t, j), vec(j));
+		cv::meanStdDev(tile, mean, stddev);
+		for(int c = 0; c < 3; c++) {
+			EXPECT_NEAR(moments(t, c), mean[c], 1e-3);
+			EXPECT_NEAR(moments(t, 3 + c), stddev[c], 1e-3);
+		}
+	}
+
+	// The descriptor uses the integral histogram for overlapping regions
+	cv::Mat_<float> batch;
+	hcd.extractBatch(img, tiles, batch);
+	EXPECT_EQ(cv::norm(batch, hists), 0);
+
+	// Masked pixels are not counted
+	cv::Mat mask(img.rows, img.cols, CV_8UC1);
+	for(int y = 0; y < mask.rows; y++)
+		for(int x = 0; x < mask.cols; x++)
+			mask.ptr<uchar>(y)[x] = y % 2 == 0 ? 255 : 0;
+	ocv::IntegralHistogram masked(img, 4, 1, mask);
+	EXPECT_EQ(masked.pixels(cv::Rect(3, 4, 10, 10)), 50u);
+	std::vector<uint32_t> hist;
+	masked.histogram(cv::Rect(3, 4, 10, 10), hist);
+	EXPECT_EQ(hist.size(), 12u);
+	EXPECT_EQ(std::accumulate(hist.begin(), hist.begin() + 4, 0u), 50u);
+
+}
+
+TEST_F(TestFeatureDescriptor, coOccurrenceMatrix) {
+
+	// Pairs of a small image with two levels
+	cv::Mat img(2, 3, CV_8UC1);
+	uchar values[] = {0, 200, 0, 200, 0, 200};
+	for(int i = 0; i < 6; i++)
+		img.ptr<uchar>(i / 3)[i % 3] = values[i];
+	ocv::CoOccurrenceMatrix glcm(2, ocv::CoOccurrenceMatrix::offsets(1));
+	glcm.count(img);
+	// 3 vertical and 4 horizontal pairs between different levels, 2 diagonal pairs within a level
+	EXPECT_EQ(glcm.total(), 9);
+	EXPECT_EQ(glcm.at(0, 1), 4);
+	EXPECT_EQ(glcm.at(1, 0), 3);
+	EXPECT_EQ(glcm.at(0, 0) + glcm.at(1, 1), 2);
+	double f[ocv::NUM_HARALICK_TYPES];
+	glcm.features(f);
+	EXPECT_DOUBLE_EQ(f[ocv::CONTRAST], 7. / 9);
+	EXPECT_DOUBLE_EQ(f[ocv::ANGULAR_SECOND_MOMENT], 27. / 81);
+
+	// Counting and removing a region restores the matrix
+	glcm.count(img, cv::Rect(1, 0, 1, 2), cv::Mat(), -1);
+	glcm.count(img, cv::Rect(1, 0, 1, 2));
+	EXPECT_EQ(glcm.total(), 9);
+
+	// Sliding window maps equal counting each window
+	cv::Mat tex = image(25, 30, 4);
+	cv::Mat gray(tex.rows, tex.cols, CV_8UC1);
+	for(int y = 0; y < gray.rows; y++)
+		for(int x = 0; x < gray.cols; x++)
+			gray.ptr<uchar>(y)[x] = tex.ptr<uchar>(y)[x * 3];
+	std::vector<ocv::HARALICK_TYPES> types = {ocv::CONTRAST, ocv::CORRELATION, ocv::ENTROPY, ocv::SUM_VARIANCE};
+	std::vector<cv::Mat_<float>> maps;
+	ocv::CoOccurrenceMatrix engine(8, ocv::CoOccurrenceMatrix::offsets(2));
+	engine.textureMaps(gray, 3, types, maps);
+	ASSERT_EQ(maps.size(), types.size());
+	for(int y = 0; y < gray.rows; y += 4) {
+		for(int x = 0; x < gray.cols; x += 3) {
+			ocv::CoOccurrenceMatrix window(8, ocv::CoOccurrenceMatrix::offsets(2));
+			int x0 = std::max(0, x - 3), y0 = std::max(0, y - 3);
+			window.count(gray, cv::Rect(x0, y0, std::min(gray.cols, x + 4) - x0, std::min(gray.rows, y + 4) - y0));
+			window.features(f);
+			for(size_t t = 0; t < types.size(); t++)
+				EXPECT_NEAR(maps[t](y, x), f[types[t]], 1e-4);
+		}
+	}
+
+	// The descriptor reports the selected features of the patch
+	ocv::HaralickTextureDescriptor<float> htd(8, 2);
+	cv::Mat_<float> vec(1, htd.size());
+	htd.extract(gray, vec);
+	engine.clear();
+	engine.count(gray);
+	engine.features(f);
+	for(int j = 0; j < vec.cols; j++)
+		EXPECT_NEAR(vec(j), f[j], 1e-4);
+
+}
+
+TEST_F(TestFeatureDescriptor, colorStatistic) {
+
+	cv::Mat img = image(21, 33, 6);
+	cv::Mat mask(img.rows, img.cols, CV_8UC1);
+	for(int y = 0; y < mask.rows; y++)
+		for(int x = 0; x < mask.cols; x++)
+			mask.ptr<uchar>(y)[x] = (x + y) % 3 == 0 ? 255 : 0;
+
+	ocv::ColorStatisticDescriptor<float> csd(3, true, true, true, true, false);
+	cv::Mat_<float> vec(1, csd.size());
+	for(int masked = 0; masked < 2; masked++) {
+
+		csd.extract(img, vec, masked ? mask : cv::Mat());
+
+		// Reference statistics of the (masked) values by sorting
+		for(int c = 0; c < 3; c++) {
+			std::vector<int> values;
+			for(int y = 0; y < img.rows; y++)
+				for(int x = 0; x < img.cols; x++)
+					if(!masked || mask.ptr<uchar>(y)[x] == 255)
+						values.push_back(img.ptr<uchar>(y)[x * 3 + c]);
+			std::sort(values.begin(), values.end());
+			double mean = 0, var = 0;
+			for(int v : values)
+				mean += v;
+			mean /= values.size();
+			for(int v : values)
+				var += (v - mean) * (v - mean);
+			var /= values.size();
+
+			EXPECT_EQ(vec(2 * c), values.front());
+			EXPECT_EQ(vec(2 * c + 1), values.back());
+			EXPECT_NEAR(vec(6 + c), mean, 1e-3);
+			EXPECT_NEAR(vec(9 + c), std::sqrt(var), 1e-3);
+			EXPECT_EQ(vec(12 + c), values[values.size() / 2]);
+		}
+	}
+
+	// Exact quantiles from the histograms
+	ocv::ImageContext ctx(img);
+	std::vector<int> values;
+	for(int y = 0; y < img.rows; y++)
+		for(int x = 0; x < img.cols; x++)
+			values.push_back(img.ptr<uchar>(y)[x * 3 + 1]);
+	std::sort(values.begin(), values.end());
+	EXPECT_EQ(ctx.quantile(1, 0), values.front());
+	EXPECT_EQ(ctx.quantile(1, 0.9), values[size_t(0.9 * values.size())]);
+	EXPECT_EQ(ctx.quantile(1, 1), values.back());
+
+}
+
+TEST_F(TestFeatureDescriptor, denseColorFeatures) {
+
+	cv::Mat img = image(19, 26, 8);
+	cv::Mat mask(img.rows, img.cols, CV_8UC1);
+	for(int y = 0; y < mask.rows; y++)
+		for(int x = 0; x < mask.cols; x++)
+			mask.ptr<uchar>(y)[x] = (x * y) % 4 == 1 ? 0 : 255;
+
+	for(int stride = 1; stride <= 3; stride++) {
+
+		int grid_rows = (img.rows + stride - 1) / stride;
+		int grid_cols = (img.cols + stride - 1) / stride;
+
+		// Ring values equal extraction from the square patch centred at the pixel
+		ocv::ColorValueDescriptor<float> cvd(3, 2, 3);
+		int half = 3 * 2 + 1;
+		cv::Mat_<float> dense, vec(1, cvd.size());
+		cvd.dense(img, dense, stride, mask);
+		ASSERT_EQ(dense.rows, grid_rows * grid_cols);
+		for(int y = half; y + half < img.rows; y += stride) {
+			for(int x = half; x + half < img.cols; x += stride) {
+				if(y % stride != 0 || x % stride != 0)
+					continue;
+				cv::Rect roi(x - half, y - half, 2 * half + 1, 2 * half + 1);
+				cvd.extract(img(roi), vec, mask(roi));
+				for(int i = 0; i < cvd.size(); i++)
+					EXPECT_EQ(dense(y / stride * grid_cols + x / stride, i), vec(i));
+			}
+		}
+		// First sample of the second ring lies above the first pixel
+		EXPECT_EQ(dense(0, 3), -1);
+
+		// Window statistics equal extraction from the window, also at the border
+		ocv::ColorStatisticDescriptor<float> csd(3, true, true, true, true, true);
+		cv::Mat_<float> stats, ref(1, csd.size());
+		for(int masked = 0; masked < 2; masked++) {
+			stats = cv::Mat_<float>();
+			csd.dense(img, 2, stats, stride, masked ? mask : cv::Mat());
+			ASSERT_EQ(stats.rows, grid_rows * grid_cols);
+			for(int gy = 0; gy < grid_rows; gy++) {
+				for(int gx = 0; gx < grid_cols; gx++) {
+					int x0 = std::max(0, gx * stride - 2), y0 = std::max(0, gy * stride - 2);
+					cv::Rect roi(x0, y0, std::min(img.cols, gx * stride + 3) - x0, std::min(img.rows, gy * stride + 3) - y0);
+					csd.extract(img(roi), ref, masked ? mask(roi) : cv::Mat());
+					for(int i = 0; i < csd.size(); i++)
+						EXPECT_NEAR(stats(gy * grid_cols + gx, i), ref(i), 1e-4);
+				}
+			}
+		}
+	}
+
+}
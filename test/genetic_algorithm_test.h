@@ -0,0 +1,98 @@
+#include "oceancv/ml/genetic_algorithm.h"
+
+#include <atomic>
+
+class TestGeneticAlgorithm : public ::testing::Test {
+protected:
+		// Fraction of genes that match an alternating pattern
+		static float pattern(const std::vector<int>& individuum) {
+			float matches = 0;
+			for(size_t c = 0; c < individuum.size(); c++)
+				matches += individuum[c] == (int) (c % 2);
+			return matches / individuum.size();
+		}
+};
+
+TEST_F(TestGeneticAlgorithm, islands) {
+
+	// Function pointers still work
+	ocv::GeneticAlgorithm ga(pattern, 24, 4, 40, 0.95, 0.1, 0, 5);
+	std::pair<size_t,float> result = ga.optimize(0.1, 1, 300, 1);
+	EXPECT_FLOAT_EQ(result.second, 1);
+	EXPECT_FLOAT_EQ(pattern(ga.winner()), 1);
+
+	// The result only depends on the seed
+	std::atomic<size_t> calls(0);
+	ocv::GeneticAlgorithm::QualityFunction counted = [&calls](const std::vector<int>& individuum) {
+		calls++;
+		return pattern(individuum);
+	};
+	ocv::GeneticAlgorithm a(counted, 24, 4, 40, 0.95, 0.1, 0, 5);
+	ocv::GeneticAlgorithm b(pattern, 24, 4, 40, 0.95, 0.1, 0, 5);
+	for(int i = 0; i < 5; i++)
+		EXPECT_EQ(a.evolve(), b.evolve());
+	a.mergeNiches(2);
+	b.mergeNiches(2);
+	EXPECT_EQ(a.winner(), b.winner());
+
+	// Duplicates are rated once
+	EXPECT_EQ(calls, a.evaluations());
+	EXPECT_EQ(a.cacheSize(), a.evaluations());
+	
+	// The cache is bounded, and cleared at the start of a run
+	a.cacheLimit(50);
+	EXPECT_EQ(a.cacheSize(), 0);
+	a.evolve();
+	EXPECT_LE(a.cacheSize(), 50);
+	EXPECT_GT(a.cacheSize(), 0);
+	a.optimize(0, 1, 0);
+	EXPECT_EQ(a.cacheSize(), 0);
+	a.cacheFitness(false);
+	EXPECT_EQ(a.cacheSize(), 0);
+	size_t before = a.evaluations();
+	a.evolve();
+	EXPECT_GE(a.evaluations() - before, 4 * 40);
+
+}
+
+TEST_F(TestGeneticAlgorithm, bitGenome) {
+
+	std::vector<int> genes(130, 0);
+	genes[0] = genes[64] = genes[129] = 1;
+	ocv::BitGenome genome(genes);
+	EXPECT_EQ(genome.size(), 130);
+	EXPECT_EQ(genome.words().size(), 3);
+	EXPECT_EQ(genome.count(), 3);
+	EXPECT_EQ(genome.toVector(), genes);
+	EXPECT_TRUE(genome.get(64));
+	genome.flip(64);
+	EXPECT_FALSE(genome.get(64));
+
+	// Crossover with a mask takes the masked genes from the partner
+	ocv::BitGenome ones(130), zeros(130);
+	std::mt19937_64 rng(3);
+	ones.mutate(1, rng);
+	EXPECT_EQ(ones.count(), 130);
+	std::vector<uint64_t> mask = {0xff, 0, 1};
+	zeros.crossover(ones, mask);
+	EXPECT_EQ(zeros.count(), 9);
+	EXPECT_EQ(zeros.hamming(ones), 121);
+
+	// Mutation flips about the expected number of genes, tail bits stay clear
+	ocv::BitGenome large(100000);
+	large.mutate(0.01, rng);
+	EXPECT_NEAR(large.count(), 1000, 150);
+	ocv::BitGenome random(130);
+	random.randomize(rng);
+	EXPECT_EQ(random.words()[2] >> 2, 0);
+	ocv::BitGenome copy(random.toVector());
+	EXPECT_TRUE(copy == random);
+	EXPECT_EQ(copy.hash(), random.hash());
+
+	// A quality function can read the packed genes
+	ocv::GeneticAlgorithm ga([](const ocv::BitGenome& g) { return 1.f - 1.f * g.count() / g.size(); }, 200, 2, 30, 0.99, 0.1, 0, 1);
+	ga.optimize(0, 0, 300, 1);
+	EXPECT_EQ(ga.winnerGenome().count(), 0);
+	EXPECT_EQ(ga.winner(), std::vector<int>(200, 0));
+
+}
@@ -0,0 +1,94 @@
+#include "oceancv/ml/growing_neural_gas.h"
+
+#include <random>
+
+class TestGrowingNeuralGas : public ::testing::Test {
+protected:
+		virtual void SetUp() {
+			
+			// Three compact blobs, rows in random order
+			centers = cv::Mat_<double>(3,2);
+			centers(0,0) = 0; centers(0,1) = 0;
+			centers(1,0) = 10; centers(1,1) = 0;
+			centers(2,0) = 5; centers(2,1) = 8;
+			std::mt19937 rng(7);
+			std::normal_distribution<double> noise(0, 0.3);
+			std::uniform_int_distribution<int> blob(0, 2);
+			features = cv::Mat_<double>(600, 2);
+			for(int i = 0; i < features.rows; i++) {
+				int c = blob(rng);
+				features(i,0) = centers(c,0) + noise(rng);
+				features(i,1) = centers(c,1) + noise(rng);
+			}
+			
+		}
+		
+		static cv::Mat_<double> point(double x, double y) {
+			cv::Mat_<double> ret(1,2);
+			ret(0,0) = x;
+			ret(0,1) = y;
+			return ret;
+		}
+		
+		cv::Mat_<double> centers;
+		cv::Mat_<double> features;
+};
+
+TEST_F(TestGrowingNeuralGas, insertRemove) {
+	
+	// A node is inserted after every third sample, edges are removed once they aged by one
+	ocv::GrowingNeuralGas<double> gng(2, 10, 3, 0.05, 0.006, 0);
+	
+	// The first two samples become connected nodes
+	gng.adapt(point(0,0));
+	EXPECT_EQ(gng.nodeCount(),1);
+	gng.adapt(point(10,0));
+	EXPECT_EQ(gng.nodeCount(),2);
+	EXPECT_EQ(gng.edges().size(),1);
+	
+	// The third sample inserts a node between the two, which replaces their edge
+	gng.adapt(point(0,0));
+	ASSERT_EQ(gng.nodeCount(),3);
+	EXPECT_EQ(gng.edges().size(),2);
+	cv::Mat_<double> c = gng.centroids();
+	EXPECT_NEAR(c(2,0), 0.5 * (c(0,0) + c(1,0)), 1e-9);
+	EXPECT_EQ(gng.bestMatchIndex(point(5,0)),2);
+	
+	// The middle node wins with the first node as runner-up, the edge to the last node
+	// gets too old and the then isolated last node is removed
+	gng.adapt(point(4,0));
+	EXPECT_EQ(gng.nodeCount(),2);
+	ASSERT_EQ(gng.edges().size(),1);
+	c = gng.centroids();
+	EXPECT_LT(c(0,0), 1);
+	EXPECT_LT(c(1,0), 6);
+	
+	gng.reset();
+	EXPECT_EQ(gng.nodeCount(),0);
+	EXPECT_EQ(gng.samples(),0);
+	
+}
+
+TEST_F(TestGrowingNeuralGas, convergence) {
+	
+	ocv::GrowingNeuralGas<double> gng(2, 20, 50);
+	gng.cluster(features, 10);
+	
+	EXPECT_GE(gng.nodeCount(),3);
+	EXPECT_LE(gng.nodeCount(),20);
+	EXPECT_EQ(gng.samples(),6000);
+	
+	// Each blob is represented by a nearby prototype
+	cv::Mat_<double> c = gng.centroids();
+	for(int b = 0; b < centers.rows; b++) {
+		int best = gng.bestMatchIndex(centers.row(b));
+		EXPECT_LT(cv::norm(c.row(best), centers.row(b)), 0.5);
+	}
+	
+	// Small quantization error compared to the distance of the blobs
+	double qe = 0;
+	for(int i = 0; i < features.rows; i++)
+		qe += cv::norm(features.row(i), c.row(gng.bestMatchIndex(features.row(i))));
+	EXPECT_LT(qe / features.rows, 0.5);
+	
+}
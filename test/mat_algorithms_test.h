@@ -1,4 +1,8 @@
 #include "oceancv/ml/mat_algorithms.h"
+#include "oceancv/ml/column_stats.h"
+#include "oceancv/ml/feature_transform.h"
+#include "oceancv/ml/pca.h"
+#include "oceancv/ml/linear_regression.h"
 
 class TestMatAlgorithms : public ::testing::Test {
 protected:
@@ -156,3 +160,255 @@ TEST_F(TestMatAlgorithms, other) {
 	EXPECT_FLOAT_EQ(avg(2),ret[2](2));
 	
 }
+
+TEST_F(TestMatAlgorithms, covariance) {
+
+	cv::Mat_<float> cov;
+	ocv::malg<float>::covarianceMat(m, cov);
+	EXPECT_NEAR(cov(0,0),0.303333,1e-5);
+	EXPECT_NEAR(cov(0,1),0.95,1e-5);
+	EXPECT_NEAR(cov(1,0),0.95,1e-5);
+	EXPECT_NEAR(cov(1,2),-4,1e-5);
+	
+	cv::Mat_<float> ac;
+	ocv::malg<float>::autoCorrelation(m, ac);
+	EXPECT_NEAR(ac(0,0),2.07,1e-5);
+	EXPECT_NEAR(ac(1,2),-4,1e-5);
+	EXPECT_NEAR(ac(2,2),16./3,1e-5);
+
+}
+
+TEST_F(TestMatAlgorithms, columnStats) {
+
+	ocv::ColumnStats<float> stats;
+	stats.add(m);
+	
+	EXPECT_EQ(stats.count(),3);
+	EXPECT_FLOAT_EQ(stats.mean()(0),1.3666666);
+	EXPECT_FLOAT_EQ(stats.variance()(0),0.202222222);
+	EXPECT_FLOAT_EQ(stats.variance()(2),3.555555555);
+	EXPECT_FLOAT_EQ(stats.min()(2),-4);
+	EXPECT_FLOAT_EQ(stats.max()(1),3);
+	
+	// Accumulating in parts and merging gives the same result
+	ocv::ColumnStats<float> first, second;
+	first.add(m.rowRange(0,1));
+	second.add(m.rowRange(1,3));
+	first.merge(second);
+	for(int c = 0; c < 3; c++) {
+		EXPECT_FLOAT_EQ(first.mean()(c),stats.mean()(c));
+		EXPECT_FLOAT_EQ(first.variance()(c),stats.variance()(c));
+		EXPECT_FLOAT_EQ(first.min()(c),stats.min()(c));
+	}
+	
+	ocv::VecPair<float> expected = ocv::malg<float>::scaleRange(m, -1, 1);
+	ocv::VecPair<float> range = stats.scaleRange(-1, 1);
+	for(int c = 0; c < 3; c++) {
+		EXPECT_FLOAT_EQ(range.i()(c),expected.i()(c));
+		EXPECT_FLOAT_EQ(range.o()(c),expected.o()(c));
+	}
+
+}
+
+TEST_F(TestMatAlgorithms, featureTransform) {
+
+	// Fused scale and z-score equal the sequential application
+	ocv::VecPair<float> range = ocv::malg<float>::scaleRange(m, -1, 1);
+	cv::Mat_<float> expected = m.clone();
+	ocv::malg<float>::applyScaleRange(expected, range.i(), range.o());
+	ocv::ColumnStats<float> stats;
+	stats.add(expected);
+	ocv::malg<float>::applyZScore(expected, stats.mean(), stats.variance());
+	
+	ocv::FeatureTransform<float> ft;
+	ft.scaleRange(range.i(), range.o());
+	ft.zscore(stats.mean(), stats.variance());
+	EXPECT_EQ(ft.stages(),2);
+	
+	cv::Mat_<float> res;
+	ft.apply(m, res);
+	for(int r = 0; r < 3; r++) {
+		for(int c = 0; c < 3; c++)
+			EXPECT_NEAR(res(r,c),expected(r,c),1e-5);
+	}
+	
+	// In place
+	cv::Mat_<float> tmp = m.clone();
+	ft.apply(tmp);
+	EXPECT_NEAR(tmp(1,2),expected(1,2),1e-5);
+	
+	// Selection and normalization
+	ocv::FeatureTransform<float> sel;
+	sel.selectColumns({1,0,1});
+	sel.normalize(ocv::METRIC_TYPES::EUCLIDEAN);
+	EXPECT_EQ(sel.outputCols(3),2);
+	sel.apply(m, res);
+	EXPECT_EQ(res.cols,2);
+	EXPECT_NEAR(res(1,0),2/std::sqrt(20.f),1e-5);
+	EXPECT_NEAR(res(1,1),-4/std::sqrt(20.f),1e-5);
+	EXPECT_NEAR(res(0,0),1,1e-5);
+	
+	// PCA projection is centered
+	ocv::FeatureTransform<float> pca;
+	pca.fitPCA(m, 2);
+	pca.apply(m, res);
+	EXPECT_EQ(res.cols,2);
+	for(int c = 0; c < 2; c++)
+		EXPECT_NEAR(res(0,c) + res(1,c) + res(2,c),0,1e-4);
+	
+	// Whitening matches PCA::project, also for a component without variance
+	cv::Mat_<float> flat(4,3,1.f);
+	for(int r = 0; r < 4; r++) {
+		flat(r,0) = r;
+		flat(r,1) = r % 2;
+	}
+	ocv::FeatureTransform<float> white;
+	white.fitPCA(flat, 3, true);
+	ocv::PCA<float> direct(3);
+	direct.fit(flat);
+	ASSERT_LE(direct.eigenvalues()(2),0);
+	cv::Mat_<float> off = flat.clone(), projected;
+	off.col(2) += 2;
+	white.apply(off, res);
+	direct.project(off, projected, true);
+	for(int r = 0; r < 4; r++)
+		for(int c = 0; c < 3; c++)
+			EXPECT_NEAR(res(r,c),projected(r,c),1e-4);
+
+}
+
+TEST_F(TestMatAlgorithms, pca) {
+
+	// Random data with decreasing variance per column, rotated by a fixed orthogonal Mat
+	cv::Mat_<double> data(400,6), tmp;
+	cv::RNG rng(3);
+	rng.fill(data, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+	for(int c = 0; c < 6; c++)
+		data.col(c) *= 6 - c;
+	cv::Mat_<double> rotation(6,6), w, u, vt;
+	rng.fill(rotation, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+	cv::SVD::compute(rotation, w, u, vt);
+	tmp = data * u;
+	data = tmp + 2;
+	
+	ocv::PCA<double> full(3);
+	full.fit(data);
+	EXPECT_EQ(full.components(),3);
+	EXPECT_EQ(full.count(),400);
+	EXPECT_GT(full.eigenvalues()(0),full.eigenvalues()(1));
+	EXPECT_NEAR(full.mean()(0),data.col(0).dot(cv::Mat_<double>::ones(400,1)) / 400,1e-10);
+	
+	// Fitting in batches gives the same basis
+	ocv::PCA<double> batched(3);
+	EXPECT_TRUE(batched.partialFit(data.rowRange(0,150)));
+	EXPECT_TRUE(batched.partialFit(data.rowRange(150,400)));
+	EXPECT_FALSE(batched.partialFit(data.colRange(0,5)));
+	EXPECT_EQ(batched.count(),400);
+	for(int p = 0; p < 3; p++) {
+		EXPECT_NEAR(batched.eigenvalues()(p),full.eigenvalues()(p),1e-8);
+		EXPECT_NEAR(std::abs(batched.eigenvectors().row(p).dot(full.eigenvectors().row(p))),1,1e-8);
+	}
+	
+	// Whitened projections have unit variance, all components reconstruct the data
+	cv::Mat_<double> proj, back;
+	full.project(data, proj, true);
+	EXPECT_EQ(proj.cols,3);
+	ocv::ColumnStats<double> stats;
+	stats.add(proj);
+	for(int p = 0; p < 3; p++) {
+		EXPECT_NEAR(stats.mean()(p),0,1e-10);
+		EXPECT_NEAR(stats.variance()(p) * 400 / 399,1,1e-8);
+	}
+	
+	ocv::PCA<double> all(6);
+	all.fit(data);
+	all.project(data, proj);
+	all.backProject(proj, back);
+	EXPECT_NEAR(cv::norm(back - data),0,1e-8);
+
+}
+
+TEST_F(TestMatAlgorithms, randomizedPca) {
+
+	// Rank 5 signal in 50 dimensions plus isotropic noise
+	const int n = 500, d = 50, k = 5;
+	cv::RNG rng(11);
+	cv::Mat_<double> scores(n,k), basis(d,d), w, u, vt, noise(n,d), data;
+	rng.fill(scores, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+	for(int c = 0; c < k; c++)
+		scores.col(c) *= 10 - 1.5 * c;
+	rng.fill(basis, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(1));
+	cv::SVD::compute(basis, w, u, vt);
+	rng.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(0.3));
+	data = scores * u.colRange(0,k).t() + noise + 1;
+
+	ocv::PCA<double> exact(k);
+	exact.fit(data);
+
+	// The sampled range (k + 5 = 10 directions) is far smaller than the dimension
+	ocv::PCA<double> randomized(k);
+	randomized.fitRandomized(data, 5, 2, 7);
+	ASSERT_EQ(randomized.eigenvalues().cols,k);
+	for(int p = 0; p < k; p++) {
+		EXPECT_NEAR(randomized.eigenvalues()(p),exact.eigenvalues()(p),1e-3 * exact.eigenvalues()(p));
+		EXPECT_NEAR(std::abs(randomized.eigenvectors().row(p).dot(exact.eigenvectors().row(p))),1,1e-3);
+	}
+
+	// The spanned subspaces agree: projecting one basis onto the other keeps its norm
+	cv::Mat_<double> overlap = randomized.eigenvectors() * exact.eigenvectors().t();
+	EXPECT_NEAR(cv::norm(overlap) * cv::norm(overlap),k,1e-3);
+
+	cv::Mat_<double> ratio_exact = exact.explainedVarianceRatio(), ratio_randomized = randomized.explainedVarianceRatio();
+	EXPECT_NEAR(ratio_exact(0),ratio_randomized(0),1e-3);
+	
+	// Without a scatter Mat a randomized fit can not be continued, the model stays unchanged
+	cv::Mat_<double> eigenvalues = randomized.eigenvalues().clone();
+	EXPECT_FALSE(randomized.partialFit(data.rowRange(0,10)));
+	EXPECT_EQ(randomized.count(),n);
+	EXPECT_EQ(cv::norm(randomized.eigenvalues(),eigenvalues),0);
+
+}
+
+TEST_F(TestMatAlgorithms, linearRegression) {
+
+	// Two targets that depend linearly on three covariables
+	cv::Mat_<double> x(3000,3), y(3000,2), noise(3000,1);
+	cv::RNG rng(7);
+	rng.fill(x, cv::RNG::UNIFORM, cv::Scalar(0), cv::Scalar(10));
+	rng.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(0.1));
+	for(int i = 0; i < x.rows; i++) {
+		y(i,0) = 42 * x(i,0) + 12 * x(i,1) + 23 + noise(i);
+		y(i,1) = -3 * x(i,2) + 5;
+	}
+
+	ocv::LinearRegression<double> full(x,y);
+	EXPECT_EQ(full.count(),3000);
+	EXPECT_NEAR(full.regressionCoefficients()(0,0),42,1e-2);
+	EXPECT_NEAR(full.regressionCoefficients()(1,0),12,1e-2);
+	EXPECT_NEAR(full.regressionCoefficients()(2,0),0,1e-2);
+	EXPECT_NEAR(full.yIntersect(0),23,0.1);
+	EXPECT_NEAR(full.regressionCoefficients()(2,1),-3,1e-8);
+	EXPECT_NEAR(full.yIntersect(1),5,1e-8);
+	EXPECT_NEAR(full.sumOfSquaredDifferences(1),0,1e-6);
+	EXPECT_GT(full.determination(0),0.99);
+
+	// Fitting in chunks gives the same regression
+	ocv::LinearRegression<double> chunked(3,2);
+	chunked.partialFit(x.rowRange(0,1000),y.rowRange(0,1000));
+	chunked.partialFit(ocv::MatPair<double,double>(x.rowRange(1000,3000),y.rowRange(1000,3000)));
+	EXPECT_EQ(chunked.count(),3000);
+	EXPECT_NEAR(cv::norm(chunked.regressionCoefficients() - full.regressionCoefficients()),0,1e-8);
+	EXPECT_NEAR(chunked.yIntersect(0),full.yIntersect(0),1e-8);
+	EXPECT_NEAR(chunked.sumOfSquaredDifferences(0),full.sumOfSquaredDifferences(0),1e-6);
+
+	// The ridge term shrinks the coefficients
+	ocv::LinearRegression<double> ridge(x,y,1e5);
+	EXPECT_LT(cv::norm(ridge.regressionCoefficients().col(0)),cv::norm(full.regressionCoefficients().col(0)));
+	EXPECT_LT(ridge.determination(0),full.determination(0));
+
+	cv::Mat_<double> predicted = full.predictMat(x);
+	EXPECT_EQ(predicted.cols,2);
+	EXPECT_NEAR(predicted(17,0),full.predict(x.row(17),0),1e-8);
+	EXPECT_NEAR(predicted(2999,1),y(2999,1),1e-8);
+
+}
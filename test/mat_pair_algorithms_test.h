@@ -1,4 +1,10 @@
 #include "oceancv/ml/mat_pair_algorithms.h"
+#include "oceancv/ml/column_stats.h"
+#include "oceancv/ml/streaming_algorithms.h"
+
+#include <fstream>
+#include <cstdio>
+#include <set>
 
 class TestMatPairAlgorithms : public ::testing::Test {
 protected:
@@ -153,3 +159,123 @@ TEST_F(TestMatPairAlgorithms, other) {
 	EXPECT_EQ(isit,true);
 	
 }
+
+TEST_F(TestMatPairAlgorithms, covariance) {
+
+	std::map<int,cv::Mat_<float>> covs;
+	int classes = ocv::mpalg<float,int>::covarianceMats(mp, covs, 1);
+	EXPECT_EQ(classes,3);
+	
+	for(auto c : covs) {
+		cv::Mat_<float> cov;
+		ocv::mpalg<float,int>::covarianceMat(mp, cov, c.first, 1);
+		for(int j = 0; j < 3; j++) {
+			for(int k = 0; k < 3; k++) {
+				EXPECT_FLOAT_EQ(cov(j,k),c.second(j,k));
+			}
+		}
+	}
+	
+	// Label 2 only has the row (0,0,3.1), the mean of all rows is (1.84,3.24,-0.18)
+	EXPECT_NEAR(covs[2](0,2),-1.84 * 3.28,1e-4);
+
+}
+
+TEST_F(TestMatPairAlgorithms, groupedStats) {
+
+	std::map<int,ocv::ColumnStats<float>> stats = ocv::ColumnStats<float>::grouped(mp, 1);
+	EXPECT_EQ(stats.size(),3);
+	
+	cv::Mat_<float> mean, variance;
+	for(auto s : stats) {
+		int affected = ocv::mpalg<float,int>::zscore(mp, mean, variance, s.first, 1);
+		EXPECT_EQ(affected,s.second.count());
+		for(int c = 0; c < 3; c++) {
+			EXPECT_FLOAT_EQ(s.second.mean()(c),mean(c));
+			EXPECT_NEAR(s.second.variance()(c),variance(c),1e-5);
+		}
+	}
+
+}
+
+TEST_F(TestMatPairAlgorithms, viewStats) {
+
+	std::map<int,ocv::ColumnStats<float>> expected = ocv::ColumnStats<float>::grouped(mp, 1);
+	std::map<int,ocv::ColumnStats<float>> grouped = ocv::ColumnStats<float>::grouped(ocv::MatPairView<float,int>(mp), 1);
+	
+	ASSERT_EQ(grouped.size(),expected.size());
+	for(auto& g : expected) {
+		EXPECT_EQ(grouped[g.first].count(),g.second.count());
+		for(int c = 0; c < 3; c++) {
+			EXPECT_FLOAT_EQ(grouped[g.first].mean()(c),g.second.mean()(c));
+			EXPECT_FLOAT_EQ(grouped[g.first].variance()(c),g.second.variance()(c));
+		}
+	}
+
+}
+
+TEST_F(TestMatPairAlgorithms, streaming) {
+
+	// Write the MatPair as an ASCI file, one row per line
+	std::string path = "streaming_test.csv";
+	std::ofstream out(path);
+	out << "a,b,c,label" << std::endl;
+	for(int r = 0; r < mp.rows(); r++)
+		out << mp.i(r,0) << "," << mp.i(r,1) << "," << mp.i(r,2) << "," << mp.o(r,1) << std::endl;
+	out.close();
+	
+	// Chunks smaller than the file are read
+	ocv::MatChunkReader<float> reader(path, 2, ',', true);
+	ocv::ColumnStats<float> stats = ocv::salg<float>::columnStats(reader);
+	ocv::ColumnStats<float> expected;
+	expected.add(mp.i());
+	
+	EXPECT_EQ(reader.cols(),4);
+	EXPECT_EQ(reader.rowsRead(),5);
+	EXPECT_EQ(stats.count(),5);
+	for(int c = 0; c < 3; c++) {
+		EXPECT_NEAR(stats.mean()(c),expected.mean()(c),1e-5);
+		EXPECT_NEAR(stats.variance()(c),expected.variance()(c),1e-4);
+		EXPECT_FLOAT_EQ(stats.min()(c),expected.min()(c));
+		EXPECT_FLOAT_EQ(stats.max()(c),expected.max()(c));
+	}
+	EXPECT_FLOAT_EQ(ocv::salg<float>::maxElements(reader)(3),5);
+	
+	// A subset without replacement, labels stay attached to their rows
+	ocv::MatPair<float,float> subset;
+	ocv::salg<float>::randomSubset(reader, subset, 3, 3, 7);
+	EXPECT_EQ(subset.rows(),3);
+	EXPECT_EQ(subset.iCols(),3);
+	EXPECT_EQ(subset.oCols(),1);
+	std::set<float> firsts;
+	for(int r = 0; r < subset.rows(); r++) {
+		bool found = false;
+		for(int s = 0; s < mp.rows(); s++)
+			found |= subset.i(r,0) == mp.i(s,0) && subset.i(r,1) == mp.i(s,1) && subset.o(r,0) == mp.o(s,1);
+		EXPECT_TRUE(found);
+		firsts.insert(subset.i(r,0) * 100 + subset.i(r,2));
+	}
+	EXPECT_EQ(firsts.size(),3);
+	
+	std::remove(path.c_str());
+	
+	// Each row is drawn with the same probability
+	std::vector<int> hits(100,0);
+	cv::Mat_<float> ids(100,1);
+	cv::Mat_<int> labels(100,1,0);
+	for(int r = 0; r < 100; r++)
+		ids(r) = r;
+	for(unsigned int seed = 1; seed <= 500; seed++) {
+		ocv::ReservoirSampler<float,int> sampler(10, seed);
+		sampler.add(ids.rowRange(0,30), labels.rowRange(0,30));
+		sampler.add(ids.rowRange(30,100), labels.rowRange(30,100));
+		ocv::MatPair<float,int> s = sampler.sample();
+		for(int r = 0; r < s.rows(); r++)
+			hits[(int) s.i(r,0)]++;
+	}
+	for(int r = 0; r < 100; r++) {
+		EXPECT_GT(hits[r],20);
+		EXPECT_LT(hits[r],90);
+	}
+
+}
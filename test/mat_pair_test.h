@@ -1,4 +1,15 @@
 #include "oceancv/ml/mat_pair.h"
+#include "oceancv/ml/mat_pair_view.h"
+#include "oceancv/ml/pca.h"
+#include "oceancv/ml/linear_regression.h"
+#include "oceancv/ml/growing_neural_gas.h"
+#include "oceancv/ml/mat_pair_file.h"
+#include "oceancv/ml/chunked_mat_pair.h"
+#include "oceancv/ml/mat_pair_builder.h"
+#include "oceancv/ml/mat_pair_partition.h"
+
+#include <set>
+#include <cstdio>
 
 class TestMatPair : public ::testing::Test {
  protected:
@@ -39,3 +50,389 @@ TEST_F(TestMatPair, CopyingWorks) {
 	EXPECT_EQ(12, mp.o(12,0));
 	
 }
+
+TEST_F(TestMatPair, ViewsShareData) {
+	
+	ocv::MatPair<float,int> mp(6,3,1);
+	for(int r = 0; r < 6; r++) {
+		for(int c = 0; c < 3; c++)
+			mp.i(r,c) = r * 10 + c;
+		mp.o(r,0) = (r % 3 == 0) ? 7 : 2;
+	}
+	
+	ocv::MatPairView<float,int> view(mp);
+	EXPECT_EQ(view.rows(), 6);
+	EXPECT_TRUE(view.contiguousCols());
+	EXPECT_EQ(view.iPtr(2), mp.i().ptr<float>(2));
+	
+	// Row and column subsets compose and refer to the source rows
+	ocv::MatPairView<float,int> sub = view.selectRows({0,1,1,0,1,1}).selectInputColumns({1,0,1});
+	EXPECT_EQ(sub.rows(), 4);
+	EXPECT_EQ(sub.iCols(), 2);
+	EXPECT_FALSE(sub.contiguousCols());
+	EXPECT_EQ(sub.sourceRow(2), 4);
+	EXPECT_EQ(sub.i(2,1), 42);
+	
+	// Changes to the source are visible through the view
+	mp.i(4,2) = -1;
+	EXPECT_EQ(sub.i(2,1), -1);
+	
+	// Label groups are contiguous, sorted by label and keep the row order
+	std::vector<ocv::MatPairView<float,int>> groups = view.split(0);
+	ASSERT_EQ(groups.size(), 2);
+	EXPECT_EQ(groups[0].rows(), 4);
+	EXPECT_EQ(groups[1].rows(), 2);
+	EXPECT_EQ(groups[0].sourceRow(0), 1);
+	EXPECT_EQ(groups[0].sourceRow(3), 5);
+	EXPECT_EQ(groups[1].sourceRow(1), 3);
+	EXPECT_EQ(groups[1].o(1,0), 7);
+	
+	// Random subsets draw distinct rows
+	ocv::MatPairView<float,int> rnd = view.randomSubset(4, 3);
+	std::set<int> drawn;
+	for(int r = 0; r < rnd.rows(); r++)
+		drawn.insert(rnd.sourceRow(r));
+	EXPECT_EQ(drawn.size(), 4);
+	
+	ocv::MatPair<float,int> copy = groups[1].selectInputColumns({0,0,1}).copy();
+	EXPECT_EQ(copy.rows(), 2);
+	EXPECT_EQ(copy.iCols(), 1);
+	EXPECT_EQ(copy.i(1,0), 32);
+	EXPECT_EQ(copy.o(0,0), 7);
+	
+}
+
+TEST_F(TestMatPair, ViewsFeedTraining) {
+	
+	// Two targets that depend linearly on four inputs, a fifth input is not used
+	ocv::MatPair<double,double> mp(300,5,2);
+	for(int r = 0; r < mp.rows(); r++) {
+		for(int c = 0; c < 5; c++)
+			mp.i(r,c) = std::sin(r * (c + 1) * 0.37) + (c == 4 ? r % 2 : 0);
+		mp.o(r,0) = 1 + 2 * mp.i(r,0) - mp.i(r,2) + 0.5 * mp.i(r,3);
+		mp.o(r,1) = mp.i(r,1) - 3 * mp.i(r,3);
+	}
+	
+	// Every other row of one parity of the last input, without the last input
+	std::vector<int> rows(mp.rows()), cols = {1,1,1,1,0};
+	for(int r = 0; r < mp.rows(); r++)
+		rows[r] = (r % 4 != 3);
+	ocv::MatPairView<double,double> view = ocv::MatPairView<double,double>(mp).selectRows(rows).selectInputColumns(cols);
+	ocv::MatPair<double,double> copy = view.copy();
+	
+	// Blocks cover all rows once, also for views without gathering
+	int seen = 0;
+	view.forEachBlock(64, [&](const cv::Mat_<double>& i, const cv::Mat_<double>& o) {
+		EXPECT_LE(i.rows, 64);
+		EXPECT_EQ(i.cols, 4);
+		EXPECT_EQ(o.rows, i.rows);
+		EXPECT_EQ(i(0,1), copy.i(seen,1));
+		seen += i.rows;
+	});
+	EXPECT_EQ(seen, copy.rows());
+	ocv::MatPairView<double,double>(mp).range(10,20).forEachBlock(4, [&](const cv::Mat_<double>& i, const cv::Mat_<double>&) {
+		EXPECT_EQ(i.cols, 5);
+	});
+	
+	ocv::PCA<double> pca_view(2), pca_copy(2);
+	pca_view.partialFit(view);
+	pca_copy.fit(copy.i());
+	EXPECT_LT(cv::norm(pca_view.mean(), pca_copy.mean()), 1e-9);
+	EXPECT_LT(cv::norm(pca_view.eigenvalues(), pca_copy.eigenvalues()), 1e-9);
+	
+	ocv::LinearRegression<double> lr_view(4,2), lr_copy(4,2);
+	lr_view.partialFit(view);
+	lr_copy.partialFit(copy);
+	EXPECT_LT(cv::norm(lr_view.regressionCoefficients(), lr_copy.regressionCoefficients()), 1e-9);
+	EXPECT_NEAR(lr_view.regressionCoefficients()(0,0), 2, 1e-6);
+	EXPECT_NEAR(lr_view.yIntersect(0), 1, 1e-6);
+	
+	// Same samples in the same order give the same network
+	ocv::GrowingNeuralGas<double> gng_view(4,10,20), gng_copy(4,10,20);
+	gng_view.cluster(view, 2);
+	gng_copy.cluster(copy.i(), 2);
+	EXPECT_EQ(gng_view.samples(), 2 * copy.rows());
+	EXPECT_EQ(cv::norm(gng_view.centroids(), gng_copy.centroids()), 0);
+	
+}
+
+TEST_F(TestMatPair, BinaryFile) {
+	
+	ocv::MatPair<float,int> mp(7,5,2);
+	std::vector<uint64_t> index;
+	for(int r = 0; r < 7; r++) {
+		for(int c = 0; c < 5; c++)
+			mp.i(r,c) = r + c * 0.5;
+		mp.o(r,1) = r * r;
+		index.push_back(1000 + r);
+	}
+	
+	std::string path = "mat_pair_test.ocvmp";
+	EXPECT_TRUE((ocv::MatPairFile<float,int>::write(path, mp, index)));
+	
+	{
+		// The mapped Mats point into the file
+		ocv::MatPairFile<float,int> file(path);
+		ASSERT_TRUE(file.isOpen());
+		EXPECT_EQ(file.rows(), 7);
+		EXPECT_EQ(file.iCols(), 5);
+		EXPECT_EQ(file.oCols(), 2);
+		EXPECT_EQ(file.i()(6,4), 8);
+		EXPECT_EQ(file.o()(5,1), 25);
+		EXPECT_EQ(file.index()[3], 1003);
+		EXPECT_EQ(reinterpret_cast<size_t>(file.i().data) % ocv::MATPAIR_FILE_ALIGNMENT, 0);
+		EXPECT_EQ(file.view().split(1).size(), 7);
+	}
+	
+	ocv::MatPair<float,int> loaded;
+	EXPECT_TRUE((ocv::MatPairFile<float,int>::read(path, loaded)));
+	EXPECT_EQ(loaded.rows(), 7);
+	EXPECT_EQ(loaded.i(2,3), mp.i(2,3));
+	EXPECT_EQ(loaded.o(4,1), 16);
+	
+	// The value types are checked
+	ocv::MatPairFile<double,int> wrong(path);
+	EXPECT_FALSE(wrong.isOpen());
+	
+	// Rows can be written in any order
+	{
+		ocv::MatPairFileWriter<float,int> writer(path, 7, 5, 2);
+		writer.write(4, mp.i().rowRange(4,7), mp.o().rowRange(4,7));
+		writer.write(0, mp.i().rowRange(0,4), mp.o().rowRange(0,4));
+		EXPECT_TRUE(writer.close());
+	}
+	ocv::MatPairFile<float,int> file(path);
+	EXPECT_EQ(file.index(), nullptr);
+	EXPECT_EQ(file.i()(5,2), mp.i(5,2));
+	
+	// Crafted headers are rejected: a misaligned block, and a size that overflows to 0
+	auto craft = [&](std::function<void(ocv::MatPairFileHeader&)> change) {
+		ocv::MatPairFileHeader header;
+		FILE* f = std::fopen(path.c_str(), "r+b");
+		ASSERT_EQ(std::fread(&header, sizeof(header), 1, f), 1);
+		change(header);
+		std::fseek(f, 0, SEEK_SET);
+		std::fwrite(&header, sizeof(header), 1, f);
+		std::fclose(f);
+	};
+	EXPECT_TRUE((ocv::MatPairFile<float,int>::write(path, mp)));
+	craft([](ocv::MatPairFileHeader& h) { h.i_offset += 4; });
+	EXPECT_FALSE((ocv::MatPairFile<float,int>(path).isOpen()));
+	EXPECT_TRUE((ocv::MatPairFile<float,int>::write(path, mp)));
+	craft([](ocv::MatPairFileHeader& h) { h.rows = uint64_t(1) << 62; h.i_cols = 4; });
+	EXPECT_FALSE((ocv::MatPairFile<float,int>(path).isOpen()));
+	EXPECT_FALSE((ocv::MatPairFile<float,int>::read(path, loaded)));
+	
+	std::remove(path.c_str());
+	
+	// A file that can not be created is reported by close()
+	ocv::MatPairFileWriter<float,int> missing("no_such_directory/mat_pair_test.ocvmp", 7, 5, 2);
+	EXPECT_FALSE(missing.isOpen());
+	EXPECT_FALSE(missing.close());
+	
+}
+
+TEST_F(TestMatPair, ChunkedFile) {
+	
+	// Integer valued histogram features, as e.g. the MPEG7 descriptors
+	ocv::MatPair<float,int> mp(2500,32,2);
+	cv::RNG rng(1);
+	for(int r = 0; r < mp.rows(); r++) {
+		for(int c = 0; c < 32; c++)
+			mp.i(r,c) = rng.uniform(0, 16);
+		mp.o(r,0) = r;
+		mp.o(r,1) = r % 7;
+	}
+	
+	std::string path = "mat_pair_test.ocvmpz";
+	for(ocv::CODEC_TYPES codec : {ocv::CODEC_NONE, ocv::CODEC_RLE, ocv::CODEC_LZ4, ocv::CODEC_ZSTD}) {
+		
+		if(!ocv::codecAvailable(codec))
+			continue;
+		
+		EXPECT_TRUE((ocv::ChunkedMatPairWriter<float,int>::write(path, mp, codec, 300)));
+		
+		ocv::ChunkedMatPairReader<float,int> reader(path);
+		ASSERT_TRUE(reader.isOpen());
+		EXPECT_EQ(reader.rows(), 2500);
+		EXPECT_EQ(reader.chunkCount(), 9);
+		EXPECT_EQ(reader.codec(), codec);
+		if(codec != ocv::CODEC_NONE)
+			EXPECT_LT(reader.compressedBytes(), 2500 * 34 * 4 * 2 / 3);
+		
+		// Random access to a range that spans several chunks
+		ocv::MatPair<float,int> part;
+		EXPECT_TRUE(reader.read(250, 1010, part));
+		EXPECT_EQ(part.rows(), 760);
+		for(int r = 0; r < part.rows(); r += 37) {
+			EXPECT_EQ(part.i(r,5), mp.i(250 + r,5));
+			EXPECT_EQ(part.o(r,0), 250 + r);
+		}
+		
+		ocv::MatPair<float,int> all;
+		EXPECT_TRUE(reader.read(all));
+		EXPECT_EQ(cv::norm(all.i() - mp.i()), 0);
+		EXPECT_EQ(all.o(2499,1), 2499 % 7);
+		
+		EXPECT_TRUE(reader.readChunk(8, part));
+		EXPECT_EQ(part.rows(), 100);
+		EXPECT_EQ(part.o(0,0), 2400);
+		
+	}
+	
+	// Appending in pieces that do not match the chunks
+	{
+		ocv::ChunkedMatPairWriter<float,int> writer(path, 32, 2, ocv::CODEC_RLE, 64);
+		writer.append(mp.i().rowRange(0,100), mp.o().rowRange(0,100));
+		writer.append(mp.i().rowRange(100,2500), mp.o().rowRange(100,2500));
+		EXPECT_EQ(writer.rows(), 2500);
+		EXPECT_TRUE(writer.close());
+	}
+	ocv::ChunkedMatPairReader<float,int> reader(path);
+	ocv::MatPair<float,int> all;
+	EXPECT_TRUE(reader.read(all));
+	EXPECT_EQ(cv::norm(all.i() - mp.i()), 0);
+	
+	// Crafted headers are rejected: no rows per chunk, and a chunk count that does not match the rows
+	auto craft = [&](std::function<void(ocv::ChunkedMatPairHeader&)> change) {
+		EXPECT_TRUE((ocv::ChunkedMatPairWriter<float,int>::write(path, mp, ocv::CODEC_NONE, 300)));
+		ocv::ChunkedMatPairHeader header;
+		FILE* f = std::fopen(path.c_str(), "r+b");
+		ASSERT_EQ(std::fread(&header, sizeof(header), 1, f), 1);
+		change(header);
+		std::fseek(f, 0, SEEK_SET);
+		std::fwrite(&header, sizeof(header), 1, f);
+		std::fclose(f);
+	};
+	craft([](ocv::ChunkedMatPairHeader& h) { h.chunk_rows = 0; });
+	EXPECT_FALSE((ocv::ChunkedMatPairReader<float,int>(path).isOpen()));
+	craft([](ocv::ChunkedMatPairHeader& h) { h.rows = 5000; });
+	EXPECT_FALSE((ocv::ChunkedMatPairReader<float,int>(path).isOpen()));
+	craft([](ocv::ChunkedMatPairHeader& h) { h.chunk_count = 8; });
+	EXPECT_FALSE((ocv::ChunkedMatPairReader<float,int>(path).isOpen()));
+	craft([](ocv::ChunkedMatPairHeader& h) { h.rows = uint64_t(1) << 60; h.chunk_count = h.rows / 300 + 1; });
+	EXPECT_FALSE((ocv::ChunkedMatPairReader<float,int>(path).isOpen()));
+	
+	std::remove(path.c_str());
+	
+}
+
+TEST_F(TestMatPair, Builder) {
+	
+	// Each stripe appends to its own shard
+	ocv::MatPairBuilder<float,int> builder(3, 1, 4, 8);
+	cv::parallel_for_(cv::Range(0, 4), [&](const cv::Range& range) {
+		for(int s = range.start; s < range.end; s++) {
+			for(int r = 0; r < 100; r++) {
+				float vec[3] = {(float) s, (float) r, 0.5f};
+				int label = s * 100 + r;
+				builder.append(vec, &label, s);
+			}
+		}
+	});
+	
+	EXPECT_EQ(builder.rows(), 400);
+	EXPECT_EQ(builder.rows(2), 100);
+	
+	// Rows are ordered by shard, then by insertion
+	ocv::MatPair<float,int> mp = builder.finalize();
+	EXPECT_EQ(mp.rows(), 400);
+	for(int r = 0; r < 400; r++)
+		EXPECT_EQ(mp.o(r,0), r);
+	EXPECT_EQ(mp.i(250,0), 2);
+	EXPECT_EQ(mp.i(250,1), 50);
+	
+	std::string path = "mat_pair_test.ocvmp";
+	EXPECT_TRUE(builder.finalize(path));
+	{
+		ocv::MatPairFile<float,int> file(path);
+		EXPECT_EQ(file.rows(), 400);
+		EXPECT_EQ(cv::norm(file.i() - mp.i()), 0);
+	}
+	EXPECT_TRUE(builder.finalize(path, ocv::CODEC_RLE, 64));
+	{
+		ocv::ChunkedMatPairReader<float,int> reader(path);
+		ocv::MatPair<float,int> read;
+		EXPECT_TRUE(reader.read(read));
+		EXPECT_EQ(cv::norm(read.i() - mp.i()), 0);
+		EXPECT_EQ(read.o(399,0), 399);
+	}
+	std::remove(path.c_str());
+	
+	builder.clear();
+	EXPECT_EQ(builder.rows(), 0);
+	builder.append(mp);
+	EXPECT_EQ(builder.finalize().i(399,1), 99);
+	
+}
+
+TEST_F(TestMatPair, ExternalPartition) {
+	
+	// Labels 0..6 in a fixed pattern, the input stores the source row
+	const int rows = 1000;
+	cv::Mat_<float> mat_i(rows,2);
+	cv::Mat_<int> mat_o(rows,2);
+	for(int r = 0; r < rows; r++) {
+		mat_i(r,0) = r;
+		mat_i(r,1) = -r;
+		mat_o(r,0) = r;
+		mat_o(r,1) = (r * 7 + 3) % 11 % 7;
+	}
+	ocv::MatPair<float,int> mp(mat_i,mat_o);
+	std::string src = "mat_pair_test_src.ocvmp";
+	std::string dst = "mat_pair_test_dst.ocvmp";
+	EXPECT_TRUE((ocv::MatPairFile<float,int>::write(src, mp)));
+	
+	// A small memory limit forces several writes per label
+	std::vector<std::pair<int,cv::Range>> segments;
+	EXPECT_TRUE(ocv::MatPairPartition<float>::partition(src, dst, segments, 1, 4096));
+	
+	std::vector<std::pair<int,cv::Range>> groups;
+	ocv::MatPairView<float,int>(mp).partition(1, groups);
+	EXPECT_EQ(segments.size(), groups.size());
+	
+	{
+		ocv::MatPairFile<float,int> file(dst);
+		EXPECT_EQ(file.rows(), (size_t) rows);
+		ocv::MatPairView<float,int> view = file.view();
+		for(size_t s = 0; s < segments.size(); s++) {
+			EXPECT_EQ(segments[s].first, groups[s].first);
+			EXPECT_EQ(segments[s].second.size(), groups[s].second.size());
+			// Rows of one label keep their order
+			int prev = -1;
+			for(int r = segments[s].second.start; r < segments[s].second.end; r++) {
+				EXPECT_EQ(view.o(r,1), segments[s].first);
+				EXPECT_GT(view.o(r,0), prev);
+				EXPECT_EQ(view.i(r,1), -view.o(r,0));
+				EXPECT_EQ((int) file.index()[r], view.o(r,0));
+				prev = view.o(r,0);
+			}
+		}
+		std::vector<std::pair<int,cv::Range>> found;
+		EXPECT_TRUE(ocv::MatPairPartition<float>::segments(file, found, 1));
+		EXPECT_EQ(found.size(), segments.size());
+		EXPECT_EQ(found.back().second.end, rows);
+	}
+	{
+		// The source is not grouped by label
+		ocv::MatPairFile<float,int> file(src);
+		std::vector<std::pair<int,cv::Range>> found;
+		EXPECT_FALSE(ocv::MatPairPartition<float>::segments(file, found, 1));
+	}
+	std::remove(dst.c_str());
+	
+	std::vector<int> labels;
+	EXPECT_TRUE(ocv::MatPairPartition<float>::partitionToFiles(src, "mat_pair_test_label_", labels, 1, 4096));
+	EXPECT_EQ(labels.size(), segments.size());
+	for(size_t l = 0; l < labels.size(); l++) {
+		std::string path = ocv::MatPairPartition<float>::labelPath("mat_pair_test_label_", labels[l]);
+		{
+			ocv::MatPairFile<float,int> file(path);
+			EXPECT_EQ((int) file.rows(), segments[l].second.size());
+			EXPECT_EQ(file.o()(0,1), labels[l]);
+		}
+		std::remove(path.c_str());
+	}
+	std::remove(src.c_str());
+	
+}
@@ -0,0 +1,97 @@
+#include "oceancv/ml/mpeg7_descriptors.h"
+
+class TestMPEG7Descriptors : public TestFeatureDescriptor {
+protected:
+		// Extraction of each image on its own
+		static cv::Mat_<float> single(const ocv::FeatureDescriptor<float>& desc, const std::vector<cv::Mat>& imgs, const std::vector<cv::Mat>& masks) {
+			cv::Mat_<float> ret(imgs.size(), desc.size());
+			cv::Mat_<float> vec;
+			for(size_t i = 0; i < imgs.size(); i++) {
+				vec = ret.row(i);
+				desc.extract(imgs[i], vec, masks.empty() ? cv::Mat() : masks[i]);
+			}
+			return ret;
+		}
+};
+
+TEST_F(TestMPEG7Descriptors, extractBatch) {
+
+	// At least 70 pixels, the EHD upsamples smaller images and reads past its buffer
+	std::vector<cv::Mat> imgs, masks;
+	for(int i = 0; i < 16; i++) {
+		imgs.push_back(image(72 + i, 80, i));
+		masks.push_back(cv::Mat(imgs.back().rows, imgs.back().cols, CV_8UC1));
+		for(int y = 0; y < masks.back().rows; y++)
+			for(int x = 0; x < masks.back().cols; x++)
+				masks.back().ptr<uchar>(y)[x] = x + y < 100 + i ? 255 : 0;
+	}
+
+	ocv::ColorStructureDescriptor<float> csd(64);
+	ocv::ScalableColorDescriptor<float> scd(64);
+	ocv::ColorLayoutDescriptor<float> cld(6, 3);
+	ocv::EdgeHistogramDescriptor<float> ehd;
+	std::vector<const ocv::FeatureDescriptor<float>*> descs = {&csd, &scd, &cld, &ehd};
+
+	// Batches run in several threads, concurrent stripes must give the single results,
+	// also when a reused Frame switches between sizes and masks
+	int threads = cv::getNumThreads();
+	cv::setNumThreads(4);
+	for(const ocv::FeatureDescriptor<float>* desc : descs) {
+		for(int masked = 0; masked < 2; masked++) {
+			const std::vector<cv::Mat>& m = masked ? masks : std::vector<cv::Mat>();
+			cv::Mat_<float> ref = single(*desc, imgs, m);
+			for(int repeat = 0; repeat < 3; repeat++) {
+				cv::Mat_<float> batch;
+				desc->extractBatch(imgs, batch, m);
+				ASSERT_EQ(batch.rows, (int) imgs.size());
+				EXPECT_EQ(cv::norm(batch, ref), 0);
+			}
+		}
+	}
+	cv::setNumThreads(threads);
+
+}
+
+TEST_F(TestMPEG7Descriptors, imageContext) {
+
+	// Large enough for the texture descriptor, with a disc as shape
+	cv::Mat img = image(136, 144, 4);
+	cv::Mat mask(img.rows, img.cols, CV_8UC1);
+	for(int y = 0; y < mask.rows; y++)
+		for(int x = 0; x < mask.cols; x++)
+			mask.ptr<uchar>(y)[x] = (x - 70) * (x - 70) + (y - 60) * (y - 60) < 45 * 45 ? 255 : 0;
+
+	ocv::ColorLayoutDescriptor<float> cld(6, 3);
+	ocv::ColorStructureDescriptor<float> csd(64);
+	ocv::EdgeHistogramDescriptor<float> ehd;
+	ocv::HomogeneousTextureDescriptor<float> htd;
+	ocv::ScalableColorDescriptor<float> scd(64);
+	ocv::ContourShapeDescriptor<float> shape(10);
+	ocv::RegionShapeDescriptor<float> region;
+	std::vector<const ocv::FeatureDescriptor<float>*> descs = {&shape, &cld, &csd, &scd, &ehd, &region, &htd};
+
+	for(int masked = 0; masked < 2; masked++) {
+
+		cv::Mat m = masked ? mask : cv::Mat();
+		ocv::ImageContext ref_ctx(img, m);
+
+		// Each descriptor on its own
+		std::vector<cv::Mat_<float>> refs;
+		for(const ocv::FeatureDescriptor<float>* desc : descs) {
+			refs.push_back(cv::Mat_<float>(1, desc->size()));
+			desc->extract(desc == &htd ? ref_ctx.gray() : img, refs.back(), m);
+		}
+
+		// All descriptors share the Frame of one context, in both orders
+		for(int reverse = 0; reverse < 2; reverse++) {
+			ocv::ImageContext ctx(img, m);
+			for(size_t k = 0; k < descs.size(); k++) {
+				size_t d = reverse ? descs.size() - 1 - k : k;
+				cv::Mat_<float> vec(1, descs[d]->size());
+				descs[d]->extractContext(ctx, vec);
+				EXPECT_EQ(cv::norm(vec, refs[d]), 0) << "descriptor " << d << " masked " << masked << " reverse " << reverse;
+			}
+		}
+	}
+
+}
@@ -7,6 +7,13 @@
 #include "file_parser.h"
 #include "mat_algorithms_test.h"
 #include "mat_pair_algorithms_test.h"
+#include "growing_neural_gas_test.h"
+#include "cluster_indices_test.h"
+#include "genetic_algorithm_test.h"
+#include "feature_descriptor_test.h"
+#ifdef WITH_MPEG7
+#include "mpeg7_descriptors_test.h"
+#endif
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -1,4 +1,5 @@
 #include "oceancv/ml/vec_algorithms.h"
+#include "oceancv/ml/streaming_aggregation.h"
 
 class TestVecAlgorithms : public ::testing::Test {
 protected:
@@ -124,3 +125,46 @@ TEST_F(TestVecAlgorithms, VectorModifications) {
 	EXPECT_FLOAT_EQ(ret(ret.cols-1), 0);
 	
 }
+
+TEST_F(TestVecAlgorithms, StreamingAggregation) {
+	
+	// Up to k values everything is exact
+	ocv::StreamingAggregation<float> small;
+	small.add(vec);
+	EXPECT_EQ(small.count(), 4);
+	EXPECT_FLOAT_EQ(small.mean(), ocv::valg<float>::mean(vec));
+	EXPECT_FLOAT_EQ(small.stdDev(), ocv::valg<float>::deviation(vec, small.mean()));
+	EXPECT_FLOAT_EQ(small.variance(), std::pow(ocv::valg<float>::deviation(vec, small.mean()), 2));
+	EXPECT_FLOAT_EQ(small.median(), ocv::valg<float>::median(vec));
+	EXPECT_FLOAT_EQ(small.min(), 0);
+	EXPECT_FLOAT_EQ(small.max(), 3);
+	ocv::Aggregation<float> agg = small.aggregation(ocv::AggregationType::MEDIAN, ocv::DeviationType::STDDEV);
+	EXPECT_FLOAT_EQ(agg.val(), 2);
+	EXPECT_EQ(agg.num(), 4);
+	
+	// Shards of a shuffled sequence merge to the statistics of all values
+	const int n = 100000;
+	std::vector<double> values(n);
+	std::iota(values.begin(), values.end(), 0);
+	std::shuffle(values.begin(), values.end(), std::mt19937(1));
+	std::vector<ocv::StreamingAggregation<double>> shards;
+	for(int s = 0; s < 4; s++)
+		shards.push_back(ocv::StreamingAggregation<double>(200, s + 1));
+	for(int i = 0; i < n; i++)
+		shards[i % 4].add(values[i]);
+	for(int s = 1; s < 4; s++)
+		shards[0].merge(shards[s]);
+	
+	EXPECT_EQ(shards[0].count(), n);
+	EXPECT_NEAR(shards[0].mean(), (n - 1) / 2., 1e-6);
+	EXPECT_NEAR(shards[0].variance(), (1. * n * n - 1) / 12, 1e-3);
+	EXPECT_EQ(shards[0].max(), n - 1);
+	EXPECT_LT(shards[0].sketch().size(), 1000);
+	
+	// Rank errors of about one percent
+	EXPECT_NEAR(shards[0].median(), n / 2, 0.02 * n);
+	EXPECT_NEAR(shards[0].quantile(0.1), 0.1 * n, 0.02 * n);
+	EXPECT_NEAR(shards[0].quantile(0.99), 0.99 * n, 0.02 * n);
+	EXPECT_NEAR(shards[0].sketch().rank(0.75 * n), 0.75, 0.02);
+	
+}
@@ -3,7 +3,7 @@
 #include "opencv2/core.hpp"
 
 #include "oceancv/ml/aggregation.h"
-#include "oceancv/ml/vec_algorithms.h"
+#include "oceancv/ml/streaming_aggregation.h"
 
 namespace ocv {
 
@@ -33,19 +33,17 @@ public:
 
 		assert(laser_points.size() > 0);
 
-		float px_dist,mean;
-		std::vector<float> values = {};
+		float px_dist;
+		ocv::StreamingAggregation<float> values;
 		for(int i = 0; i < laser_points.size(); i++) {
 			for(int j = i+1; j < laser_points.size(); j++) {
 				px_dist = std::sqrt(std::pow(laser_points[i].x-laser_points[j].x,2)+std::pow(laser_points[i].y-laser_points[j].y,2));
 				if(px_dist > 0)
-					values.push_back(1.f * laser_distance_meters / px_dist);
+					values.add(1.f * laser_distance_meters / px_dist);
 			}
 		}
-		cv::Mat_<float> tmp(values);
 
-		mean = ocv::valg<float>::mean(tmp);
-		return ocv::Aggregation<float>(mean,ocv::valg<float>::deviation(tmp,mean),values.size(),ocv::AggregationType::MEAN,ocv::DeviationType::STDDEV);
+		return values.aggregation(ocv::AggregationType::MEAN,ocv::DeviationType::STDDEV);
 
 	}
 
@@ -67,7 +65,7 @@ public:
 			}
 		}
 
-		float tmp_d, mean;
+		float tmp_d;
 		if(laser_points.size() == 2) {
 			// One lp was not found, check whether it was the left one
 			tmp_d = cv::norm(laser_points[0]-laser_points[1]);
@@ -79,24 +77,19 @@ public:
 				return ocv::Aggregation<float>(laser_distance_meters_lr/tmp_d,0.f,1);
 			}
 		} else {
-			std::vector<float> values = {};
+			ocv::StreamingAggregation<float> values;
 			for(int i = 0; i < 3; i++) {
 				tmp_d = cv::norm(laser_points[i]-laser_points[(i+1)%3]);
 				if(tmp_d == 0)
 					continue;
 				if(laser_points[i] == left_lp || laser_points[(i+1)%3] == left_lp)
-					values.push_back(1.f * laser_distance_meters_lr / tmp_d);
+					values.add(1.f * laser_distance_meters_lr / tmp_d);
 				else
-					values.push_back(1.f * laser_distance_meters_rr / tmp_d);
+					values.add(1.f * laser_distance_meters_rr / tmp_d);
 			}
-			cv::Mat_<float> tmp(values);
 
-			mean = ocv::valg<float>::mean(tmp);
-			if(values.size() == 1) {
-				return(ocv::Aggregation<float>(mean,0.f,1,ocv::AggregationType::MEAN,ocv::DeviationType::STDDEV));
-			} else {
-				return ocv::Aggregation<float>(mean,ocv::valg<float>::deviation(tmp,mean),values.size(),ocv::AggregationType::MEAN,ocv::DeviationType::STDDEV);
-			}
+			// A single distance has no deviation
+			return values.aggregation(ocv::AggregationType::MEAN,ocv::DeviationType::STDDEV);
 		}
 
 	}